@@ -0,0 +1,280 @@
+﻿#ifndef __POCKET_BENCH_H__
+#define __POCKET_BENCH_H__
+
+#include "../pocket/config.h"
+#include "../pocket/cpu_feature.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#ifdef POCKET_USE_SIMD
+#	if POCKET_COMPILER_IF(VC)
+#		include <intrin.h>
+#	else
+#		include <x86intrin.h>
+#	endif
+#endif // POCKET_USE_SIMD
+
+//---------------------------------------------------------------------------------------
+// ベンチマーク用の簡易ハーネス
+// ウォームアップ後に指定回数計測し, 1回あたりの中央値と99パーセンタイル,
+// 1要素あたりのサイクル数とスループットを出力する
+//
+// int main(int argc, char** argv)
+// {
+//     bench::runner r(argc, argv);
+//     r.run("vector4 add", COUNT, [&]() { ... });
+//     return r.finish();
+// }
+//
+// 引数
+// --reps=N    計測回数(既定 31)
+// --warmup=N  ウォームアップ回数(既定 3)
+// それ以外    名前に含まれる文字列で絞り込み
+//---------------------------------------------------------------------------------------
+
+namespace bench
+{
+
+typedef std::chrono::steady_clock clock_type;
+
+// 最適化で消されないように結果を受け取る
+inline volatile char& sink()
+{
+	static volatile char s = 0;
+	return s;
+}
+template <typename T> inline
+void keep(const T& v)
+{
+	sink() = *reinterpret_cast<const volatile char*>(&v);
+}
+
+//---------------------------------------------------------------------
+// タイムスタンプカウンタ. 定格周波数で進むためターボ時は実クロックとずれる
+// SIMDが使用できない環境では読めないため0を返す(has_cyclesがfalse)
+//---------------------------------------------------------------------
+inline bool has_cycles()
+{
+#ifdef POCKET_USE_SIMD
+	return true;
+#else
+	return false;
+#endif // POCKET_USE_SIMD
+}
+inline unsigned long long cycles()
+{
+#ifdef POCKET_USE_SIMD
+	return __rdtsc();
+#else
+	return 0;
+#endif // POCKET_USE_SIMD
+}
+
+//---------------------------------------------------------------------
+// 一つの計測結果
+//---------------------------------------------------------------------
+struct result
+{
+	std::string name;
+	size_t items;
+	double median_ns; // 1回あたり
+	double p99_ns;
+	double cycles_per_item; // 読めない場合は負数
+	double items_per_second;
+};
+
+//---------------------------------------------------------------------
+// 計測と出力
+//---------------------------------------------------------------------
+class runner
+{
+private:
+	int _reps;
+	int _warmup;
+	std::vector<std::string> _filters;
+	std::vector<result> _results;
+	std::string _suffix;
+
+public:
+	runner(int argc, char** argv) :
+		_reps(31), _warmup(3)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strncmp(argv[i], "--reps=", 7) == 0)
+			{
+				_reps = std::max(1, std::atoi(argv[i] + 7));
+			}
+			else if (std::strncmp(argv[i], "--warmup=", 9) == 0)
+			{
+				_warmup = std::max(0, std::atoi(argv[i] + 9));
+			}
+			else
+			{
+				_filters.push_back(argv[i]);
+			}
+		}
+
+		std::cout << "-- compiled: " << compiled() << ", cpu: " << pocket::cpu_feature::get() <<
+			", reps: " << _reps << ", warmup: " << _warmup << std::endl;
+		std::cout << std::left << std::setw(40) << "name" << std::right <<
+			std::setw(12) << "median ns" <<
+			std::setw(12) << "p99 ns" <<
+			std::setw(12) << "cyc/elem" <<
+			std::setw(14) << "Melem/s" << std::endl;
+	}
+
+	//---------------------------------------------------------------------
+	// コンパイルした命令セットの名前
+	//---------------------------------------------------------------------
+	static const char* compiled()
+	{
+#ifdef POCKET_USE_SIMD_TYPE_STRING
+#	ifdef POCKET_USE_SIMD_FMA
+		return POCKET_USE_SIMD_TYPE_STRING "+FMA";
+#	else
+		return POCKET_USE_SIMD_TYPE_STRING;
+#	endif // POCKET_USE_SIMD_FMA
+#else
+		return "none";
+#endif // POCKET_USE_SIMD_TYPE_STRING
+	}
+
+	//---------------------------------------------------------------------
+	// コンパイルした命令セットをCPUが実行できるか
+	//---------------------------------------------------------------------
+	static bool supported()
+	{
+#ifdef POCKET_USE_SIMD_TYPE
+		return pocket::cpu_feature::get().has(POCKET_USE_SIMD_TYPE);
+#else
+		return true;
+#endif // POCKET_USE_SIMD_TYPE
+	}
+
+	//---------------------------------------------------------------------
+	// 名前の後ろに付加する文字列(実行時に切り替える処理の区別用)
+	//---------------------------------------------------------------------
+	void suffix(const std::string& s)
+	{
+		_suffix = s;
+	}
+
+	//---------------------------------------------------------------------
+	// 計測対象か
+	//---------------------------------------------------------------------
+	bool enabled(const std::string& name) const
+	{
+		if (_filters.empty())
+		{
+			return true;
+		}
+		for (size_t i = 0; i < _filters.size(); ++i)
+		{
+			if (name.find(_filters[i]) != std::string::npos)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//---------------------------------------------------------------------
+	// itemsはfunc一回で処理する要素数
+	// afterは計測の度に時間に含めずに呼ぶ(GPUの完了待ちなど)
+	//---------------------------------------------------------------------
+	template <typename F>
+	void run(const std::string& base, size_t items, F func)
+	{
+		run(base, items, func, &nothing);
+	}
+	template <typename F, typename G>
+	void run(const std::string& base, size_t items, F func, G after)
+	{
+		const std::string name = _suffix.empty() ? base : base + " [" + _suffix + "]";
+		if (!enabled(name))
+		{
+			return;
+		}
+
+		for (int i = 0; i < _warmup; ++i)
+		{
+			func();
+			after();
+		}
+
+		std::vector<double> ns(_reps);
+		std::vector<double> cyc(_reps);
+		for (int i = 0; i < _reps; ++i)
+		{
+			const unsigned long long c0 = cycles();
+			const clock_type::time_point t0 = clock_type::now();
+			func();
+			const clock_type::time_point t1 = clock_type::now();
+			const unsigned long long c1 = cycles();
+			after();
+			ns[i] = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+			cyc[i] = static_cast<double>(c1 - c0);
+		}
+		std::sort(ns.begin(), ns.end());
+		std::sort(cyc.begin(), cyc.end());
+
+		result r;
+		r.name = name;
+		r.items = items;
+		r.median_ns = percentile(ns, 50);
+		r.p99_ns = percentile(ns, 99);
+		r.cycles_per_item = has_cycles() ? percentile(cyc, 50) / static_cast<double>(items) : -1.0;
+		r.items_per_second = r.median_ns > 0.0 ? static_cast<double>(items) * 1.0e9 / r.median_ns : 0.0;
+		_results.push_back(r);
+
+		std::cout << std::left << std::setw(40) << r.name << std::right << std::fixed <<
+			std::setprecision(1) << std::setw(12) << r.median_ns <<
+			std::setprecision(1) << std::setw(12) << r.p99_ns;
+		if (r.cycles_per_item >= 0.0)
+		{
+			std::cout << std::setprecision(2) << std::setw(12) << r.cycles_per_item;
+		}
+		else
+		{
+			std::cout << std::setw(12) << "n/a";
+		}
+		std::cout << std::setprecision(2) << std::setw(14) << (r.items_per_second * 1.0e-6) << std::endl;
+	}
+
+	const std::vector<result>& results() const
+	{
+		return _results;
+	}
+
+	int finish() const
+	{
+		return 0;
+	}
+
+private:
+	static void nothing()
+	{}
+
+	// 昇順に並べた値から最近傍順位でパーセンタイルを求める
+	static double percentile(const std::vector<double>& sorted, int p)
+	{
+		if (sorted.empty())
+		{
+			return 0.0;
+		}
+		size_t rank = (sorted.size() * p + 99) / 100;
+		rank = rank > 0 ? rank - 1 : 0;
+		return sorted[std::min(rank, sorted.size() - 1)];
+	}
+};
+
+} // namespace bench
+
+#endif // __POCKET_BENCH_H__
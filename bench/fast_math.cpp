@@ -0,0 +1,200 @@
+﻿#include "bench.h"
+#include "../pocket/math/math_traits.h"
+#include "../pocket/math/simd_traits.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+
+// 近似計算(math_traits::fast_xxx, simd_traits::sin_cos, rsqrt_newton)と<cmath>との精度と速度の比較
+// $ rake bench[fast_math]
+
+namespace math = pocket::math;
+
+typedef math::math_traits<float> math_type;
+
+namespace
+{
+
+const int COUNT = 1 << 16;
+
+void print_error(const char* name, double err, const char* unit)
+{
+	std::cout << std::setw(16) << std::left << name << std::setw(14) << std::right << std::scientific << std::setprecision(3) << err << " " << unit << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	if (!bench::runner::supported())
+	{
+		std::cout << "-- skip: cpu does not support " << bench::runner::compiled() << std::endl;
+		return 0;
+	}
+
+	std::vector<float> deg(COUNT), unit(COUNT), positive(COUNT), y(COUNT), x(COUNT);
+	std::vector<float> out1(COUNT), out2(COUNT);
+	for (int i = 0; i < COUNT; ++i)
+	{
+		float t = static_cast<float>(i) / static_cast<float>(COUNT - 1);
+		deg[i] = -720.0f + 1440.0f * t;
+		unit[i] = -1.0f + 2.0f * t;
+		positive[i] = 1.0e-3f + 1.0e3f * t;
+		y[i] = std::sin(t * 97.0f) * 10.0f;
+		x[i] = std::cos(t * 89.0f) * 10.0f;
+	}
+
+	//---------------------------------------------------------------------
+	// 精度
+	//---------------------------------------------------------------------
+	double sin_err = 0.0, cos_err = 0.0, simd_err = 0.0, acos_err = 0.0, atan2_err = 0.0, rsqrt_err = 0.0, rsqrt_simd_err = 0.0;
+	for (int i = 0; i < COUNT; ++i)
+	{
+		double r = static_cast<double>(deg[i]) * 3.14159265358979323846 / 180.0;
+		float s, c;
+		math_type::fast_sin_cos(deg[i], s, c);
+		sin_err = std::max(sin_err, std::abs(s - std::sin(r)));
+		cos_err = std::max(cos_err, std::abs(c - std::cos(r)));
+
+		acos_err = std::max(acos_err, std::abs(math_type::fast_acos(unit[i]) - std::acos(static_cast<double>(unit[i])) * 180.0 / 3.14159265358979323846));
+		atan2_err = std::max(atan2_err, std::abs(math_type::fast_atan2(y[i], x[i]) - std::atan2(static_cast<double>(y[i]), static_cast<double>(x[i])) * 180.0 / 3.14159265358979323846));
+
+		double rs = 1.0 / std::sqrt(static_cast<double>(positive[i]));
+		rsqrt_err = std::max(rsqrt_err, std::abs(math_type::fast_rsqrt(positive[i]) - rs) / rs);
+	}
+#ifdef POCKET_USE_SIMD
+	typedef math::simd_traits<float> simd_type;
+	for (int i = 0; i < COUNT; i += 4)
+	{
+		POCKET_ALIGNED(16) float s[4];
+		POCKET_ALIGNED(16) float c[4];
+		POCKET_ALIGNED(16) float r[4];
+		simd_type::type ms, mc;
+		simd_type::sin_cos(simd_type::set(deg[i], deg[i + 1], deg[i + 2], deg[i + 3]), ms, mc);
+		simd_type::store(s, ms);
+		simd_type::store(c, mc);
+		simd_type::store(r, simd_type::rsqrt_newton(simd_type::set(positive[i], positive[i + 1], positive[i + 2], positive[i + 3])));
+		for (int j = 0; j < 4; ++j)
+		{
+			double rad = static_cast<double>(deg[i + j]) * 3.14159265358979323846 / 180.0;
+			simd_err = std::max(simd_err, std::abs(s[j] - std::sin(rad)));
+			simd_err = std::max(simd_err, std::abs(c[j] - std::cos(rad)));
+			double rs = 1.0 / std::sqrt(static_cast<double>(positive[i + j]));
+			rsqrt_simd_err = std::max(rsqrt_simd_err, std::abs(r[j] - rs) / rs);
+		}
+	}
+#endif // POCKET_USE_SIMD
+
+	std::cout << "-- max error" << std::endl;
+	print_error("sin", sin_err, "");
+	print_error("cos", cos_err, "");
+	print_error("sin_cos(simd)", simd_err, "");
+	print_error("acos", acos_err, "deg");
+	print_error("atan2", atan2_err, "deg");
+	print_error("rsqrt", rsqrt_err, "(relative)");
+	print_error("rsqrt(simd)", rsqrt_simd_err, "(relative)");
+
+	//---------------------------------------------------------------------
+	// 速度
+	//---------------------------------------------------------------------
+	std::cout << std::endl;
+	bench::runner r(argc, argv);
+
+	r.run("sin_cos <cmath>", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			float rad = deg[i] * math_type::deg2rad;
+			out1[i] = std::sin(rad);
+			out2[i] = std::cos(rad);
+		}
+		bench::keep(out1[COUNT / 2] + out2[COUNT / 2]);
+	});
+	r.run("sin_cos fast", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			math_type::fast_sin_cos(deg[i], out1[i], out2[i]);
+		}
+		bench::keep(out1[COUNT / 2] + out2[COUNT / 2]);
+	});
+#ifdef POCKET_USE_SIMD
+	r.run("sin_cos simd4", COUNT, [&]() {
+		for (int i = 0; i < COUNT; i += 4)
+		{
+			simd_type::type s, c;
+			simd_type::sin_cos(_mm_loadu_ps(&deg[i]), s, c);
+			_mm_storeu_ps(&out1[i], s);
+			_mm_storeu_ps(&out2[i], c);
+		}
+		bench::keep(out1[COUNT / 2] + out2[COUNT / 2]);
+	});
+#endif // POCKET_USE_SIMD
+#ifdef POCKET_USE_SIMD_256
+	r.run("sin_cos simd8", COUNT, [&]() {
+		for (int i = 0; i < COUNT; i += 8)
+		{
+			simd_type::type_up s, c;
+			simd_type::sin_cos(_mm256_loadu_ps(&deg[i]), s, c);
+			_mm256_storeu_ps(&out1[i], s);
+			_mm256_storeu_ps(&out2[i], c);
+		}
+		bench::keep(out1[COUNT / 2] + out2[COUNT / 2]);
+	});
+#endif // POCKET_USE_SIMD_256
+
+	r.run("acos <cmath>", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			out1[i] = std::acos(unit[i]) * math_type::rad2deg;
+		}
+		bench::keep(out1[COUNT / 2]);
+	});
+	r.run("acos fast", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			out1[i] = math_type::fast_acos(unit[i]);
+		}
+		bench::keep(out1[COUNT / 2]);
+	});
+
+	r.run("atan2 <cmath>", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			out1[i] = std::atan2(y[i], x[i]) * math_type::rad2deg;
+		}
+		bench::keep(out1[COUNT / 2]);
+	});
+	r.run("atan2 fast", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			out1[i] = math_type::fast_atan2(y[i], x[i]);
+		}
+		bench::keep(out1[COUNT / 2]);
+	});
+
+	r.run("rsqrt <cmath>", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			out1[i] = 1.0f / std::sqrt(positive[i]);
+		}
+		bench::keep(out1[COUNT / 2]);
+	});
+	r.run("rsqrt fast", COUNT, [&]() {
+		for (int i = 0; i < COUNT; ++i)
+		{
+			out1[i] = math_type::fast_rsqrt(positive[i]);
+		}
+		bench::keep(out1[COUNT / 2]);
+	});
+#ifdef POCKET_USE_SIMD
+	r.run("rsqrt simd4", COUNT, [&]() {
+		for (int i = 0; i < COUNT; i += 4)
+		{
+			_mm_storeu_ps(&out1[i], simd_type::rsqrt_newton(_mm_loadu_ps(&positive[i])));
+		}
+		bench::keep(out1[COUNT / 2]);
+	});
+#endif // POCKET_USE_SIMD
+
+	return r.finish();
+}
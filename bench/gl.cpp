@@ -0,0 +1,479 @@
+﻿#include "bench.h"
+// GLEWを使わずにシステムのGLから関数を直接リンクする
+#ifndef GL_GLEXT_PROTOTYPES
+#	define GL_GLEXT_PROTOTYPES 1
+#endif // GL_GLEXT_PROTOTYPES
+#include "../pocket/gl/all.h"
+#include "../pocket/math/all.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstdlib>
+#if defined(__linux__)
+#	include <dlfcn.h>
+#endif
+
+// GLラッパーのCPU側の発行コスト
+// ウィンドウを作らずにEGL(surfaceless, 無ければpbuffer)でコンテキストを作成するため
+// GPUの無い環境でもMesa(llvmpipe)で実行できる
+// $ rake bench[gl]
+// $ rake bench[gl,draw]
+//
+// 環境変数
+// POCKET_BENCH_GL_HARDWARE  設定するとドライバを選ばない(未設定時はLIBGL_ALWAYS_SOFTWARE=1)
+//
+// 計測するのはドライバへの発行までで, GPUの完了は時間に含めない
+// 一回の計測ごとにglFinish()を呼び, 溜まったコマンドが次の計測に影響しないようにする
+
+namespace gl = pocket::gl;
+namespace math = pocket::math;
+
+//---------------------------------------------------------------------
+// GL関数の呼び出し回数
+// POCKET_USE_GL_TRACEが定義されていればpocket::gl::traceの結果を使う
+// それ以外は実行ファイル側で同名の関数を定義して数えてから本来の関数を呼ぶ(Linuxのみ)
+//---------------------------------------------------------------------
+namespace
+{
+
+#ifndef POCKET_USE_GL_TRACE
+unsigned long long& hooked_calls()
+{
+	static unsigned long long calls = 0;
+	return calls;
+}
+#endif // POCKET_USE_GL_TRACE
+
+unsigned long long gl_calls()
+{
+#ifdef POCKET_USE_GL_TRACE
+	return gl::trace::total_calls();
+#else
+	return hooked_calls();
+#endif // POCKET_USE_GL_TRACE
+}
+
+}
+
+#if defined(POCKET_USE_GL_TRACE)
+#	define BENCH_GL_COUNTING
+#elif defined(__linux__) && defined(RTLD_NEXT)
+#	define BENCH_GL_COUNTING
+
+#define BENCH_GL_HOOK(RET, NAME, PARAMS, ARGS) \
+	extern "C" RET NAME PARAMS \
+	{ \
+		typedef RET (*function_type) PARAMS; \
+		static const function_type function = reinterpret_cast<function_type>(dlsym(RTLD_NEXT, #NAME)); \
+		++hooked_calls(); \
+		return function ARGS; \
+	}
+
+BENCH_GL_HOOK(void, glGenBuffers, (GLsizei n, GLuint* p), (n, p))
+BENCH_GL_HOOK(void, glDeleteBuffers, (GLsizei n, const GLuint* p), (n, p))
+BENCH_GL_HOOK(void, glBindBuffer, (GLenum t, GLuint b), (t, b))
+BENCH_GL_HOOK(void, glBindBufferBase, (GLenum t, GLuint i, GLuint b), (t, i, b))
+BENCH_GL_HOOK(GLboolean, glIsBuffer, (GLuint b), (b))
+BENCH_GL_HOOK(void, glBufferData, (GLenum t, GLsizeiptr s, const void* d, GLenum u), (t, s, d, u))
+BENCH_GL_HOOK(void, glBufferSubData, (GLenum t, GLintptr o, GLsizeiptr s, const void* d), (t, o, s, d))
+BENCH_GL_HOOK(void*, glMapBuffer, (GLenum t, GLenum a), (t, a))
+BENCH_GL_HOOK(GLboolean, glUnmapBuffer, (GLenum t), (t))
+BENCH_GL_HOOK(void, glGetBufferParameteriv, (GLenum t, GLenum n, GLint* p), (t, n, p))
+BENCH_GL_HOOK(void, glGenVertexArrays, (GLsizei n, GLuint* p), (n, p))
+BENCH_GL_HOOK(void, glDeleteVertexArrays, (GLsizei n, const GLuint* p), (n, p))
+BENCH_GL_HOOK(void, glBindVertexArray, (GLuint a), (a))
+BENCH_GL_HOOK(GLboolean, glIsVertexArray, (GLuint a), (a))
+BENCH_GL_HOOK(void, glEnableVertexAttribArray, (GLuint i), (i))
+BENCH_GL_HOOK(void, glVertexAttribPointer, (GLuint i, GLint s, GLenum t, GLboolean n, GLsizei st, const void* p), (i, s, t, n, st, p))
+BENCH_GL_HOOK(void, glUseProgram, (GLuint p), (p))
+BENCH_GL_HOOK(GLint, glGetUniformLocation, (GLuint p, const GLchar* n), (p, n))
+BENCH_GL_HOOK(void, glUniform1i, (GLint l, GLint v), (l, v))
+BENCH_GL_HOOK(void, glUniform1f, (GLint l, GLfloat v), (l, v))
+BENCH_GL_HOOK(void, glUniform4f, (GLint l, GLfloat x, GLfloat y, GLfloat z, GLfloat w), (l, x, y, z, w))
+BENCH_GL_HOOK(void, glUniformMatrix4fv, (GLint l, GLsizei c, GLboolean t, const GLfloat* v), (l, c, t, v))
+BENCH_GL_HOOK(void, glDrawArrays, (GLenum m, GLint f, GLsizei c), (m, f, c))
+BENCH_GL_HOOK(void, glDrawArraysIndirect, (GLenum m, const void* i), (m, i))
+BENCH_GL_HOOK(void, glDrawElements, (GLenum m, GLsizei c, GLenum t, const void* i), (m, c, t, i))
+BENCH_GL_HOOK(void, glGetIntegerv, (GLenum n, GLint* p), (n, p))
+BENCH_GL_HOOK(GLenum, glGetError, (), ())
+
+#undef BENCH_GL_HOOK
+#endif // defined(POCKET_USE_GL_TRACE)
+
+namespace
+{
+
+//---------------------------------------------------------------------
+// ウィンドウを持たないGLコンテキスト
+//---------------------------------------------------------------------
+class headless_context
+{
+private:
+	EGLDisplay _display;
+	EGLSurface _surface;
+	EGLContext _context;
+	GLuint _framebuffer;
+	GLuint _renderbuffer;
+
+public:
+	headless_context() :
+		_display(EGL_NO_DISPLAY),
+		_surface(EGL_NO_SURFACE),
+		_context(EGL_NO_CONTEXT),
+		_framebuffer(0),
+		_renderbuffer(0)
+	{}
+	~headless_context()
+	{
+		finalize();
+	}
+
+	bool initialize(int major, int minor)
+	{
+		// 描画先が無くても動くMesaのsurfacelessを優先
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+			reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+		if (get_platform_display != NULL)
+		{
+			_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+#endif // EGL_PLATFORM_SURFACELESS_MESA
+		if (_display == EGL_NO_DISPLAY)
+		{
+			_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+		if (_display == EGL_NO_DISPLAY ||
+			eglInitialize(_display, NULL, NULL) != EGL_TRUE ||
+			eglBindAPI(EGL_OPENGL_API) != EGL_TRUE)
+		{
+			std::cout << "-- eglInitialize() failed" << std::endl;
+			return false;
+		}
+
+		const EGLint config_attributes[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+		EGLConfig config = NULL;
+		EGLint config_count = 0;
+		eglChooseConfig(_display, config_attributes, &config, 1, &config_count);
+
+		const EGLint context_attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, major,
+			EGL_CONTEXT_MINOR_VERSION, minor,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		_context = eglCreateContext(_display, config, EGL_NO_CONTEXT, context_attributes);
+		if (_context == EGL_NO_CONTEXT)
+		{
+			std::cout << "-- eglCreateContext() failed: " << major << "." << minor << " core" << std::endl;
+			return false;
+		}
+
+		// surfacelessで駄目なら1x1のpbufferを作る
+		if (eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context) != EGL_TRUE)
+		{
+			const EGLint pbuffer_attributes[] = {
+				EGL_WIDTH, 1,
+				EGL_HEIGHT, 1,
+				EGL_NONE
+			};
+			if (config_count > 0)
+			{
+				_surface = eglCreatePbufferSurface(_display, config, pbuffer_attributes);
+			}
+			if (_surface == EGL_NO_SURFACE ||
+				eglMakeCurrent(_display, _surface, _surface, _context) != EGL_TRUE)
+			{
+				std::cout << "-- eglMakeCurrent() failed" << std::endl;
+				return false;
+			}
+		}
+
+		// 既定のフレームバッファが無い場合があるため描画先を用意
+		glGenRenderbuffers(1, &_renderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, _renderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 64, 64);
+		glGenFramebuffers(1, &_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _renderbuffer);
+		glViewport(0, 0, 64, 64);
+		return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	void finalize()
+	{
+		if (_context != EGL_NO_CONTEXT)
+		{
+			glDeleteFramebuffers(1, &_framebuffer);
+			glDeleteRenderbuffers(1, &_renderbuffer);
+			eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(_display, _context);
+			_context = EGL_NO_CONTEXT;
+		}
+		if (_surface != EGL_NO_SURFACE)
+		{
+			eglDestroySurface(_display, _surface);
+			_surface = EGL_NO_SURFACE;
+		}
+		if (_display != EGL_NO_DISPLAY)
+		{
+			eglTerminate(_display);
+			_display = EGL_NO_DISPLAY;
+		}
+	}
+};
+
+//---------------------------------------------------------------------
+// 1操作あたりのGL呼び出し回数も記録する
+//---------------------------------------------------------------------
+struct gl_result
+{
+	size_t index; // runner::results()の位置
+	double calls;
+};
+
+template <typename F>
+void run(bench::runner& r, std::vector<gl_result>& results, const char* name, size_t count, F func)
+{
+	if (!r.enabled(name))
+	{
+		return;
+	}
+
+	// 呼び出し回数は一回分だけ数える
+	const unsigned long long start = gl_calls();
+	func();
+	glFinish();
+	gl_result result;
+	result.calls = static_cast<double>(gl_calls() - start) / static_cast<double>(count);
+
+	r.run(name, count, func, &glFinish);
+	result.index = r.results().size() - 1;
+	results.push_back(result);
+
+	const GLenum error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		std::cout << "-- " << name << ": GL error 0x" << std::hex << error << std::dec << std::endl;
+	}
+}
+
+const size_t COUNT = 256;
+
+const char* const VERTEX_SHADER =
+	"#version 410\n"
+	"layout (location=0) in vec3 vertex_position;\n"
+	"layout (location=1) in vec4 vertex_color;\n"
+	"out vec4 color;\n"
+	"uniform mat4 world;\n"
+	"uniform ublock\n"
+	"{\n"
+	"	mat4 view_projection;\n"
+	"};\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = view_projection * (world * vec4(vertex_position, 1.0));\n"
+	"	color = vertex_color;\n"
+	"}\n";
+const char* const FRAGMENT_SHADER =
+	"#version 410\n"
+	"in vec4 color;\n"
+	"out vec4 frag_color;\n"
+	"uniform vec4 tint;\n"
+	"void main()\n"
+	"{\n"
+	"	frag_color = color * tint;\n"
+	"}\n";
+
+struct simple_vertex_t
+{
+	math::vector3f position;
+	math::colorf color;
+};
+
+}
+
+int main(int argc, char** argv)
+{
+	// GPUの有無で結果が変わらないように既定ではソフトウェア実装を使う
+	if (std::getenv("POCKET_BENCH_GL_HARDWARE") == NULL)
+	{
+		setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+	}
+
+	headless_context context;
+	if (!context.initialize(4, 1))
+	{
+		std::cout << "-- skip: headless GL 4.1 core context is not available" << std::endl;
+		return 0;
+	}
+	std::cout << "-- renderer: " << glGetString(GL_RENDERER) << ", version: " << glGetString(GL_VERSION) << std::endl;
+
+	bench::runner r(argc, argv);
+	std::vector<gl_result> results;
+
+	// 共通で使うオブジェクト
+	gl::shader vert(gl::shader_type::vertex, VERTEX_SHADER, gl::shader::string);
+	gl::shader frag(gl::shader_type::fragment, FRAGMENT_SHADER, gl::shader::string);
+	gl::program prog(vert, frag);
+	if (!prog)
+	{
+		std::cout << prog << std::endl;
+		return EXIT_FAILURE;
+	}
+	const math::matrix4x4f view_projection(pocket::call::perspective_field_of_view, 60.0f, 1.0f, 0.1f, 100.0f);
+	gl::uniform_buffer ubo = prog.make_uniform_buffer("ublock", 0, view_projection);
+
+	const gl::vertex_layout layouts[] = {
+		POCKET_LAYOUT_OFFSETOF(float, 3, false, simple_vertex_t, position),
+		POCKET_LAYOUT_OFFSETOF(float, 4, false, simple_vertex_t, color),
+	};
+	const simple_vertex_t vertices[] = {
+		{ math::vector3f(0.0f, 0.5f, 0.1f), math::colorf::red },
+		{ math::vector3f(-0.5f, -0.5f, 0.1f), math::colorf::blue },
+		{ math::vector3f(0.5f, -0.5f, 0.1f), math::colorf::green },
+	};
+	gl::layered_vertex_buffer<simple_vertex_t> lvb(vertices, layouts);
+	gl::draw_indirect_buffer dib(gl::command_type::arrays, POCKET_ARRAY_SIZE(vertices));
+	gl::buffer vbo(gl::buffer_type::array, gl::buffer_usage_type::dynamic_draw, vertices);
+	if (!ubo || !lvb || !dib || !vbo)
+	{
+		std::cout << "-- failed to create objects" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<char> upload(4096, 1);
+	std::vector<math::matrix4x4f> worlds(COUNT);
+	for (size_t i = 0; i < COUNT; ++i)
+	{
+		worlds[i].load_translate(math::vector3f(static_cast<float>(i) * 0.001f, 0.0f, 0.0f));
+	}
+	const GLint world_location = prog.uniform_location("world");
+	const GLint tint_location = prog.uniform_location("tint");
+
+	//---------------------------------------------------------------------
+	// buffer
+	//---------------------------------------------------------------------
+	run(r, results, "buffer create+upload 4KB static", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			gl::buffer b(gl::buffer_type::array, gl::buffer_usage_type::static_draw, upload);
+			bench::keep(b.get());
+		}
+	});
+	run(r, results, "buffer create+upload 4KB dynamic", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			gl::buffer b(gl::buffer_type::array, gl::buffer_usage_type::dynamic_draw, upload);
+			bench::keep(b.get());
+		}
+	});
+	run(r, results, "buffer map/unmap", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			simple_vertex_t* p = vbo.map<simple_vertex_t>(gl::buffer_map_type::write);
+			p[0] = vertices[i % POCKET_ARRAY_SIZE(vertices)];
+			vbo.unmap();
+		}
+	});
+
+	//---------------------------------------------------------------------
+	// vertex_array
+	//---------------------------------------------------------------------
+	run(r, results, "vertex_array setup", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			gl::vertex_array va(vbo, sizeof(simple_vertex_t), layouts);
+			bench::keep(va.get());
+		}
+	});
+	run(r, results, "vertex_array bind/unbind", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			lvb.bind();
+			lvb.unbind();
+		}
+	});
+
+	//---------------------------------------------------------------------
+	// uniform
+	//---------------------------------------------------------------------
+	prog.bind();
+	run(r, results, "program uniform mat4 (location)", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			prog.uniform(world_location, worlds[i]);
+		}
+	});
+	run(r, results, "program uniform mat4 (name)", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			prog.uniform("world", worlds[i]);
+		}
+	});
+	run(r, results, "program uniform vec4 (location)", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			prog.uniform(tint_location, math::colorf::white);
+		}
+	});
+	run(r, results, "uniform_buffer uniform mat4", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			ubo.uniform(0, worlds[i]);
+		}
+	});
+
+	//---------------------------------------------------------------------
+	// draw
+	//---------------------------------------------------------------------
+	ubo.bind();
+	prog.uniform(tint_location, math::colorf::white);
+	lvb.bind();
+	run(r, results, "draw arrays", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			lvb.draw(gl::draw_type::triangles);
+		}
+	});
+	run(r, results, "draw arrays + uniform mat4", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			prog.uniform(world_location, worlds[i]);
+			lvb.draw(gl::draw_type::triangles);
+		}
+	});
+	dib.bind();
+	run(r, results, "draw arrays indirect", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			lvb.draw(gl::draw_type::triangles, dib);
+		}
+	});
+	dib.unbind();
+	lvb.unbind();
+	prog.unbind();
+
+	//---------------------------------------------------------------------
+	// 1操作あたり
+	//---------------------------------------------------------------------
+	std::cout << std::endl << std::left << std::setw(40) << "name" << std::right <<
+		std::setw(12) << "ns/op" <<
+		std::setw(12) << "GL calls/op" << std::endl;
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const bench::result& result = r.results()[results[i].index];
+		std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed <<
+			std::setprecision(1) << std::setw(12) << (result.median_ns / static_cast<double>(result.items));
+#ifdef BENCH_GL_COUNTING
+		std::cout << std::setprecision(2) << std::setw(12) << results[i].calls << std::endl;
+#else
+		std::cout << std::setw(12) << "-" << std::endl;
+#endif // BENCH_GL_COUNTING
+	}
+
+	return r.finish();
+}
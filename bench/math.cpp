@@ -0,0 +1,265 @@
+﻿#include "bench.h"
+#include "../pocket/math/all.h"
+#include <vector>
+
+// 数学ライブラリの処理速度
+// $ rake bench
+// $ rake bench[math,matrix4x4]
+
+namespace math = pocket::math;
+
+namespace
+{
+
+const size_t COUNT = 4096;
+
+float random_float(unsigned int& seed, float lo, float hi)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return lo + (hi - lo) * static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	if (!bench::runner::supported())
+	{
+		std::cout << "-- skip: cpu does not support " << bench::runner::compiled() << std::endl;
+		return 0;
+	}
+	bench::runner r(argc, argv);
+
+	unsigned int seed = 1;
+	std::vector<math::vector3f> v3a(COUNT), v3b(COUNT), v3r(COUNT);
+	std::vector<math::vector4f> v4a(COUNT), v4b(COUNT), v4r(COUNT);
+	std::vector<math::matrix4x4f> ma(COUNT), mr(COUNT);
+	std::vector<math::quaternionf> qa(COUNT), qb(COUNT), qr(COUNT);
+	std::vector<float> xs(COUNT), ys(COUNT), zs(COUNT), ws(COUNT), fs(COUNT), out(COUNT);
+	std::vector<unsigned char> visible(COUNT);
+	for (size_t i = 0; i < COUNT; ++i)
+	{
+		v3a[i] = math::vector3f(random_float(seed, -10.0f, 10.0f), random_float(seed, -10.0f, 10.0f), random_float(seed, -10.0f, 10.0f));
+		v3b[i] = math::vector3f(random_float(seed, -10.0f, 10.0f), random_float(seed, -10.0f, 10.0f), random_float(seed, -10.0f, 10.0f));
+		v4a[i] = math::vector4f(v3a[i], 1.0f);
+		v4b[i] = math::vector4f(v3b[i], 0.0f);
+		ma[i] = math::matrix4x4f(pocket::call::look_at, v3a[i], v3b[i], math::vector3f::up);
+		qa[i] = math::quaternionf(math::vector3f(v3a[i]).normalize(), random_float(seed, 0.0f, 360.0f));
+		qb[i] = math::quaternionf(math::vector3f(v3b[i]).normalize(), random_float(seed, 0.0f, 360.0f));
+		xs[i] = v3a[i].x;
+		ys[i] = v3a[i].y;
+		zs[i] = v3a[i].z;
+		ws[i] = random_float(seed, 0.1f, 2.0f);
+		fs[i] = random_float(seed, 0.0f, 1.0f);
+	}
+	const math::matrix4x4f view(pocket::call::look_at, math::vector3f(0.0f, 2.0f, -15.0f), math::vector3f::zero, math::vector3f::up);
+	const math::matrix4x4f projection(pocket::call::perspective_field_of_view, 60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+	const math::matrix4x4f view_projection = view * projection;
+	const math::frustumf frustum(view_projection);
+
+	//---------------------------------------------------------------------
+	// vector3
+	//---------------------------------------------------------------------
+	r.run("vector3 add", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			v3r[i] = v3a[i] + v3b[i];
+		}
+		bench::keep(v3r[COUNT / 2]);
+	});
+	r.run("vector3 dot", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			out[i] = v3a[i].dot(v3b[i]);
+		}
+		bench::keep(out[COUNT / 2]);
+	});
+	r.run("vector3 cross", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			v3r[i] = v3a[i].cross(v3b[i]);
+		}
+		bench::keep(v3r[COUNT / 2]);
+	});
+	r.run("vector3 normalize", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			v3a[i].normalize(v3r[i]);
+		}
+		bench::keep(v3r[COUNT / 2]);
+	});
+
+	//---------------------------------------------------------------------
+	// vector4
+	//---------------------------------------------------------------------
+	r.run("vector4 add", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			v4r[i] = v4a[i] + v4b[i];
+		}
+		bench::keep(v4r[COUNT / 2]);
+	});
+	r.run("vector4 mul scalar", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			v4r[i] = v4a[i] * fs[i];
+		}
+		bench::keep(v4r[COUNT / 2]);
+	});
+	r.run("vector4 dot", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			out[i] = v4a[i].dot(v4b[i]);
+		}
+		bench::keep(out[COUNT / 2]);
+	});
+	r.run("vector4 normalize", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			v4a[i].normalize(v4r[i]);
+		}
+		bench::keep(v4r[COUNT / 2]);
+	});
+
+	//---------------------------------------------------------------------
+	// matrix4x4
+	//---------------------------------------------------------------------
+	r.run("matrix4x4 multiply", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			ma[i].multiply(view_projection, mr[i]);
+		}
+		bench::keep(mr[COUNT / 2]);
+	});
+	r.run("matrix4x4 inverse", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			ma[i].inverse(mr[i]);
+		}
+		bench::keep(mr[COUNT / 2]);
+	});
+	r.run("matrix4x4 transform", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			view_projection.transform(v4a[i], v4r[i]);
+		}
+		bench::keep(v4r[COUNT / 2]);
+	});
+
+	//---------------------------------------------------------------------
+	// quaternion
+	//---------------------------------------------------------------------
+	r.run("quaternion slerp", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			qa[i].slerp(qb[i], fs[i], qr[i]);
+		}
+		bench::keep(qr[COUNT / 2]);
+	});
+
+	//---------------------------------------------------------------------
+	// frustum
+	//---------------------------------------------------------------------
+	r.run("frustum inside_point", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			visible[i] = frustum.inside_point(v3a[i]) ? 1 : 0;
+		}
+		bench::keep(visible[COUNT / 2]);
+	});
+	r.run("frustum inside_sphere", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			visible[i] = frustum.inside_sphere(v3a[i], ws[i]) ? 1 : 0;
+		}
+		bench::keep(visible[COUNT / 2]);
+	});
+
+	//---------------------------------------------------------------------
+	// simd_traits
+	//---------------------------------------------------------------------
+	typedef math::simd_traits<float> simd;
+	static simd::type sa[COUNT], sb[COUNT], sr[COUNT];
+	for (size_t i = 0; i < COUNT; ++i)
+	{
+		sa[i] = simd::set(xs[i], ys[i], zs[i], ws[i]);
+		sb[i] = simd::set(ws[i], zs[i], ys[i], xs[i]);
+	}
+	r.run("simd_traits add", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			sr[i] = simd::add(sa[i], sb[i]);
+		}
+		bench::keep(sr[COUNT / 2]);
+	});
+	r.run("simd_traits mad", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			sr[i] = simd::mad(sa[i], sb[i], sr[i]);
+		}
+		bench::keep(sr[COUNT / 2]);
+	});
+	r.run("simd_traits dot", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			sr[i] = simd::dot(sa[i], sb[i]);
+		}
+		bench::keep(sr[COUNT / 2]);
+	});
+	r.run("simd_traits sqrt", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			sr[i] = simd::sqrt(sb[i]);
+		}
+		bench::keep(sr[COUNT / 2]);
+	});
+	r.run("simd_traits normalize", COUNT, [&]() {
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			sr[i] = simd::normalize(sa[i]);
+		}
+		bench::keep(sr[COUNT / 2]);
+	});
+
+	//---------------------------------------------------------------------
+	// batch_traits(実行時に選択できる命令セットごと)
+	//---------------------------------------------------------------------
+	const int types[] = {
+		-1, POCKET_SIMD_TYPE_SSE2, POCKET_SIMD_TYPE_AVX2, POCKET_SIMD_TYPE_AVX512
+	};
+	int previous = -2;
+	for (size_t t = 0; t < POCKET_ARRAY_SIZE(types); ++t)
+	{
+		const int selected = math::batch_traitsf::select(types[t]);
+		// CPUやコンパイル設定で上限に達した
+		if (selected == previous)
+		{
+			continue;
+		}
+		previous = selected;
+		r.suffix(pocket::cpu_feature::name(selected));
+
+		r.run("batch transform", COUNT, [&]() {
+			math::batch_traitsf::transform(view_projection, &v4a[0], &v4r[0], COUNT);
+			bench::keep(v4r[COUNT / 2]);
+		});
+		r.run("batch mad", COUNT, [&]() {
+			math::batch_traitsf::mad(&xs[0], &ys[0], &zs[0], &out[0], COUNT);
+			bench::keep(out[COUNT / 2]);
+		});
+		r.run("batch dot", COUNT, [&]() {
+			math::batch_traitsf::dot(&xs[0], &ys[0], &zs[0], &zs[0], &ys[0], &xs[0], &out[0], COUNT);
+			bench::keep(out[COUNT / 2]);
+		});
+		r.run("batch length", COUNT, [&]() {
+			math::batch_traitsf::length(&xs[0], &ys[0], &zs[0], &out[0], COUNT);
+			bench::keep(out[COUNT / 2]);
+		});
+		r.run("batch cull_spheres", COUNT, [&]() {
+			bench::keep(math::batch_traitsf::cull_spheres(frustum, &xs[0], &ys[0], &zs[0], &ws[0], &visible[0], COUNT));
+		});
+	}
+	r.suffix("");
+
+	return r.finish();
+}
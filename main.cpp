@@ -60,6 +60,15 @@ struct ublock_t
 	math::matrix4x4f lookat;
 	math::matrix4x4f perspective;
 };
+// シェーダー側のublock(std140)の配置
+typedef gl::block_layout_begin<gl::block_layout_type::std140> ublock_begin;
+typedef gl::block_member<ublock_begin, math::matrix4x4f> ublock_world;
+typedef gl::block_member<ublock_world, math::matrix4x4f> ublock_lookat;
+typedef gl::block_member<ublock_lookat, math::matrix4x4f> ublock_perspective;
+typedef gl::block_layout_end<ublock_perspective> ublock_layout;
+POCKET_BLOCK_STATICAL_ASSERT(ublock_t, world, ublock_world);
+POCKET_BLOCK_STATICAL_ASSERT(ublock_t, lookat, ublock_lookat);
+POCKET_BLOCK_STATICAL_ASSERT(ublock_t, perspective, ublock_perspective);
 
 #ifdef __MAIN_TEST
 
@@ -208,6 +217,18 @@ int main()
 	POCKET_GL_ERROR();
 	std::cout << ubo << std::endl;
 
+	// ublock_tとシェーダー側の配置の照合
+	gl::block_validator ublock_validator(prog, "ublock");
+	ublock_validator.check<ublock_world>("world");
+	ublock_validator.check<ublock_lookat>("lookat");
+	ublock_validator.check<ublock_perspective>("perspective");
+	ublock_validator.check_size<ublock_layout>();
+	if (!ublock_validator)
+	{
+		std::cout << ublock_validator << std::endl;
+		return EXIT_FAILURE;
+	}
+
 	// レイアウトを指定した頂点バッファを作成
 	const gl::vertex_layout layouts[] = {
 		POCKET_LAYOUT_OFFSETOF(float, 3, false, simple_vertex_t, position),
@@ -345,6 +345,18 @@
 #	endif // POCKET_USE_CXX11
 #endif // POCKET_CXX11_MOVE
 
+//---------------------------------------------------------------------------------------
+// C++11が使用できる場合は例外を投げないことを示す(VC++12は未対応)
+// ムーブコンストラクタに付けるとstd::vectorの再確保でコピーの代わりにムーブが使用される
+//---------------------------------------------------------------------------------------
+#ifndef POCKET_CXX11_NOEXCEPT
+#	if defined(POCKET_USE_CXX11) && !(POCKET_COMPILER_IF(VC) && !POCKET_VCXX_HAS_VERSION(14))
+#		define POCKET_CXX11_NOEXCEPT noexcept
+#	else
+#		define POCKET_CXX11_NOEXCEPT
+#	endif // POCKET_USE_CXX11
+#endif // POCKET_CXX11_NOEXCEPT
+
 //---------------------------------------------------------------------------------------
 // constexprが使用できるか
 //---------------------------------------------------------------------------------------
@@ -394,6 +406,30 @@
 #	define POCKET_STATICAL_CONSTANT static POCKET_CONST_OR_CONSTEXPR
 #endif // POCKET_STATICAL_CONSTANT
 
+//---------------------------------------------------------------------------------------
+// 数学クラスをコンパイル時に構築できるか
+// C++14のconstexprと無名共用体メンバーの直接初期化が必要. 無効にするにはPOCKET_NO_USING_MATH_CONSTEXPRを定義する
+//---------------------------------------------------------------------------------------
+#ifndef POCKET_USE_MATH_CONSTEXPR
+#	if defined(POCKET_USE_CXX14) && defined(POCKET_USE_ANONYMOUS_NON_POD) && defined(POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT) && !defined(POCKET_NO_USING_MATH_CONSTEXPR)
+#		define POCKET_USE_MATH_CONSTEXPR
+#	endif
+#endif // POCKET_USE_MATH_CONSTEXPR
+#ifndef POCKET_MATH_CONSTEXPR
+#	ifdef POCKET_USE_MATH_CONSTEXPR
+#		define POCKET_MATH_CONSTEXPR constexpr
+#	else
+#		define POCKET_MATH_CONSTEXPR
+#	endif // POCKET_USE_MATH_CONSTEXPR
+#endif // POCKET_MATH_CONSTEXPR
+#ifndef POCKET_MATH_CONST_OR_CONSTEXPR
+#	ifdef POCKET_USE_MATH_CONSTEXPR
+#		define POCKET_MATH_CONST_OR_CONSTEXPR constexpr
+#	else
+#		define POCKET_MATH_CONST_OR_CONSTEXPR const
+#	endif // POCKET_USE_MATH_CONSTEXPR
+#endif // POCKET_MATH_CONST_OR_CONSTEXPR
+
 //---------------------------------------------------------------------------------------
 // 構造体メンバーへのオフセット
 //---------------------------------------------------------------------------------------
@@ -614,6 +650,9 @@
 #ifndef POCKET_SIMD_TYPE_AVX2
 #	define POCKET_SIMD_TYPE_AVX2 (7)
 #endif // POCKET_SIMD_TYPE_AVX2
+#ifndef POCKET_SIMD_TYPE_AVX512
+#	define POCKET_SIMD_TYPE_AVX512 (8)
+#endif // POCKET_SIMD_TYPE_AVX512
 
 //---------------------------------------------------------------------------------------
 // SIMD設定
@@ -621,7 +660,9 @@
 #if !defined(POCKET_USE_SIMD) && !defined(POCKET_USE_SIMD_TYPE) && !defined(POCKET_UNUSING_SIMD)
 #	if defined(__AVX2__) || defined(__AVX__) // AVXは共通処理
 #		define POCKET_USE_SIMD
-#		ifdef __AVX2__
+#		if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512VL__)
+#			define POCKET_USE_SIMD_TYPE POCKET_SIMD_TYPE_AVX512
+#		elif defined(__AVX2__)
 #			define POCKET_USE_SIMD_TYPE POCKET_SIMD_TYPE_AVX2
 #		else
 #			define POCKET_USE_SIMD_TYPE POCKET_SIMD_TYPE_AVX
@@ -695,7 +736,9 @@
 // SIMDのタイプを文字列定義
 //---------------------------------------------------------------------------------------
 #if !defined(POCKET_USE_SIMD_TYPE_STRING) && defined(POCKET_USE_SIMD)
-#	if POCKET_USE_SIMD_TYPE == POCKET_SIMD_TYPE_AVX2
+#	if POCKET_USE_SIMD_TYPE == POCKET_SIMD_TYPE_AVX512
+#		define POCKET_USE_SIMD_TYPE_STRING "AVX512"
+#	elif POCKET_USE_SIMD_TYPE == POCKET_SIMD_TYPE_AVX2
 #		define POCKET_USE_SIMD_TYPE_STRING "AVX2"
 #	elif POCKET_USE_SIMD_TYPE == POCKET_SIMD_TYPE_AVX
 #		define POCKET_USE_SIMD_TYPE_STRING "AVX"
@@ -714,6 +757,36 @@
 #	endif
 #endif // POCKET_USE_SIMD_TYPE_STRING
 
+//---------------------------------------------------------------------------------------
+// FMA(積和演算)命令が使用できるか
+//---------------------------------------------------------------------------------------
+#if !defined(POCKET_USE_SIMD_FMA) && defined(POCKET_USE_SIMD) && !defined(POCKET_NO_USING_SIMD_FMA)
+#	if defined(__FMA__) || (POCKET_COMPILER_IF(VC) && defined(__AVX2__))
+#		define POCKET_USE_SIMD_FMA
+#	endif
+#endif // POCKET_USE_SIMD_FMA
+
+//---------------------------------------------------------------------------------------
+// 実行時にCPUを判定してSIMD命令を切り替えるか. 無効にするにはPOCKET_NO_USING_SIMD_DISPATCHを定義する
+// clangは__GNUC__も定義するためPOCKET_COMPILERはGCC(4.2)になる. __clang__で判定する
+//---------------------------------------------------------------------------------------
+#if !defined(POCKET_USE_SIMD_DISPATCH) && defined(POCKET_USE_SIMD_128) && !defined(POCKET_NO_USING_SIMD_DISPATCH)
+#	if POCKET_COMPILER_IF(VC) || defined(__clang__) || POCKET_COMPILER_IF_WITH_HAS_VERSION(GCC, 4, 9)
+#		define POCKET_USE_SIMD_DISPATCH
+#	endif
+#endif // POCKET_USE_SIMD_DISPATCH
+
+//---------------------------------------------------------------------------------------
+// 関数単位で命令セットを指定する(VCは指定なしで使用できる)
+//---------------------------------------------------------------------------------------
+#ifndef POCKET_SIMD_TARGET
+#	if POCKET_COMPILER_IF(GCC) || defined(__clang__)
+#		define POCKET_SIMD_TARGET(ISA) __attribute__((target(ISA)))
+#	else
+#		define POCKET_SIMD_TARGET(ISA)
+#	endif
+#endif // POCKET_SIMD_TARGET
+
 //---------------------------------------------------------------------------------------
 // テンプレートクラスの暗黙定義を抑制するための設定. 使用するにはPOCKET_USING_MATH_EXTERN_TYPEを定義する
 //---------------------------------------------------------------------------------------
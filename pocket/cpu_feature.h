@@ -0,0 +1,241 @@
+﻿#ifndef __POCKET_CPU_FEATURE_H__
+#define __POCKET_CPU_FEATURE_H__
+
+#include "config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "io.h"
+#ifdef POCKET_USE_SIMD
+#	if POCKET_COMPILER_IF(VC)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif // POCKET_USE_SIMD
+
+namespace pocket
+{
+
+//---------------------------------------------------------------------------------------
+// 実行中のCPUが対応している命令セット
+// コンパイル時のPOCKET_USE_SIMD_TYPEとは関係なくCPUIDで判定する
+//---------------------------------------------------------------------------------------
+struct cpu_feature
+{
+	//---------------------------------------------------------------------------------------
+	// Types
+	//---------------------------------------------------------------------------------------
+
+	// none
+
+	//---------------------------------------------------------------------------------------
+	// Members
+	//---------------------------------------------------------------------------------------
+
+	bool sse2;
+	bool sse3;
+	bool ssse3;
+	bool sse4_1;
+	bool sse4_2;
+	bool avx;
+	bool avx2;
+	bool fma;
+	bool avx512f;
+	bool avx512dq;
+	bool avx512vl;
+
+	// 使用できる最も上位のPOCKET_SIMD_TYPE_XXX, SIMDが使用できない場合は-1
+	int simd_type;
+
+	//---------------------------------------------------------------------------------------
+	// Constants
+	//---------------------------------------------------------------------------------------
+
+	// none
+
+	//---------------------------------------------------------------------------------------
+	// Constructors
+	//---------------------------------------------------------------------------------------
+
+	cpu_feature() :
+		sse2(false), sse3(false), ssse3(false), sse4_1(false), sse4_2(false),
+		avx(false), avx2(false), fma(false),
+		avx512f(false), avx512dq(false), avx512vl(false),
+		simd_type(-1)
+	{
+		detect();
+	}
+
+	//---------------------------------------------------------------------------------------
+	// Functions
+	//---------------------------------------------------------------------------------------
+
+	//---------------------------------------------------------------------
+	// 一度だけ判定した結果を返す
+	//---------------------------------------------------------------------
+	static const cpu_feature& get()
+	{
+		static const cpu_feature feature;
+		return feature;
+	}
+
+	//---------------------------------------------------------------------
+	// 指定のPOCKET_SIMD_TYPE_XXXが使用できるか
+	//---------------------------------------------------------------------
+	bool has(int type) const
+	{
+		return type <= simd_type;
+	}
+
+	//---------------------------------------------------------------------
+	// POCKET_SIMD_TYPE_XXXの名前
+	//---------------------------------------------------------------------
+	static const char* name(int type)
+	{
+		switch (type)
+		{
+		case POCKET_SIMD_TYPE_SSE:
+			return "SSE";
+		case POCKET_SIMD_TYPE_SSE2:
+			return "SSE2";
+		case POCKET_SIMD_TYPE_SSE3:
+			return "SSE3";
+		case POCKET_SIMD_TYPE_SSE4:
+			return "SSE4";
+		case POCKET_SIMD_TYPE_SSE4_1:
+			return "SSE4.1";
+		case POCKET_SIMD_TYPE_SSE4_2:
+			return "SSE4.2";
+		case POCKET_SIMD_TYPE_AVX:
+			return "AVX";
+		case POCKET_SIMD_TYPE_AVX2:
+			return "AVX2";
+		case POCKET_SIMD_TYPE_AVX512:
+			return "AVX512";
+		default:
+			break;
+		}
+		return "none";
+	}
+
+private:
+#ifdef POCKET_USE_SIMD
+	static void cpuid(int leaf, int sub, unsigned int (&reg)[4])
+	{
+#	if POCKET_COMPILER_IF(VC)
+		int r[4];
+		__cpuidex(r, leaf, sub);
+		for (int i = 0; i < 4; ++i)
+		{
+			reg[i] = static_cast<unsigned int>(r[i]);
+		}
+#	else
+		__cpuid_count(leaf, sub, reg[0], reg[1], reg[2], reg[3]);
+#	endif
+	}
+	static int cpuid_max()
+	{
+#	if POCKET_COMPILER_IF(VC)
+		int r[4];
+		__cpuid(r, 0);
+		return r[0];
+#	else
+		return static_cast<int>(__get_cpuid_max(0, NULL));
+#	endif
+	}
+	// OSが保存するレジスタの状態(XCR0)
+	static unsigned long long xgetbv()
+	{
+#	if POCKET_COMPILER_IF(VC)
+		return _xgetbv(0);
+#	else
+		unsigned int eax, edx;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#	endif
+	}
+#endif // POCKET_USE_SIMD
+
+	void detect()
+	{
+#ifdef POCKET_USE_SIMD
+		const int max = cpuid_max();
+		if (max < 1)
+		{
+			return;
+		}
+
+		unsigned int reg[4]; // eax, ebx, ecx, edx
+		cpuid(1, 0, reg);
+		sse2 = (reg[3] & (1u << 26)) != 0;
+		sse3 = (reg[2] & (1u << 0)) != 0;
+		ssse3 = (reg[2] & (1u << 9)) != 0;
+		sse4_1 = (reg[2] & (1u << 19)) != 0;
+		sse4_2 = (reg[2] & (1u << 20)) != 0;
+
+		// AVX以降はOSがYMM, ZMMレジスタを保存している必要がある
+		const bool osxsave = (reg[2] & (1u << 27)) != 0;
+		const unsigned long long xcr0 = osxsave ? xgetbv() : 0;
+		const bool os_ymm = (xcr0 & 0x06) == 0x06;
+		const bool os_zmm = (xcr0 & 0xE6) == 0xE6;
+
+		avx = os_ymm && (reg[2] & (1u << 28)) != 0;
+		fma = avx && (reg[2] & (1u << 12)) != 0;
+
+		if (max >= 7)
+		{
+			cpuid(7, 0, reg);
+			avx2 = avx && (reg[1] & (1u << 5)) != 0;
+			avx512f = os_zmm && (reg[1] & (1u << 16)) != 0;
+			avx512dq = avx512f && (reg[1] & (1u << 17)) != 0;
+			avx512vl = avx512f && (reg[1] & (1u << 31)) != 0;
+		}
+
+		if (avx512f && avx512dq && avx512vl && avx2 && fma)
+		{
+			simd_type = POCKET_SIMD_TYPE_AVX512;
+		}
+		else if (avx2)
+		{
+			simd_type = POCKET_SIMD_TYPE_AVX2;
+		}
+		else if (avx)
+		{
+			simd_type = POCKET_SIMD_TYPE_AVX;
+		}
+		else if (sse4_2)
+		{
+			simd_type = POCKET_SIMD_TYPE_SSE4_2;
+		}
+		else if (sse4_1)
+		{
+			simd_type = POCKET_SIMD_TYPE_SSE4_1;
+		}
+		else if (sse3)
+		{
+			simd_type = POCKET_SIMD_TYPE_SSE3;
+		}
+		else if (sse2)
+		{
+			simd_type = POCKET_SIMD_TYPE_SSE2;
+		}
+#endif // POCKET_USE_SIMD
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const cpu_feature& v)
+{
+	os << cpu_feature::name(v.simd_type);
+	if (v.fma)
+	{
+		os << "+FMA";
+	}
+	return os;
+}
+
+} // namespace pocket
+
+#endif // __POCKET_CPU_FEATURE_H__
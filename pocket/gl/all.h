@@ -9,6 +9,7 @@
 #include "fwd.h"
 #include "config.h"
 #include "gl.h"
+#include "trace.h"
 #include "indirect_command.h"
 #include "common_type.h"
 #include "wrap.h"
@@ -16,14 +17,31 @@
 #include "program.h"
 #include "buffer.h"
 #include "buffer_view.h"
+#include "buffer_heap.h"
 #include "uniform_buffer.h"
+#include "uniform_arena.h"
+#include "block_layout.h"
+#include "storage_buffer.h"
 #include "vertex_array.h"
 #include "vertex_buffer.h"
 #include "index_buffer.h"
 #include "layered_vertex_buffer.h"
+#include "vertex_format_registry.h"
+#include "render_queue.h"
+#include "command_list.h"
 #include "sampler.h"
+#include "texture.h"
+#include "texture_streamer.h"
+#include "texture_table.h"
+#include "framebuffer.h"
+#include "render_target_pool.h"
+#include "frame_graph.h"
 #include "draw_indirect_buffer.h"
 #include "sync.h"
+#include "query.h"
+#include "profiler.h"
+#include "readback.h"
+#include "loader.h"
 #include "viewport.h"
 #include "depth_range.h"
 
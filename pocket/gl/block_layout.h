@@ -0,0 +1,594 @@
+﻿#ifndef __POCKET_GL_BLOCK_LAYOUT_H__
+#define __POCKET_GL_BLOCK_LAYOUT_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "program.h"
+#include "../io.h"
+#include "../math/vector2.h"
+#include "../math/vector3.h"
+#include "../math/vector4.h"
+#include "../math/quaternion.h"
+#include "../math/matrix3x3.h"
+#include "../math/matrix4x4.h"
+#include "../math/color.h"
+#include <vector>
+#include <string>
+#include <cstddef> // for offsetof
+#include <cstring> // for std::memcpy
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+template <block_layout_type_t> struct block_layout_begin;
+template <typename, typename> struct block_member;
+template <typename> struct block_layout_end;
+class block_validator;
+
+//---------------------------------------------------------------------------------------
+// std140/std430のメンバ配置をコンパイル時に計算する
+// メンバを前から順に型で並べると, GLSLと同じオフセットと大きさが求まる
+//
+// // layout(std140) uniform ublock { mat4 world; vec3 light; float power; mat3 normal; };
+// typedef gl::block_layout_begin<gl::block_layout_type::std140> ublock_begin;
+// typedef gl::block_member<ublock_begin, math::matrix4x4f> ublock_world; // offset 0
+// typedef gl::block_member<ublock_world, math::vector3f> ublock_light; // offset 64
+// typedef gl::block_member<ublock_light, float> ublock_power; // offset 76
+// typedef gl::block_member<ublock_power, math::matrix3x3f> ublock_normal; // offset 80, 列ごとに16バイト
+// typedef gl::block_layout_end<ublock_normal> ublock_layout; // size 128
+//
+// char data[ublock_layout::size];
+// ublock_normal::write(data, normal); // 列の隙間を空けて書き込む
+//
+// C++の構造体をそのまま送る場合はPOCKET_BLOCK_STATICAL_ASSERTでずれをコンパイル時に検出し,
+// block_validatorでシェーダー側のオフセットと実行時に照合する
+//---------------------------------------------------------------------------------------
+
+namespace detail
+{
+
+template <int V, int A>
+struct block_round_up
+{
+	enum
+	{
+		value = (V + A - 1) / A * A
+	};
+};
+template <int A, int B>
+struct block_max
+{
+	enum
+	{
+		value = A > B ? A : B
+	};
+};
+
+// GLSL側の型の構成(スカラーの大きさ, 列の要素数, 列数)
+template <typename T>
+struct block_element
+{
+	enum
+	{
+		scalar = sizeof(T),
+		components = 1,
+		columns = 1,
+	};
+};
+#define __POCKET_BLOCK_ELEMENT(TYPE, COMPONENTS, COLUMNS) \
+	template <typename T> \
+	struct block_element<math::TYPE<T> > \
+	{ \
+		enum \
+		{ \
+			scalar = sizeof(T), \
+			components = COMPONENTS, \
+			columns = COLUMNS, \
+		}; \
+	}
+
+__POCKET_BLOCK_ELEMENT(vector2, 2, 1);
+__POCKET_BLOCK_ELEMENT(vector3, 3, 1);
+__POCKET_BLOCK_ELEMENT(vector4, 4, 1);
+__POCKET_BLOCK_ELEMENT(quaternion, 4, 1);
+__POCKET_BLOCK_ELEMENT(color, 4, 1);
+__POCKET_BLOCK_ELEMENT(matrix3x3, 3, 3);
+__POCKET_BLOCK_ELEMENT(matrix4x4, 4, 4);
+
+#undef __POCKET_BLOCK_ELEMENT
+
+// 型ごとの配置
+template <block_layout_type_t L, typename T>
+struct block_type_layout
+{
+	typedef block_element<T> element_type;
+
+	enum
+	{
+		// スカラーとvec2はそのまま, vec3とvec4はスカラー4つ分に揃う
+		vector_alignment = element_type::scalar * (element_type::components == 3 ? 4 : element_type::components),
+		vector_size = element_type::scalar * element_type::components,
+		// 行列は列ベクトルの配列として扱い, std140では列を16バイトに揃える
+		matrix_stride = element_type::columns == 1 ? 0 :
+			(L == block_layout_type::std140 ? block_round_up<vector_alignment, 16>::value : static_cast<int>(vector_alignment)),
+		alignment = element_type::columns == 1 ? static_cast<int>(vector_alignment) : static_cast<int>(matrix_stride),
+		size = element_type::columns == 1 ? static_cast<int>(vector_size) : matrix_stride * element_type::columns,
+		array_stride = 0,
+		count = 1,
+		columns = element_type::columns,
+	};
+
+	static void write(char* dst, const T& v)
+	{
+		const char* src = reinterpret_cast<const char*>(&v);
+		if (element_type::columns == 1)
+		{
+			std::memcpy(dst, src, vector_size);
+			return;
+		}
+		for (int i = 0; i < element_type::columns; ++i)
+		{
+			std::memcpy(dst + matrix_stride * i, src + vector_size * i, vector_size);
+		}
+	}
+};
+// 配列
+// std140では要素の揃えと間隔を16バイトの倍数にする
+template <block_layout_type_t L, typename T, int N>
+struct block_type_layout<L, T[N]>
+{
+	typedef block_type_layout<L, T> element_layout;
+
+	enum
+	{
+		alignment = L == block_layout_type::std140 ?
+			block_round_up<element_layout::alignment, 16>::value : static_cast<int>(element_layout::alignment),
+		array_stride = block_round_up<element_layout::size, alignment>::value,
+		matrix_stride = element_layout::matrix_stride,
+		size = array_stride * N,
+		count = N,
+		columns = element_layout::columns,
+	};
+
+	static void write(char* dst, const T(&v)[N])
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			element_layout::write(dst + array_stride * i, v[i]);
+		}
+	}
+};
+
+// C++側の型の並びがメンバの配置と一致するか
+// 行列は列の間隔, 配列は要素の間隔と数も比べる
+template <typename MEMBER, typename T>
+struct block_cxx_match
+{
+	enum
+	{
+		value = MEMBER::count == 1 && (MEMBER::matrix_stride == 0 ?
+			sizeof(T) <= static_cast<size_t>(MEMBER::size) :
+			sizeof(T) == static_cast<size_t>(MEMBER::matrix_stride * MEMBER::columns)),
+	};
+};
+template <typename MEMBER, typename T, size_t N>
+struct block_cxx_match<MEMBER, T[N]>
+{
+	enum
+	{
+		value = static_cast<size_t>(MEMBER::count) == N &&
+			sizeof(T) == static_cast<size_t>(MEMBER::array_stride) &&
+			(MEMBER::matrix_stride == 0 || sizeof(T) == static_cast<size_t>(MEMBER::matrix_stride * MEMBER::columns)),
+	};
+};
+// メンバの型を推論するための関数(宣言のみ), 一致すれば大きさが1の型を返す
+template <bool>
+struct block_check_result
+{
+	typedef char (&type)[1];
+};
+template <>
+struct block_check_result<false>
+{
+	typedef char (&type)[2];
+};
+template <typename MEMBER, typename T>
+typename block_check_result<block_cxx_match<MEMBER, T>::value != 0>::type block_check(const T&);
+
+} // namespace detail
+
+//---------------------------------------------------------------------------------------
+// ブロックの先頭
+//---------------------------------------------------------------------------------------
+template <block_layout_type_t L>
+struct block_layout_begin
+{
+	static const block_layout_type_t layout = L;
+
+	enum
+	{
+		end = 0,
+		alignment = 1,
+	};
+};
+
+//---------------------------------------------------------------------------------------
+// PREVの後ろに置かれるT型のメンバ
+//---------------------------------------------------------------------------------------
+template <typename PREV, typename T>
+struct block_member
+{
+	typedef PREV previous_type;
+	typedef T value_type;
+
+	static const block_layout_type_t layout = PREV::layout;
+
+	typedef detail::block_type_layout<PREV::layout, T> type_layout;
+
+	enum
+	{
+		offset = detail::block_round_up<PREV::end, type_layout::alignment>::value,
+		size = type_layout::size,
+		end = offset + size,
+		alignment = detail::block_max<PREV::alignment, type_layout::alignment>::value,
+		// 配列の要素の間隔(配列でなければ0)
+		array_stride = type_layout::array_stride,
+		// 行列の列の間隔(行列でなければ0)
+		matrix_stride = type_layout::matrix_stride,
+		count = type_layout::count,
+		// 行列の列数(行列でなければ1)
+		columns = type_layout::columns,
+	};
+
+	// ブロックの先頭から配置に合わせて書き込む
+	static void write(void* block, const T& v)
+	{
+		type_layout::write(static_cast<char*>(block) + offset, v);
+	}
+};
+
+//---------------------------------------------------------------------------------------
+// ブロックの終端(LASTは最後のメンバ)
+// std140ではブロックの大きさを16バイトの倍数にする
+//---------------------------------------------------------------------------------------
+template <typename LAST>
+struct block_layout_end
+{
+	static const block_layout_type_t layout = LAST::layout;
+
+	enum
+	{
+		alignment = LAST::layout == block_layout_type::std140 ?
+			detail::block_round_up<LAST::alignment, 16>::value : static_cast<int>(LAST::alignment),
+		size = detail::block_round_up<LAST::end, alignment>::value,
+	};
+};
+
+//---------------------------------------------------------------------------------------
+// C++の構造体のメンバが配置と一致しているかコンパイル時に確認する
+// オフセットに加え, 配列は要素の間隔と数, 行列は列の間隔を比べる
+// std140のfloat[4]はvector4f[4]などで間隔を16バイトにすること
+// POCKET_BLOCK_STATICAL_ASSERT(ublock_t, world, ublock_world);
+//---------------------------------------------------------------------------------------
+#ifndef POCKET_BLOCK_STATICAL_ASSERT
+#	define POCKET_BLOCK_STATICAL_ASSERT(STRUCT, MEM, MEMBER) \
+	POCKET_STATICAL_ASSERT(offsetof(STRUCT, MEM) == static_cast<size_t>(MEMBER::offset) && \
+		sizeof(pocket::gl::detail::block_check<MEMBER>(static_cast<const STRUCT*>(0)->MEM)) == 1, \
+		block_layout_mismatch_##STRUCT##_##MEM)
+#endif // POCKET_BLOCK_STATICAL_ASSERT
+
+//---------------------------------------------------------------------------------------
+// シェーダー側のブロックの配置と照合する
+// uniformはglGetActiveUniformsiv, shader_storageはglGetProgramResourceivで取得する
+//
+// gl::block_validator v(prog, "ublock", gl::buffer_type::uniform);
+// v.check<ublock_world>("world");
+// v.check<ublock_normal>("normal");
+// v.check_size<ublock_layout>();
+// if (!v) { std::cout << v << std::endl; }
+//---------------------------------------------------------------------------------------
+class block_validator
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 一致しなかった項目
+	struct mismatch
+	{
+		std::string name;
+		const char* what; // offset, array_stride, matrix_stride, size, not found
+		int expected;
+		int actual;
+	};
+
+private:
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	GLuint _program;
+	buffer_type_t _type;
+	std::string _block;
+	GLuint _index;
+	std::vector<mismatch> _mismatches;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	block_validator() :
+		_program(0),
+		_type(buffer_type::unknown),
+		_index(GL_INVALID_INDEX),
+		_error_bitfield(0)
+	{}
+	// typeはbuffer_type::uniformかbuffer_type::shader_storage
+	explicit block_validator(const program& prog, const char* block, buffer_type_t type = buffer_type::uniform) :
+		_program(0),
+		_type(buffer_type::unknown),
+		_index(GL_INVALID_INDEX),
+		_error_bitfield(0)
+	{
+		initialize(prog, block, type);
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	bool initialize(const program& prog, const char* block, buffer_type_t type = buffer_type::uniform)
+	{
+		_program = prog.get();
+		_type = type;
+		_block = block;
+		_mismatches.clear();
+		_error_bitfield = 0;
+
+		if (type == buffer_type::uniform)
+		{
+			_index = glGetUniformBlockIndex(_program, block);
+		}
+		else if (type == buffer_type::shader_storage)
+		{
+			_index = glGetProgramResourceIndex(_program, GL_SHADER_STORAGE_BLOCK, block);
+		}
+		else
+		{
+			_index = GL_INVALID_INDEX;
+			_error_bitfield |= error_unsupported;
+			return false;
+		}
+		if (_index == GL_INVALID_INDEX)
+		{
+			_error_bitfield |= error_invalid_index;
+			return false;
+		}
+		return true;
+	}
+
+	// メンバの照合
+	// nameはGLSLでの名前(インスタンス名を付けたブロックは先頭の"ブロック名."を省略できる)
+	template <typename M>
+	bool check(const char* name)
+	{
+		return check(name, M::offset, M::array_stride, M::matrix_stride);
+	}
+	bool check(const char* name, int offset, int array_stride, int matrix_stride)
+	{
+		if (!valid_block())
+		{
+			return false;
+		}
+
+		GLint actual[3] = { 0, 0, 0 };
+		if (!query(name, actual))
+		{
+			add(name, "not found", offset, -1);
+			return false;
+		}
+		const size_t before = _mismatches.size();
+		if (actual[0] != offset)
+		{
+			add(name, "offset", offset, actual[0]);
+		}
+		// 配列や行列で無いメンバは-1や0が返るため, 値がある時だけ比べる
+		if (array_stride > 0 && actual[1] != array_stride)
+		{
+			add(name, "array_stride", array_stride, actual[1]);
+		}
+		if (matrix_stride > 0 && actual[2] != matrix_stride)
+		{
+			add(name, "matrix_stride", matrix_stride, actual[2]);
+		}
+		return _mismatches.size() == before;
+	}
+
+	// ブロック全体の大きさの照合
+	template <typename E>
+	bool check_size()
+	{
+		return check_size(E::size);
+	}
+	bool check_size(int size)
+	{
+		if (!valid_block())
+		{
+			return false;
+		}
+		const int actual = block_size();
+		if (actual != size)
+		{
+			add(_block.c_str(), "size", size, actual);
+			return false;
+		}
+		return true;
+	}
+
+	// シェーダー側のブロックの大きさ
+	int block_size() const
+	{
+		GLint size = 0;
+		if (_type == buffer_type::uniform)
+		{
+			glGetActiveUniformBlockiv(_program, _index, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+		}
+		else
+		{
+			const GLenum prop = GL_BUFFER_DATA_SIZE;
+			glGetProgramResourceiv(_program, GL_SHADER_STORAGE_BLOCK, _index, 1, &prop, 1, NULL, &size);
+		}
+		return static_cast<int>(size);
+	}
+
+	// 一致しなかった項目
+	const std::vector<mismatch>& mismatches() const
+	{
+		return _mismatches;
+	}
+
+	// ブロック名
+	const std::string& name() const
+	{
+		return _block;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_unsupported))
+		{
+			return "type is not uniform or shader_storage.";
+		}
+		if (error_status(error_invalid_index))
+		{
+			return "block not found.";
+		}
+		if (!_mismatches.empty())
+		{
+			return "layout mismatch.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 全て一致しているか
+	bool valid() const
+	{
+		return valid_block() && _mismatches.empty();
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	bool valid_block() const
+	{
+		return _program != 0 && _index != GL_INVALID_INDEX && _error_bitfield == 0;
+	}
+
+	void add(const char* name, const char* what, int expected, int actual)
+	{
+		mismatch m;
+		m.name = name;
+		m.what = what;
+		m.expected = expected;
+		m.actual = actual;
+		_mismatches.push_back(m);
+	}
+
+	// [offset, array_stride, matrix_stride]を取得
+	bool query(const char* name, GLint (&result)[3]) const
+	{
+		if (query_name(name, result))
+		{
+			return true;
+		}
+		// インスタンス名付きのブロック
+		const std::string qualified = _block + "." + name;
+		return query_name(qualified.c_str(), result);
+	}
+	bool query_name(const char* name, GLint (&result)[3]) const
+	{
+		if (_type == buffer_type::uniform)
+		{
+			GLuint index = GL_INVALID_INDEX;
+			glGetUniformIndices(_program, 1, &name, &index);
+			if (index == GL_INVALID_INDEX)
+			{
+				return false;
+			}
+			glGetActiveUniformsiv(_program, 1, &index, GL_UNIFORM_OFFSET, &result[0]);
+			glGetActiveUniformsiv(_program, 1, &index, GL_UNIFORM_ARRAY_STRIDE, &result[1]);
+			glGetActiveUniformsiv(_program, 1, &index, GL_UNIFORM_MATRIX_STRIDE, &result[2]);
+			return true;
+		}
+
+		const GLuint index = glGetProgramResourceIndex(_program, GL_BUFFER_VARIABLE, name);
+		if (index == GL_INVALID_INDEX)
+		{
+			return false;
+		}
+		const GLenum props[3] = { GL_OFFSET, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+		glGetProgramResourceiv(_program, GL_BUFFER_VARIABLE, index, 3, props, 3, NULL, &result[0]);
+		return true;
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const block_validator& v)
+{
+	os << io::widen("block_validator: {") << std::endl <<
+		io::tab << io::widen("name: ") << io::widen(v.name().c_str()) << std::endl;
+	const std::vector<block_validator::mismatch>& m = v.mismatches();
+	for (size_t i = 0; i < m.size(); ++i)
+	{
+		os << io::tab << io::widen(m[i].name.c_str()) << io::widen(": ") << io::widen(m[i].what) <<
+			io::widen(" expected ") << m[i].expected << io::widen(", actual ") << m[i].actual << std::endl;
+	}
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_BLOCK_LAYOUT_H__
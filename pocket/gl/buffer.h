@@ -256,6 +256,32 @@ public:
 		return initialize(type, usg, sizeof(T)*a.size(), static_cast<const void*>(&a[0]));
 	}
 
+	// 大きさを変更できない領域で初期化(glBufferStorage)
+	// flagsにGL_DYNAMIC_STORAGE_BIT, GL_MAP_WRITE_BIT, GL_MAP_PERSISTENT_BITなどを指定する
+	bool initialize_storage(buffer_type_t type, int size, const void* data, GLbitfield flags)
+	{
+		finalize();
+
+		_type = type;
+
+		glGenBuffers(1, &_id);
+		if (_id == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		glBindBuffer(_type, _id);
+		if (glIsBuffer(_id) == GL_FALSE)
+		{
+			_error_bitfield |= error_binding;
+			return false;
+		}
+		glBufferStorage(_type, static_cast<GLsizeiptr>(size), data, flags);
+		glBindBuffer(_type, 0);
+		return true;
+	}
+
 	// 終了処理
 	void finalize()
 	{
@@ -0,0 +1,610 @@
+﻿#ifndef __POCKET_GL_BUFFER_HEAP_H__
+#define __POCKET_GL_BUFFER_HEAP_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "../io.h"
+#include <vector>
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class buffer_heap;
+
+//---------------------------------------------------------------------------------------
+// 一つの大きなバッファからの部分確保
+// glBufferStorageで確保した変更不可のバッファをTLSF(二段階の分離空きリスト)で切り分ける
+// 小さなメッシュごとにバッファを作らずに済み, 同じVAOのまま描画できる
+//
+// gl::buffer_heap vertices(gl::buffer_type::array, 64 * 1024 * 1024);
+// gl::buffer_heap indices(gl::buffer_type::element_array, 16 * 1024 * 1024);
+// gl::buffer_heap::allocation v = vertices.allocate(mesh_vertices, vertex_count); // 頂点の大きさに揃える
+// gl::buffer_heap::allocation i = indices.allocate(mesh_indices, index_count);
+//
+// gl::vertex_array vao(vertices.buffer(), sizeof(vertex), layouts);
+// vao.attach_index(indices.buffer());
+// vao.bind();
+// indices.draw<unsigned short>(gl::draw_type::triangles, i, v.base_vertex<vertex>());
+//
+// vertices.deallocate(v);
+//---------------------------------------------------------------------------------------
+class buffer_heap
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 確保した領域
+	struct allocation
+	{
+		int node; // 管理用(無効なら-1)
+		int offset; // バッファ先頭からのバイト数
+		int size;
+
+		allocation() :
+			node(-1),
+			offset(0),
+			size(0)
+		{}
+
+		bool valid() const
+		{
+			return node >= 0;
+		}
+
+		// 先頭の頂点番号(glDrawElementsBaseVertexのbasevertex)
+		GLint base_vertex(int stride) const
+		{
+			return static_cast<GLint>(offset / stride);
+		}
+		template <typename T>
+		GLint base_vertex() const
+		{
+			return base_vertex(static_cast<int>(sizeof(T)));
+		}
+
+		// 要素数
+		int count(int type_size) const
+		{
+			return size / type_size;
+		}
+		template <typename T>
+		int count() const
+		{
+			return size / static_cast<int>(sizeof(T));
+		}
+	};
+
+private:
+	// 二段目の分割数(2^SL_LOG2)
+	enum
+	{
+		FL_COUNT = 32,
+		SL_LOG2 = 3,
+		SL_COUNT = 1 << SL_LOG2,
+	};
+
+	// 連続した領域
+	struct block
+	{
+		int offset;
+		int size;
+		int prev; // 隣接する領域
+		int next;
+		int prev_free; // 同じ空きリストの領域
+		int next_free;
+		bool free;
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	gl::buffer _buffer;
+	std::vector<block> _blocks;
+	std::vector<int> _unused; // 再利用できるblock
+	int _heads[FL_COUNT][SL_COUNT];
+	unsigned int _fl_bitmap;
+	unsigned int _sl_bitmap[FL_COUNT];
+	int _capacity;
+	int _used;
+	int _count;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// 確保の最小単位(バイト)
+	static const int granularity = 16;
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	buffer_heap() :
+		_buffer(),
+		_capacity(0),
+		_used(0),
+		_count(0),
+		_error_bitfield(0)
+	{
+		reset_lists();
+	}
+	explicit buffer_heap(buffer_type_t type, int size) :
+		_buffer(),
+		_capacity(0),
+		_used(0),
+		_count(0),
+		_error_bitfield(0)
+	{
+		initialize(type, size);
+	}
+	~buffer_heap()
+	{
+		finalize();
+	}
+
+private:
+	// 領域の管理を共有しないように複製は禁止
+	buffer_heap(const buffer_heap&);
+	buffer_heap& operator = (const buffer_heap&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	// sizeはgranularityの倍数に切り上げる
+	bool initialize(buffer_type_t type, int size)
+	{
+		finalize();
+
+		if (size < granularity)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return false;
+		}
+		size = round_up(size, granularity);
+
+		// 後からglBufferSubDataで書き込めるようにする
+		if (!_buffer.initialize_storage(type, size, NULL, GL_DYNAMIC_STORAGE_BIT))
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		_capacity = size;
+		_blocks.reserve(64);
+		insert_free(new_block(0, size, -1, -1));
+		return true;
+	}
+
+	// 終了処理
+	// 確保した領域は全て無効になる
+	void finalize()
+	{
+		_buffer.finalize();
+		_blocks.clear();
+		_unused.clear();
+		reset_lists();
+		_capacity = 0;
+		_used = 0;
+		_count = 0;
+		_error_bitfield = 0;
+	}
+
+	// 領域の確保
+	// alignmentは2のべき乗でなくてもよい(頂点の大きさなど)
+	// 確保できなければvalid()がfalseの領域を返す
+	allocation allocate(int size, int alignment = granularity)
+	{
+		allocation a;
+		if (size <= 0 || alignment <= 0 || _capacity == 0)
+		{
+			return a;
+		}
+
+		// 先頭を揃えるための余白を含める
+		int need = size;
+		if (alignment % granularity != 0 && granularity % alignment != 0)
+		{
+			need += alignment - 1;
+		}
+		else if (alignment > granularity)
+		{
+			need += alignment - granularity;
+		}
+		need = round_up(need, granularity);
+
+		const int n = find_free(need);
+		if (n < 0)
+		{
+			return a;
+		}
+		remove_free(n);
+
+		// 余った後ろ側は空きに戻す
+		const int rest = _blocks[n].size - need;
+		if (rest > 0)
+		{
+			_blocks[n].size = need;
+			const int r = new_block(_blocks[n].offset + need, rest, n, _blocks[n].next);
+			if (_blocks[r].next >= 0)
+			{
+				_blocks[_blocks[r].next].prev = r;
+			}
+			_blocks[n].next = r;
+			insert_free(r);
+		}
+		_blocks[n].free = false;
+		_used += _blocks[n].size;
+		++_count;
+
+		a.node = n;
+		a.offset = round_up(_blocks[n].offset, alignment);
+		a.size = size;
+		return a;
+	}
+	template <typename T>
+	allocation allocate(int count)
+	{
+		return allocate(static_cast<int>(sizeof(T)) * count, static_cast<int>(sizeof(T)));
+	}
+	// 確保してデータを書き込む
+	template <typename T>
+	allocation allocate(const T* data, int count)
+	{
+		allocation a = allocate(static_cast<int>(sizeof(T)) * count, static_cast<int>(sizeof(T)));
+		if (a.valid())
+		{
+			write(a, data, a.size);
+		}
+		return a;
+	}
+
+	// 領域の解放
+	// 隣接する空き領域とまとめる
+	void deallocate(allocation& a)
+	{
+		if (!a.valid() || a.node >= static_cast<int>(_blocks.size()) || _blocks[a.node].free)
+		{
+			return;
+		}
+		int n = a.node;
+		_used -= _blocks[n].size;
+		--_count;
+		a = allocation();
+
+		const int prev = _blocks[n].prev;
+		if (prev >= 0 && _blocks[prev].free)
+		{
+			remove_free(prev);
+			merge(prev, n);
+			n = prev;
+		}
+		const int next = _blocks[n].next;
+		if (next >= 0 && _blocks[next].free)
+		{
+			remove_free(next);
+			merge(n, next);
+		}
+		insert_free(n);
+	}
+
+	// 領域への書き込み
+	// GPUが使用中の領域へ書き込むとその場で同期されるため, 描画後の領域は書き換えないこと
+	// VAOのインデックスバッファを変えないようにGL_COPY_WRITE_BUFFERで書き込む
+	void write(const allocation& a, const void* data, int size, int offset = 0) const
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer.get());
+		glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(a.offset + offset), static_cast<GLsizeiptr>(size), data);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	// インデックスの領域を描画
+	// 頂点側のVAOとこのバッファ(element_array)をバインドしておくこと
+	template <typename T>
+	void draw(draw_type_t type, const allocation& indices, GLint base_vertex) const
+	{
+		glDrawElementsBaseVertex(type, indices.count<T>(), gl_type<T>::value, POCKET_BUFFER_OFFSET(indices.offset), base_vertex);
+	}
+	template <typename T>
+	void draw(draw_type_t type, const allocation& indices, GLsizei n, GLint base_vertex) const
+	{
+		glDrawElementsBaseVertex(type, n, gl_type<T>::value, POCKET_BUFFER_OFFSET(indices.offset), base_vertex);
+	}
+	// インスタンス描画
+	// base_instanceでインスタンスごとの属性の読み始めをずらせるため, 複数のメッシュで一つのインスタンスバッファを共有できる
+	template <typename T>
+	void draw_instanced(draw_type_t type, const allocation& indices, GLint base_vertex, GLsizei instances, GLuint base_instance = 0) const
+	{
+		glDrawElementsInstancedBaseVertexBaseInstance(type, indices.count<T>(), gl_type<T>::value, POCKET_BUFFER_OFFSET(indices.offset),
+			instances, base_vertex, base_instance);
+	}
+
+	// 全体のバッファ(VAOの作成, バインドに使う)
+	const gl::buffer& buffer() const
+	{
+		return _buffer;
+	}
+
+	// バッファ全体の大きさ
+	int capacity() const
+	{
+		return _capacity;
+	}
+	// 使用中の大きさ(余白を含む)
+	int used() const
+	{
+		return _used;
+	}
+	// 確保中の数
+	int count() const
+	{
+		return _count;
+	}
+	// 一度に確保できる最大の大きさ
+	int largest() const
+	{
+		int size = 0;
+		for (size_t i = 0; i < _blocks.size(); ++i)
+		{
+			if (_blocks[i].free && _blocks[i].size > size)
+			{
+				size = _blocks[i].size;
+			}
+		}
+		return size;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "size is less than granularity.";
+		}
+		if (error_status(error_creating))
+		{
+			return _buffer.error();
+		}
+		if (_capacity == 0)
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return _capacity != 0 && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	static int round_up(int v, int alignment)
+	{
+		return (v + alignment - 1) / alignment * alignment;
+	}
+
+	// 最上位と最下位のビット位置
+	static int highest(unsigned int bits)
+	{
+		int n = -1;
+		while (bits != 0)
+		{
+			bits >>= 1;
+			++n;
+		}
+		return n;
+	}
+	static int lowest(unsigned int bits)
+	{
+		if (bits == 0)
+		{
+			return -1;
+		}
+		int n = 0;
+		while ((bits & 1) == 0)
+		{
+			bits >>= 1;
+			++n;
+		}
+		return n;
+	}
+
+	// 大きさからリストの位置を求める(granularity単位)
+	static void mapping(int size, int& fl, int& sl)
+	{
+		const unsigned int u = static_cast<unsigned int>(size / granularity);
+		fl = highest(u);
+		if (fl < SL_LOG2)
+		{
+			sl = static_cast<int>((u - (1u << fl)) << (SL_LOG2 - fl));
+		}
+		else
+		{
+			sl = static_cast<int>((u >> (fl - SL_LOG2)) - SL_COUNT);
+		}
+	}
+
+	void reset_lists()
+	{
+		_fl_bitmap = 0;
+		for (int i = 0; i < FL_COUNT; ++i)
+		{
+			_sl_bitmap[i] = 0;
+			for (int j = 0; j < SL_COUNT; ++j)
+			{
+				_heads[i][j] = -1;
+			}
+		}
+	}
+
+	int new_block(int offset, int size, int prev, int next)
+	{
+		block b;
+		b.offset = offset;
+		b.size = size;
+		b.prev = prev;
+		b.next = next;
+		b.prev_free = -1;
+		b.next_free = -1;
+		b.free = false;
+		if (!_unused.empty())
+		{
+			const int n = _unused.back();
+			_unused.pop_back();
+			_blocks[n] = b;
+			return n;
+		}
+		_blocks.push_back(b);
+		return static_cast<int>(_blocks.size()) - 1;
+	}
+
+	// 後ろの領域を前の領域にまとめる
+	void merge(int front, int back)
+	{
+		_blocks[front].size += _blocks[back].size;
+		_blocks[front].next = _blocks[back].next;
+		if (_blocks[back].next >= 0)
+		{
+			_blocks[_blocks[back].next].prev = front;
+		}
+		_unused.push_back(back);
+	}
+
+	void insert_free(int n)
+	{
+		int fl, sl;
+		mapping(_blocks[n].size, fl, sl);
+		block& b = _blocks[n];
+		b.free = true;
+		b.prev_free = -1;
+		b.next_free = _heads[fl][sl];
+		if (b.next_free >= 0)
+		{
+			_blocks[b.next_free].prev_free = n;
+		}
+		_heads[fl][sl] = n;
+		_fl_bitmap |= 1u << fl;
+		_sl_bitmap[fl] |= 1u << sl;
+	}
+
+	void remove_free(int n)
+	{
+		int fl, sl;
+		mapping(_blocks[n].size, fl, sl);
+		block& b = _blocks[n];
+		if (b.prev_free >= 0)
+		{
+			_blocks[b.prev_free].next_free = b.next_free;
+		}
+		else
+		{
+			_heads[fl][sl] = b.next_free;
+		}
+		if (b.next_free >= 0)
+		{
+			_blocks[b.next_free].prev_free = b.prev_free;
+		}
+		b.prev_free = -1;
+		b.next_free = -1;
+		b.free = false;
+
+		if (_heads[fl][sl] < 0)
+		{
+			_sl_bitmap[fl] &= ~(1u << sl);
+			if (_sl_bitmap[fl] == 0)
+			{
+				_fl_bitmap &= ~(1u << fl);
+			}
+		}
+	}
+
+	// size以上が確実に入るリストの先頭
+	int find_free(int size) const
+	{
+		// 同じリスト内の小さい領域を避けるため切り上げてから探す
+		const int fl0 = highest(static_cast<unsigned int>(size / granularity));
+		if (fl0 >= SL_LOG2)
+		{
+			const int round = (1 << (fl0 - SL_LOG2)) * granularity - granularity;
+			if (size > 0x7FFFFFFF - round)
+			{
+				return -1;
+			}
+			size += round;
+		}
+		int fl, sl;
+		mapping(size, fl, sl);
+
+		unsigned int bits = _sl_bitmap[fl] & (~0u << sl);
+		if (bits == 0)
+		{
+			const unsigned int fls = fl + 1 < FL_COUNT ? _fl_bitmap & (~0u << (fl + 1)) : 0;
+			if (fls == 0)
+			{
+				return -1;
+			}
+			fl = lowest(fls);
+			bits = _sl_bitmap[fl];
+		}
+		return _heads[fl][lowest(bits)];
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const buffer_heap& v)
+{
+	os << io::widen("buffer_heap: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.buffer().get() << std::endl <<
+		io::tab << io::widen("capacity: ") << v.capacity() << std::endl <<
+		io::tab << io::widen("used: ") << v.used() << std::endl <<
+		io::tab << io::widen("count: ") << v.count() << std::endl <<
+		io::tab << io::widen("largest: ") << v.largest() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_BUFFER_HEAP_H__
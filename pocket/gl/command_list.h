@@ -0,0 +1,622 @@
+﻿#ifndef __POCKET_GL_COMMAND_LIST_H__
+#define __POCKET_GL_COMMAND_LIST_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "program.h"
+#include "vertex_array.h"
+#include "sampler.h"
+#include "draw_indirect_buffer.h"
+#include "../math/vector2.h"
+#include "../math/vector3.h"
+#include "../math/vector4.h"
+#include "../math/color.h"
+#include "../math/matrix3x3.h"
+#include "../math/matrix4x4.h"
+#include "../io.h"
+#include <vector>
+#include <cstring> // for std::memcpy
+#include <algorithm> // for std::min
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class command_list;
+
+//---------------------------------------------------------------------------------------
+// 描画命令の記録
+// GLの関数を呼ばずにバインド, ユニフォーム, 描画, バッファの更新を詰めておき, GLのスレッドでexecuteで順番に実行する
+// 記録はGLを呼ばないため, スレッドごとにcommand_listを持てば別のスレッドで記録できる
+// 命令は 種類(4byte) 大きさ(4byte) 引数 の順に詰め, 引数は全てPOD
+//
+// // 作業スレッド
+// lists[n].clear();
+// lists[n].bind_program(prog);
+// lists[n].bind_vertex_array(vao);
+// lists[n].bind_buffer_range(gl::buffer_type::uniform, 0, arena.buffer(), range.offset, range.size);
+// lists[n].uniform(loc, world);
+// lists[n].draw_elements<unsigned short>(gl::draw_type::triangles, count);
+// // GLのスレッド(作業スレッドの完了後)
+// for (...) lists[i].execute();
+//
+// 参照するGLのオブジェクトとpersistentに展開したバッファ(storage_bufferなど)はexecuteまで有効であること
+//---------------------------------------------------------------------------------------
+class command_list
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 命令の種類
+	struct command_type
+	{
+		enum type
+		{
+			bind_program = 1,
+			bind_vertex_array,
+			bind_vertex_buffer,
+			bind_index_buffer,
+			bind_texture,
+			bind_sampler,
+			bind_buffer_range,
+			uniform,
+			draw_arrays,
+			draw_elements,
+			draw_indirect,
+			update,
+			copy
+		};
+	};
+	typedef command_type::type command_type_t;
+
+private:
+	// 命令の先頭
+	struct header
+	{
+		unsigned int type;
+		unsigned int size; // 引数のバイト数
+	};
+
+	// 引数
+	struct id_cmd
+	{
+		GLuint id;
+	};
+	struct vertex_buffer_cmd
+	{
+		GLuint binding;
+		GLuint id;
+		GLintptr offset;
+		GLsizei stride;
+	};
+	struct texture_cmd
+	{
+		GLuint unit;
+		GLenum target;
+		GLuint id;
+	};
+	struct sampler_cmd
+	{
+		GLuint unit;
+		GLuint id;
+	};
+	struct buffer_range_cmd
+	{
+		GLenum target;
+		GLuint point;
+		GLuint id;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+	struct uniform_cmd // 後ろに値が続く
+	{
+		GLint location;
+		GLenum type;
+		GLsizei count;
+	};
+	struct arrays_cmd
+	{
+		GLenum mode;
+		GLint first;
+		GLsizei count;
+		GLsizei instances;
+		GLuint base_instance;
+	};
+	struct elements_cmd
+	{
+		GLenum mode;
+		GLenum type;
+		GLsizei count;
+		GLintptr offset;
+		GLint base_vertex;
+		GLsizei instances;
+		GLuint base_instance;
+	};
+	struct indirect_cmd
+	{
+		GLenum mode;
+		GLenum type; // 0でdraw_arrays_cmd
+		GLuint id;
+		GLintptr offset;
+	};
+	struct update_cmd // 後ろに値が続く
+	{
+		GLuint id;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+	struct copy_cmd
+	{
+		GLuint read;
+		GLintptr read_offset;
+		GLuint write;
+		GLintptr write_offset;
+		GLsizeiptr size;
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::vector<char> _data;
+	int _count;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	command_list() :
+		_count(0)
+	{}
+	// bytes: 予め確保しておく大きさ
+	explicit command_list(int bytes) :
+		_count(0)
+	{
+		_data.reserve(bytes);
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 記録した命令を消す(確保した領域は残す)
+	void clear()
+	{
+		_data.clear();
+		_count = 0;
+	}
+
+	void reserve(int bytes)
+	{
+		_data.reserve(bytes);
+	}
+
+	// バインド
+	void bind_program(GLuint id)
+	{
+		id_cmd c = { id };
+		push(command_type::bind_program, c);
+	}
+	void bind_program(const program& prog)
+	{
+		bind_program(prog.get());
+	}
+	void bind_vertex_array(GLuint id)
+	{
+		id_cmd c = { id };
+		push(command_type::bind_vertex_array, c);
+	}
+	void bind_vertex_array(const vertex_array& vao)
+	{
+		bind_vertex_array(vao.get());
+	}
+	// バインドしているVAOのバインディングポイントに頂点バッファを設定(initialize_formatのVAO)
+	void bind_vertex_buffer(GLuint binding, GLuint id, GLintptr offset, GLsizei stride)
+	{
+		vertex_buffer_cmd c = { binding, id, offset, stride };
+		push(command_type::bind_vertex_buffer, c);
+	}
+	void bind_vertex_buffer(GLuint binding, const buffer& b, GLintptr offset, GLsizei stride)
+	{
+		bind_vertex_buffer(binding, b.get(), offset, stride);
+	}
+	// バインドしているVAOにインデックスバッファを設定
+	void bind_index_buffer(GLuint id)
+	{
+		id_cmd c = { id };
+		push(command_type::bind_index_buffer, c);
+	}
+	void bind_index_buffer(const buffer& b)
+	{
+		bind_index_buffer(b.get());
+	}
+	void bind_texture(GLuint unit, GLenum target, GLuint id)
+	{
+		texture_cmd c = { unit, target, id };
+		push(command_type::bind_texture, c);
+	}
+	void bind_sampler(GLuint unit, GLuint id)
+	{
+		sampler_cmd c = { unit, id };
+		push(command_type::bind_sampler, c);
+	}
+	void bind_sampler(GLuint unit, const sampler& s)
+	{
+		bind_sampler(unit, s.get());
+	}
+	// uniform, shader_storageなどのバインディングポイントに範囲を設定
+	void bind_buffer_range(buffer_type_t type, GLuint point, GLuint id, GLintptr offset, GLsizeiptr size)
+	{
+		buffer_range_cmd c = { static_cast<GLenum>(type), point, id, offset, size };
+		push(command_type::bind_buffer_range, c);
+	}
+	void bind_buffer_range(buffer_type_t type, GLuint point, const buffer& b, GLintptr offset, GLsizeiptr size)
+	{
+		bind_buffer_range(type, point, b.get(), offset, size);
+	}
+
+	// ユニフォーム(バインドしているプログラムに設定する)
+	void uniform(GLint location, int v)
+	{
+		push_uniform(location, GL_INT, 1, &v, sizeof(v));
+	}
+	void uniform(GLint location, float v)
+	{
+		push_uniform(location, GL_FLOAT, 1, &v, sizeof(v));
+	}
+	void uniform(GLint location, const math::vector2<float>& v)
+	{
+		push_uniform(location, GL_FLOAT_VEC2, 1, &v.x, sizeof(float) * 2);
+	}
+	void uniform(GLint location, const math::vector3<float>& v)
+	{
+		const float f[] = { v.x, v.y, v.z };
+		push_uniform(location, GL_FLOAT_VEC3, 1, f, sizeof(f));
+	}
+	void uniform(GLint location, const math::vector4<float>& v)
+	{
+		const float f[] = { v.x, v.y, v.z, v.w };
+		push_uniform(location, GL_FLOAT_VEC4, 1, f, sizeof(f));
+	}
+	void uniform(GLint location, const math::color<float>& v)
+	{
+		const float f[] = { v.r, v.g, v.b, v.a };
+		push_uniform(location, GL_FLOAT_VEC4, 1, f, sizeof(f));
+	}
+	void uniform(GLint location, const math::matrix3x3<float>& v)
+	{
+		float f[9];
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				f[i * 3 + j] = v[i][j];
+			}
+		}
+		push_uniform(location, GL_FLOAT_MAT3, 1, f, sizeof(f));
+	}
+	void uniform(GLint location, const math::matrix4x4<float>& v)
+	{
+		push_uniform(location, GL_FLOAT_MAT4, 1, &v[0][0], sizeof(float) * 16);
+	}
+	void uniform(GLint location, const float* v, int count)
+	{
+		push_uniform(location, GL_FLOAT, count, v, static_cast<int>(sizeof(float)) * count);
+	}
+	void uniform(GLint location, const int* v, int count)
+	{
+		push_uniform(location, GL_INT, count, v, static_cast<int>(sizeof(int)) * count);
+	}
+
+	// 描画
+	void draw_arrays(draw_type_t mode, GLint first, GLsizei count, GLsizei instances = 1, GLuint base_instance = 0)
+	{
+		arrays_cmd c = { static_cast<GLenum>(mode), first, count, instances, base_instance };
+		push(command_type::draw_arrays, c);
+	}
+	// offsetはインデックスバッファの先頭からのバイト数
+	void draw_elements(draw_type_t mode, GLenum type, GLsizei count, GLintptr offset = 0, GLint base_vertex = 0, GLsizei instances = 1, GLuint base_instance = 0)
+	{
+		elements_cmd c = { static_cast<GLenum>(mode), type, count, offset, base_vertex, instances, base_instance };
+		push(command_type::draw_elements, c);
+	}
+	// first番目のインデックスからcount個
+	template <typename T>
+	void draw_elements(draw_type_t mode, GLsizei count, int first = 0, GLint base_vertex = 0, GLsizei instances = 1, GLuint base_instance = 0)
+	{
+		draw_elements(mode, gl_type<T>::value, count, static_cast<GLintptr>(sizeof(T) * first), base_vertex, instances, base_instance);
+	}
+	// typeが0の時はdraw_arrays_cmd, それ以外はdraw_elements_cmdを読み込む
+	void draw_indirect(draw_type_t mode, GLenum type, const draw_indirect_buffer& b, GLintptr offset = 0)
+	{
+		indirect_cmd c = { static_cast<GLenum>(mode), type, b.get(), offset };
+		push(command_type::draw_indirect, c);
+	}
+
+	// バッファの更新
+	// 値は命令と一緒に詰めるため, 記録した後に元の値を変更してもよい
+	void update(GLuint id, GLintptr offset, const void* data, int size)
+	{
+		update_cmd c = { id, offset, static_cast<GLsizeiptr>(size) };
+		const size_t at = reserve_command(command_type::update, sizeof(c) + size);
+		std::memcpy(&_data[at], &c, sizeof(c));
+		std::memcpy(&_data[at + sizeof(c)], data, size);
+	}
+	void update(const buffer& b, GLintptr offset, const void* data, int size)
+	{
+		update(b.get(), offset, data, size);
+	}
+	// バッファ間のコピー
+	// persistentに展開したリングバッファへ書き込んだ値を移す場合など
+	void copy(GLuint read, GLintptr read_offset, GLuint write, GLintptr write_offset, GLsizeiptr size)
+	{
+		copy_cmd c = { read, read_offset, write, write_offset, size };
+		push(command_type::copy, c);
+	}
+	void copy(const buffer& read, GLintptr read_offset, const buffer& write, GLintptr write_offset, GLsizeiptr size)
+	{
+		copy(read.get(), read_offset, write.get(), write_offset, size);
+	}
+
+	// 記録した順に実行
+	// GLのスレッドで呼ぶこと
+	void execute() const
+	{
+		const size_t n = _data.size();
+		size_t at = 0;
+		while (at + sizeof(header) <= n)
+		{
+			header h;
+			std::memcpy(&h, &_data[at], sizeof(h));
+			at += sizeof(h);
+			execute(static_cast<command_type_t>(h.type), &_data[at]);
+			at += h.size;
+		}
+	}
+
+	// 記録した命令の数
+	int count() const
+	{
+		return _count;
+	}
+	// 記録した大きさ(バイト)
+	int size() const
+	{
+		return static_cast<int>(_data.size());
+	}
+	bool empty() const
+	{
+		return _count == 0;
+	}
+
+private:
+	size_t reserve_command(command_type_t type, size_t size)
+	{
+		header h;
+		h.type = static_cast<unsigned int>(type);
+		h.size = static_cast<unsigned int>(size);
+		const size_t at = _data.size();
+		_data.resize(at + sizeof(h) + size);
+		std::memcpy(&_data[at], &h, sizeof(h));
+		++_count;
+		return at + sizeof(h);
+	}
+	template <typename T>
+	void push(command_type_t type, const T& c)
+	{
+		const size_t at = reserve_command(type, sizeof(c));
+		std::memcpy(&_data[at], &c, sizeof(c));
+	}
+	void push_uniform(GLint location, GLenum type, GLsizei count, const void* data, int size)
+	{
+		uniform_cmd c = { location, type, count };
+		const size_t at = reserve_command(command_type::uniform, sizeof(c) + size);
+		std::memcpy(&_data[at], &c, sizeof(c));
+		std::memcpy(&_data[at + sizeof(c)], data, size);
+	}
+
+	template <typename T>
+	static T read(const char* p)
+	{
+		T c;
+		std::memcpy(&c, p, sizeof(c));
+		return c;
+	}
+
+	static void execute(command_type_t type, const char* p)
+	{
+		switch (type)
+		{
+		case command_type::bind_program:
+			glUseProgram(read<id_cmd>(p).id);
+			break;
+		case command_type::bind_vertex_array:
+			glBindVertexArray(read<id_cmd>(p).id);
+			break;
+		case command_type::bind_vertex_buffer:
+			{
+				const vertex_buffer_cmd c = read<vertex_buffer_cmd>(p);
+				glBindVertexBuffer(c.binding, c.id, c.offset, c.stride);
+			}
+			break;
+		case command_type::bind_index_buffer:
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, read<id_cmd>(p).id);
+			break;
+		case command_type::bind_texture:
+			{
+				const texture_cmd c = read<texture_cmd>(p);
+				glActiveTexture(GL_TEXTURE0 + c.unit);
+				glBindTexture(c.target, c.id);
+			}
+			break;
+		case command_type::bind_sampler:
+			{
+				const sampler_cmd c = read<sampler_cmd>(p);
+				glBindSampler(c.unit, c.id);
+			}
+			break;
+		case command_type::bind_buffer_range:
+			{
+				const buffer_range_cmd c = read<buffer_range_cmd>(p);
+				glBindBufferRange(c.target, c.point, c.id, c.offset, c.size);
+			}
+			break;
+		case command_type::uniform:
+			execute_uniform(read<uniform_cmd>(p), p + sizeof(uniform_cmd));
+			break;
+		case command_type::draw_arrays:
+			{
+				const arrays_cmd c = read<arrays_cmd>(p);
+				if (c.instances == 1 && c.base_instance == 0)
+				{
+					glDrawArrays(c.mode, c.first, c.count);
+				}
+				else
+				{
+					glDrawArraysInstancedBaseInstance(c.mode, c.first, c.count, c.instances, c.base_instance);
+				}
+			}
+			break;
+		case command_type::draw_elements:
+			{
+				const elements_cmd c = read<elements_cmd>(p);
+				if (c.instances != 1 || c.base_instance != 0)
+				{
+					glDrawElementsInstancedBaseVertexBaseInstance(c.mode, c.count, c.type, POCKET_BUFFER_OFFSET(c.offset),
+						c.instances, c.base_vertex, c.base_instance);
+				}
+				else if (c.base_vertex != 0)
+				{
+					glDrawElementsBaseVertex(c.mode, c.count, c.type, POCKET_BUFFER_OFFSET(c.offset), c.base_vertex);
+				}
+				else
+				{
+					glDrawElements(c.mode, c.count, c.type, POCKET_BUFFER_OFFSET(c.offset));
+				}
+			}
+			break;
+		case command_type::draw_indirect:
+			{
+				const indirect_cmd c = read<indirect_cmd>(p);
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, c.id);
+				if (c.type != 0)
+				{
+					glDrawElementsIndirect(c.mode, c.type, POCKET_BUFFER_OFFSET(c.offset));
+				}
+				else
+				{
+					glDrawArraysIndirect(c.mode, POCKET_BUFFER_OFFSET(c.offset));
+				}
+			}
+			break;
+		case command_type::update:
+			{
+				// VAOのインデックスバッファを変えないようにGL_COPY_WRITE_BUFFERで書き込む
+				const update_cmd c = read<update_cmd>(p);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, c.id);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, c.offset, c.size, p + sizeof(update_cmd));
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			}
+			break;
+		case command_type::copy:
+			{
+				const copy_cmd c = read<copy_cmd>(p);
+				glBindBuffer(GL_COPY_READ_BUFFER, c.read);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, c.write);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, c.read_offset, c.write_offset, c.size);
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	static void execute_uniform(const uniform_cmd& c, const char* p)
+	{
+		// 値は詰めた時の位置のため揃っていない場合がある
+		const int max = 16;
+		if (c.type == GL_INT)
+		{
+			for (GLsizei i = 0; i < c.count; i += max)
+			{
+				int v[max];
+				const GLsizei n = std::min(max, c.count - i);
+				std::memcpy(v, p + sizeof(int) * i, sizeof(int) * n);
+				glUniform1iv(c.location + i, n, v);
+			}
+			return;
+		}
+		if (c.type == GL_FLOAT)
+		{
+			for (GLsizei i = 0; i < c.count; i += max)
+			{
+				float v[max];
+				const GLsizei n = std::min(max, c.count - i);
+				std::memcpy(v, p + sizeof(float) * i, sizeof(float) * n);
+				glUniform1fv(c.location + i, n, v);
+			}
+			return;
+		}
+
+		float v[max];
+		switch (c.type)
+		{
+		case GL_FLOAT_VEC2:
+			std::memcpy(v, p, sizeof(float) * 2);
+			glUniform2fv(c.location, 1, v);
+			break;
+		case GL_FLOAT_VEC3:
+			std::memcpy(v, p, sizeof(float) * 3);
+			glUniform3fv(c.location, 1, v);
+			break;
+		case GL_FLOAT_VEC4:
+			std::memcpy(v, p, sizeof(float) * 4);
+			glUniform4fv(c.location, 1, v);
+			break;
+		case GL_FLOAT_MAT3:
+			std::memcpy(v, p, sizeof(float) * 9);
+			glUniformMatrix3fv(c.location, 1, GL_FALSE, v);
+			break;
+		case GL_FLOAT_MAT4:
+			std::memcpy(v, p, sizeof(float) * 16);
+			glUniformMatrix4fv(c.location, 1, GL_FALSE, v);
+			break;
+		default:
+			break;
+		}
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const command_list& v)
+{
+	os << io::widen("command_list: {") << std::endl <<
+		io::tab << io::widen("count: ") << v.count() << std::endl <<
+		io::tab << io::widen("size: ") << v.size() << std::endl <<
+		io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_COMMAND_LIST_H__
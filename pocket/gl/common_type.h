@@ -134,6 +134,39 @@ struct filter_type
 };
 typedef filter_type::type filter_type_t;
 
+//---------------------------------------------------------------------------------------
+// GL側テクスチャ種類値
+//---------------------------------------------------------------------------------------
+struct texture_type
+{
+	enum type
+	{
+		texture_2d = GL_TEXTURE_2D,
+		texture_2d_array = GL_TEXTURE_2D_ARRAY,
+		texture_cube = GL_TEXTURE_CUBE_MAP,
+		texture_3d = GL_TEXTURE_3D,
+
+		unknown = 0,
+	};
+};
+typedef texture_type::type texture_type_t;
+
+//---------------------------------------------------------------------------------------
+// GL側フレームバッファのバインド先
+//---------------------------------------------------------------------------------------
+struct framebuffer_type
+{
+	enum type
+	{
+		framebuffer = GL_FRAMEBUFFER,
+		draw = GL_DRAW_FRAMEBUFFER,
+		read = GL_READ_FRAMEBUFFER,
+
+		unknown = 0,
+	};
+};
+typedef framebuffer_type::type framebuffer_type_t;
+
 //---------------------------------------------------------------------------------------
 // GL側バッファバインディング種類値
 //---------------------------------------------------------------------------------------
@@ -372,6 +405,42 @@ struct clear_type
 };
 typedef clear_type::type clear_type_t;
 
+//---------------------------------------------------------------------------------------
+// GL側クエリ種類値
+//---------------------------------------------------------------------------------------
+struct query_type
+{
+	enum type
+	{
+		time_elapsed = GL_TIME_ELAPSED,
+		timestamp = GL_TIMESTAMP,
+
+		samples_passed = GL_SAMPLES_PASSED,
+		any_samples_passed = GL_ANY_SAMPLES_PASSED,
+
+		primitives_generated = GL_PRIMITIVES_GENERATED,
+		transform_feedback_primitives_written = GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN,
+
+		unknown = 0,
+	};
+};
+typedef query_type::type query_type_t;
+
+//---------------------------------------------------------------------------------------
+// バッファブロックのメモリ配置
+//---------------------------------------------------------------------------------------
+struct block_layout_type
+{
+	enum type
+	{
+		std140 = 1, // uniform, shader_storage
+		std430 = 2, // shader_storageのみ
+
+		unknown = 0,
+	};
+};
+typedef block_layout_type::type block_layout_type_t;
+
 } // namespace gl
 } // namespace pocket
 
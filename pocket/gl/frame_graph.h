@@ -0,0 +1,1007 @@
+﻿#ifndef __POCKET_GL_FRAME_GRAPH_H__
+#define __POCKET_GL_FRAME_GRAPH_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "texture.h"
+#include "framebuffer.h"
+#include "render_target_pool.h"
+#include "../io.h"
+#ifdef POCKET_USE_CXX11
+#include <functional>
+#include <vector>
+#include <string>
+#include <algorithm> // for std::min, std::max
+#endif // POCKET_USE_CXX11
+
+namespace pocket
+{
+namespace gl
+{
+
+#ifdef POCKET_USE_CXX11
+
+// forward
+class frame_graph;
+
+//---------------------------------------------------------------------------------------
+// フレームグラフ
+// パスが読み書きするテクスチャ, レンダーバッファ, バッファ, フレームバッファを宣言し, compileで実行するパスと寿命を決める
+// パスは追加した順に実行するため, 書き込むパスを先に追加すること(書き込む前に読む一時的なリソースはエラーになる)
+// - 結果がどこにも使われないパスは実行しない(外から渡したものへの書き込みとside_effectのパスが起点)
+// - 一時的な描画先は最初に使うパスの前に借り, 最後に使うパスの後に返す
+//   返したものは同じ形式と大きさの後のパスに使い回すため, 同時に生きていない描画先はメモリを共有する
+// - イメージやSSBOへの書き込みの後, それを使うパスの前にだけ必要なビットでglMemoryBarrierを呼ぶ
+//   待っていない書き込みは返した実体に残し, 次にその実体を借りたものに引き継ぐ
+// - 一時的な取り付け先は最初に使う前と最後に使った後でglInvalidateFramebufferを呼ぶ
+// 毎フレームclearから組み直す
+//
+// gl::frame_graph graph;
+// gl::frame_graph::resource_id backbuffer = graph.import_framebuffer("backbuffer", 0, w, h);
+// gl::frame_graph::resource_id color = graph.create_texture("color", GL_RGBA16F, w, h);
+// gl::frame_graph::resource_id depth = graph.create_renderbuffer("depth", GL_DEPTH_COMPONENT24, w, h);
+// gl::frame_graph::pass_id scene = graph.add_pass("scene", [&](gl::frame_graph&) { draw... });
+// graph.attach(scene, GL_COLOR_ATTACHMENT0, color);
+// graph.attach(scene, GL_DEPTH_ATTACHMENT, depth);
+// gl::frame_graph::pass_id tonemap = graph.add_pass("tonemap", [&](gl::frame_graph& g) { g.get_texture(color).bind(0); ... });
+// graph.read(tonemap, color, gl::frame_graph::access::sampled);
+// graph.attach(tonemap, GL_COLOR_ATTACHMENT0, backbuffer);
+// graph.execute();
+// graph.clear();
+//---------------------------------------------------------------------------------------
+class frame_graph
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// リソースとパスの番号(-1は無効)
+	typedef int resource_id;
+	typedef int pass_id;
+
+	// パスの処理
+	typedef std::function<void (frame_graph&)> pass_function;
+
+	// パスからの使い方
+	struct access
+	{
+		enum type
+		{
+			sampled, // テクスチャの読み込み
+			image, // イメージの読み書き(imageLoad, imageStore)
+			storage, // SSBOの読み書き
+			uniform, // UBO
+			vertex, // 頂点バッファ
+			index, // インデックスバッファ
+			indirect, // 間接描画, ディスパッチの引数
+			pixel, // ピクセルバッファからの転送
+			copy, // glCopy*, glBufferSubData
+			attachment // フレームバッファに取り付けて描画
+		};
+	};
+	typedef access::type access_t;
+
+private:
+	enum resource_kind
+	{
+		kind_texture,
+		kind_renderbuffer,
+		kind_buffer,
+		kind_framebuffer
+	};
+
+	struct resource
+	{
+		std::string name;
+		resource_kind kind;
+		bool imported;
+		// 一時的なものの形式
+		GLenum format;
+		int width;
+		int height;
+		int samples; // テクスチャはレベル数
+		buffer_type_t type;
+		int size;
+		// 実体
+		texture* tex;
+		renderbuffer* rb;
+		gl::buffer* buf;
+		GLuint fbo;
+		// compileで決まるもの
+		int refcount;
+		int first; // 最初に使うパス
+		int last; // 最後に使うパス
+		std::vector<pass_id> writers;
+		GLbitfield dirty; // 待っていない書き込みの後に必要なバリア
+	};
+
+	struct use
+	{
+		resource_id id;
+		access_t how;
+		GLenum attachment; // 取り付ける時のみ
+	};
+
+	struct pass
+	{
+		std::string name;
+		pass_function func;
+		std::vector<use> reads;
+		std::vector<use> writes;
+		bool side_effect;
+		bool culled;
+		int refcount;
+	};
+
+	// 返した実体に残っている待っていない書き込み
+	struct pending
+	{
+		const void* object;
+		resource_kind kind;
+		GLbitfield dirty;
+		int frames; // 返してからのフレーム数
+	};
+
+	// 一時的なバッファ
+	struct buffer_slot
+	{
+		gl::buffer* buf;
+		buffer_type_t type;
+		int size;
+		bool used;
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::vector<resource> _resources;
+	std::vector<pass> _passes;
+	std::vector<buffer_slot> _buffers;
+	std::vector<pending> _pending;
+	render_target_pool _pool;
+	bool _compiled;
+	int _barriers; // 最後のexecuteでglMemoryBarrierを呼んだ回数
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	frame_graph() :
+		_compiled(false),
+		_barriers(0),
+		_error_bitfield(0)
+	{}
+	~frame_graph()
+	{
+		finalize();
+	}
+
+private:
+	// 描画先を共有しないように複製は禁止
+	frame_graph(const frame_graph&);
+	frame_graph& operator = (const frame_graph&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 終了処理
+	// 一時的な描画先とバッファを全て削除する
+	void finalize()
+	{
+		clear();
+		for (size_t i = 0; i < _buffers.size(); ++i)
+		{
+			delete _buffers[i].buf;
+		}
+		_buffers.clear();
+		_pending.clear();
+		_pool.finalize();
+	}
+
+	// パスとリソースの宣言を消す
+	// 一時的な描画先とバッファは次のフレームで使い回すために残す
+	void clear()
+	{
+		_resources.clear();
+		_passes.clear();
+		_compiled = false;
+		_error_bitfield = 0;
+	}
+
+	// 一時的な2Dテクスチャ
+	resource_id create_texture(const std::string& name, GLenum format, int width, int height, int levels = 1)
+	{
+		resource& r = add_resource(name, kind_texture, false);
+		r.format = format;
+		r.width = width;
+		r.height = height;
+		r.samples = levels;
+		return static_cast<resource_id>(_resources.size() - 1);
+	}
+	// 一時的なレンダーバッファ
+	resource_id create_renderbuffer(const std::string& name, GLenum format, int width, int height, int samples = 0)
+	{
+		resource& r = add_resource(name, kind_renderbuffer, false);
+		r.format = format;
+		r.width = width;
+		r.height = height;
+		r.samples = samples;
+		return static_cast<resource_id>(_resources.size() - 1);
+	}
+	// 一時的なバッファ
+	resource_id create_buffer(const std::string& name, buffer_type_t type, int size)
+	{
+		resource& r = add_resource(name, kind_buffer, false);
+		r.type = type;
+		r.size = size;
+		return static_cast<resource_id>(_resources.size() - 1);
+	}
+
+	// 外から渡すリソース
+	// 書き込むパスは消さない
+	resource_id import_texture(const std::string& name, texture& t)
+	{
+		resource& r = add_resource(name, kind_texture, true);
+		r.tex = &t;
+		r.width = t.width();
+		r.height = t.height();
+		return static_cast<resource_id>(_resources.size() - 1);
+	}
+	resource_id import_renderbuffer(const std::string& name, renderbuffer& rb)
+	{
+		resource& r = add_resource(name, kind_renderbuffer, true);
+		r.rb = &rb;
+		r.width = rb.width();
+		r.height = rb.height();
+		return static_cast<resource_id>(_resources.size() - 1);
+	}
+	resource_id import_buffer(const std::string& name, gl::buffer& b)
+	{
+		resource& r = add_resource(name, kind_buffer, true);
+		r.buf = &b;
+		return static_cast<resource_id>(_resources.size() - 1);
+	}
+	// フレームバッファ(0は既定のフレームバッファ)
+	resource_id import_framebuffer(const std::string& name, GLuint fbo, int width, int height)
+	{
+		resource& r = add_resource(name, kind_framebuffer, true);
+		r.fbo = fbo;
+		r.width = width;
+		r.height = height;
+		return static_cast<resource_id>(_resources.size() - 1);
+	}
+	resource_id import_framebuffer(const std::string& name, const framebuffer& fb)
+	{
+		return import_framebuffer(name, fb.get(), fb.width(), fb.height());
+	}
+
+	// パスの追加
+	// side_effectがtrueなら結果を使うパスがなくても実行する
+	pass_id add_pass(const std::string& name, const pass_function& func, bool side_effect = false)
+	{
+		_passes.push_back(pass());
+		pass& p = _passes.back();
+		p.name = name;
+		p.func = func;
+		p.side_effect = side_effect;
+		p.culled = false;
+		p.refcount = 0;
+		_compiled = false;
+		return static_cast<pass_id>(_passes.size() - 1);
+	}
+
+	// パスが読み込むリソース
+	void read(pass_id p, resource_id r, access_t how)
+	{
+		if (!check(p, r))
+		{
+			return;
+		}
+		use u = { r, how, GL_NONE };
+		_passes[p].reads.push_back(u);
+		_compiled = false;
+	}
+	// パスが書き込むリソース
+	void write(pass_id p, resource_id r, access_t how)
+	{
+		if (!check(p, r))
+		{
+			return;
+		}
+		use u = { r, how, GL_NONE };
+		_passes[p].writes.push_back(u);
+		_compiled = false;
+	}
+	// パスの描画先に取り付ける
+	// 外から渡したフレームバッファはattachmentに関係なくそのまま使う
+	void attach(pass_id p, GLenum attachment, resource_id r)
+	{
+		if (!check(p, r))
+		{
+			return;
+		}
+		use u = { r, access::attachment, attachment };
+		_passes[p].writes.push_back(u);
+		_compiled = false;
+	}
+
+	// 使わないパスを消し, リソースの寿命を決める
+	// 実行するパスの数を返す
+	int compile()
+	{
+		const int np = static_cast<int>(_passes.size());
+		const int nr = static_cast<int>(_resources.size());
+		for (int i = 0; i < nr; ++i)
+		{
+			resource& r = _resources[i];
+			r.refcount = 0;
+			r.first = np;
+			r.last = -1;
+			r.writers.clear();
+		}
+
+		// パスの参照数は書き込みの数, リソースの参照数は読み込みの数
+		for (int i = 0; i < np; ++i)
+		{
+			pass& p = _passes[i];
+			p.culled = false;
+			p.refcount = static_cast<int>(p.writes.size());
+			for (size_t k = 0; k < p.writes.size(); ++k)
+			{
+				resource& r = _resources[p.writes[k].id];
+				r.writers.push_back(i);
+				if (r.imported)
+				{
+					p.side_effect = true;
+				}
+			}
+			for (size_t k = 0; k < p.reads.size(); ++k)
+			{
+				++_resources[p.reads[k].id].refcount;
+			}
+		}
+
+		// 読まれないリソースから書き込んだパスを辿って消す
+		std::vector<resource_id> unused;
+		for (int i = 0; i < nr; ++i)
+		{
+			if (_resources[i].refcount == 0 && !_resources[i].imported)
+			{
+				unused.push_back(i);
+			}
+		}
+		// 何も書き込まないパス
+		for (int i = 0; i < np; ++i)
+		{
+			if (_passes[i].refcount == 0 && !_passes[i].side_effect)
+			{
+				cull(i, unused);
+			}
+		}
+		while (!unused.empty())
+		{
+			const resource& r = _resources[unused.back()];
+			std::vector<pass_id> writers(r.writers);
+			unused.pop_back();
+			for (size_t k = 0; k < writers.size(); ++k)
+			{
+				pass& p = _passes[writers[k]];
+				if (!p.culled && !p.side_effect && --p.refcount == 0)
+				{
+					cull(writers[k], unused);
+				}
+			}
+		}
+
+		// 実行するパスから寿命を決める
+		int n = 0;
+		for (int i = 0; i < np; ++i)
+		{
+			const pass& p = _passes[i];
+			if (p.culled)
+			{
+				continue;
+			}
+			++n;
+			for (size_t k = 0; k < p.reads.size(); ++k)
+			{
+				// 一時的なものを書き込むパスより前に読んでいる
+				const resource& r = _resources[p.reads[k].id];
+				if (!r.imported && (r.writers.empty() || r.writers.front() >= i))
+				{
+					_error_bitfield |= error_invalid_data;
+				}
+				extend(p.reads[k].id, i);
+			}
+			for (size_t k = 0; k < p.writes.size(); ++k)
+			{
+				extend(p.writes[k].id, i);
+			}
+		}
+		_compiled = true;
+		return n;
+	}
+
+	// パスを順番に実行する
+	// compileしていなければcompileする
+	void execute()
+	{
+		if (!_compiled)
+		{
+			compile();
+		}
+		_barriers = 0;
+		for (size_t i = 0; i < _resources.size(); ++i)
+		{
+			_resources[i].dirty = 0;
+		}
+
+		const int np = static_cast<int>(_passes.size());
+		for (int i = 0; i < np; ++i)
+		{
+			pass& p = _passes[i];
+			if (p.culled)
+			{
+				continue;
+			}
+			acquire(i);
+			barrier(p);
+
+			framebuffer* fb = NULL;
+			const bool target = bind_target(p, fb);
+			if (fb != NULL)
+			{
+				invalidate(i, p, *fb, true);
+			}
+			if (p.func)
+			{
+				p.func(*this);
+			}
+			if (fb != NULL)
+			{
+				fb->bind();
+				invalidate(i, p, *fb, false);
+			}
+			if (target)
+			{
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			}
+
+			// シェーダーからの書き込みは後で使う前にバリアが必要
+			for (size_t k = 0; k < p.writes.size(); ++k)
+			{
+				const use& u = p.writes[k];
+				if (u.how == access::image || u.how == access::storage)
+				{
+					_resources[u.id].dirty = GL_ALL_BARRIER_BITS;
+				}
+			}
+			release(i);
+		}
+
+
+		// プールが削除した描画先(next_frameの既定の2フレームより長く借りられなかったもの)は捨てる
+		for (size_t i = 0; i < _pending.size(); )
+		{
+			pending& e = _pending[i];
+			if (e.kind != kind_buffer && ++e.frames > 2)
+			{
+				_pending.erase(_pending.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+		_pool.next_frame();
+	}
+
+	// 実行中のパスから使うリソースの実体
+	texture& get_texture(resource_id r)
+	{
+		return *_resources[r].tex;
+	}
+	renderbuffer& get_renderbuffer(resource_id r)
+	{
+		return *_resources[r].rb;
+	}
+	gl::buffer& get_buffer(resource_id r)
+	{
+		return *_resources[r].buf;
+	}
+
+	// パスを実行しないか
+	bool culled(pass_id p) const
+	{
+		return _passes[p].culled;
+	}
+	// リソースを使う最初と最後のパス(使われなければfirst > last)
+	int first(resource_id r) const
+	{
+		return _resources[r].first;
+	}
+	int last(resource_id r) const
+	{
+		return _resources[r].last;
+	}
+	const std::string& name(pass_id p) const
+	{
+		return _passes[p].name;
+	}
+
+	// パスの数
+	int passes() const
+	{
+		return static_cast<int>(_passes.size());
+	}
+	// リソースの数
+	int resources() const
+	{
+		return static_cast<int>(_resources.size());
+	}
+	// 最後のexecuteでglMemoryBarrierを呼んだ回数
+	int barriers() const
+	{
+		return _barriers;
+	}
+
+	// 一時的な描画先
+	const render_target_pool& pool() const
+	{
+		return _pool;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_invalid_index))
+		{
+			return "invalid pass, resource or attachment.";
+		}
+		if (error_status(error_invalid_data))
+		{
+			return "read before written.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	resource& add_resource(const std::string& name, resource_kind kind, bool imported)
+	{
+		_resources.push_back(resource());
+		resource& r = _resources.back();
+		r.name = name;
+		r.kind = kind;
+		r.imported = imported;
+		r.format = 0;
+		r.width = 0;
+		r.height = 0;
+		r.samples = 0;
+		r.type = buffer_type::shader_storage;
+		r.size = 0;
+		r.tex = NULL;
+		r.rb = NULL;
+		r.buf = NULL;
+		r.fbo = 0;
+		r.refcount = 0;
+		r.first = 0;
+		r.last = -1;
+		r.dirty = 0;
+		_compiled = false;
+		return r;
+	}
+
+	bool check(pass_id p, resource_id r)
+	{
+		if (p < 0 || p >= passes() || r < 0 || r >= resources())
+		{
+			_error_bitfield |= error_invalid_index;
+			return false;
+		}
+		return true;
+	}
+
+	void cull(pass_id i, std::vector<resource_id>& unused)
+	{
+		pass& p = _passes[i];
+		p.culled = true;
+		for (size_t k = 0; k < p.reads.size(); ++k)
+		{
+			resource& r = _resources[p.reads[k].id];
+			if (--r.refcount == 0 && !r.imported)
+			{
+				unused.push_back(p.reads[k].id);
+			}
+		}
+	}
+
+	void extend(resource_id id, int i)
+	{
+		resource& r = _resources[id];
+		r.first = std::min(r.first, i);
+		r.last = std::max(r.last, i);
+	}
+
+	// 使い方ごとに前の書き込みを待つバリア
+	static GLbitfield barrier_bits(access_t how)
+	{
+		switch (how)
+		{
+		case access::sampled:
+			return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case access::image:
+			return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case access::storage:
+			return GL_SHADER_STORAGE_BARRIER_BIT;
+		case access::uniform:
+			return GL_UNIFORM_BARRIER_BIT;
+		case access::vertex:
+			return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+		case access::index:
+			return GL_ELEMENT_ARRAY_BARRIER_BIT;
+		case access::indirect:
+			return GL_COMMAND_BARRIER_BIT;
+		case access::pixel:
+			return GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT;
+		case access::copy:
+			return GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT;
+		case access::attachment:
+			return GL_FRAMEBUFFER_BARRIER_BIT;
+		default:
+			break;
+		}
+		return 0;
+	}
+
+	// パスが使う前に, 待っていないシェーダーからの書き込みがあれば必要なビットだけまとめて待つ
+	void barrier(const pass& p)
+	{
+		GLbitfield bits = 0;
+		for (int n = 0; n < 2; ++n)
+		{
+			const std::vector<use>& uses = n == 0 ? p.reads : p.writes;
+			for (size_t k = 0; k < uses.size(); ++k)
+			{
+				resource& r = _resources[uses[k].id];
+				const GLbitfield b = r.dirty & barrier_bits(uses[k].how);
+				bits |= b;
+				r.dirty &= ~b;
+			}
+		}
+		if (bits != 0)
+		{
+			glMemoryBarrier(bits);
+			++_barriers;
+			// バリアは全ての書き込みを待つため, 同じビットは他のリソースからも消す
+			for (size_t k = 0; k < _resources.size(); ++k)
+			{
+				_resources[k].dirty &= ~bits;
+			}
+			for (size_t k = 0; k < _pending.size(); )
+			{
+				_pending[k].dirty &= ~bits;
+				if (_pending[k].dirty == 0)
+				{
+					_pending.erase(_pending.begin() + k);
+				}
+				else
+				{
+					++k;
+				}
+			}
+		}
+	}
+
+	// 最初に使うパスの前に一時的なものを借りる
+	void acquire(int i)
+	{
+		for (size_t k = 0; k < _resources.size(); ++k)
+		{
+			resource& r = _resources[k];
+			if (r.imported || r.first != i)
+			{
+				continue;
+			}
+			switch (r.kind)
+			{
+			case kind_texture:
+				r.tex = &_pool.acquire_texture(r.format, r.width, r.height, r.samples);
+				break;
+			case kind_renderbuffer:
+				r.rb = &_pool.acquire_renderbuffer(r.format, r.width, r.height, r.samples);
+				break;
+			case kind_buffer:
+				r.buf = acquire_buffer(r.type, r.size);
+				break;
+			default:
+				break;
+			}
+			// 前に同じ実体を使っていたものの待っていない書き込みを引き継ぐ
+			const void* object = target(r);
+			for (size_t n = 0; n < _pending.size(); ++n)
+			{
+				if (_pending[n].object == object)
+				{
+					r.dirty |= _pending[n].dirty;
+					_pending.erase(_pending.begin() + n);
+					break;
+				}
+			}
+		}
+	}
+	// 最後に使ったパスの後に返す
+	void release(int i)
+	{
+		for (size_t k = 0; k < _resources.size(); ++k)
+		{
+			resource& r = _resources[k];
+			if (r.imported || r.last != i)
+			{
+				continue;
+			}
+			if (r.dirty != 0)
+			{
+				pending e = { target(r), r.kind, r.dirty, 0 };
+				_pending.push_back(e);
+			}
+			switch (r.kind)
+			{
+			case kind_texture:
+				_pool.release(*r.tex);
+				break;
+			case kind_renderbuffer:
+				_pool.release(*r.rb);
+				break;
+			case kind_buffer:
+				release_buffer(r.buf);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	// 一時的なものの実体
+	static const void* target(const resource& r)
+	{
+		switch (r.kind)
+		{
+		case kind_texture:
+			return r.tex;
+		case kind_renderbuffer:
+			return r.rb;
+		case kind_buffer:
+			return r.buf;
+		default:
+			break;
+		}
+		return NULL;
+	}
+
+	// 同じ種類で足りる大きさのうち最も小さいものを使う
+	gl::buffer* acquire_buffer(buffer_type_t type, int size)
+	{
+		buffer_slot* found = NULL;
+		for (size_t i = 0; i < _buffers.size(); ++i)
+		{
+			buffer_slot& s = _buffers[i];
+			if (!s.used && s.type == type && s.size >= size && (found == NULL || s.size < found->size))
+			{
+				found = &s;
+			}
+		}
+		if (found == NULL)
+		{
+			buffer_slot s;
+			s.buf = new gl::buffer(type, buffer_usage_type::dynamic_copy, size, NULL);
+			s.type = type;
+			s.size = size;
+			s.used = false;
+			_buffers.push_back(s);
+			found = &_buffers.back();
+		}
+		found->used = true;
+		return found->buf;
+	}
+	void release_buffer(gl::buffer* b)
+	{
+		for (size_t i = 0; i < _buffers.size(); ++i)
+		{
+			if (_buffers[i].buf == b)
+			{
+				_buffers[i].used = false;
+				return;
+			}
+		}
+	}
+
+	// パスの描画先をバインドしてビューポートを合わせる
+	// 一時的な取り付け先はプールのフレームバッファをfbに返す
+	// 色はGL_COLOR_ATTACHMENT0から詰めて取り付けること
+	// 色はテクスチャかレンダーバッファのどちらかに揃え, 深度テクスチャはテクスチャの色とだけ組み合わせられる
+	bool bind_target(const pass& p, framebuffer*& fb)
+	{
+		const texture* colors[framebuffer::max_color_attachments] = {};
+		const renderbuffer* rb_colors[framebuffer::max_color_attachments] = {};
+		int ncolor = 0;
+		int nrb = 0;
+		const texture* depth_texture = NULL;
+		const renderbuffer* depth = NULL;
+		GLenum depth_attachment = GL_DEPTH_ATTACHMENT;
+		for (size_t k = 0; k < p.writes.size(); ++k)
+		{
+			const use& u = p.writes[k];
+			if (u.how != access::attachment)
+			{
+				continue;
+			}
+			const resource& r = _resources[u.id];
+			if (r.kind == kind_framebuffer)
+			{
+				glBindFramebuffer(GL_FRAMEBUFFER, r.fbo);
+				glViewport(0, 0, r.width, r.height);
+				return true;
+			}
+			const bool color = u.attachment >= GL_COLOR_ATTACHMENT0 &&
+				u.attachment < GL_COLOR_ATTACHMENT0 + framebuffer::max_color_attachments;
+			if (r.kind == kind_texture)
+			{
+				if (color)
+				{
+					colors[u.attachment - GL_COLOR_ATTACHMENT0] = r.tex;
+					ncolor = std::max(ncolor, static_cast<int>(u.attachment - GL_COLOR_ATTACHMENT0) + 1);
+				}
+				else
+				{
+					depth_texture = r.tex;
+					depth_attachment = u.attachment;
+				}
+			}
+			else if (r.kind == kind_renderbuffer)
+			{
+				if (color)
+				{
+					rb_colors[u.attachment - GL_COLOR_ATTACHMENT0] = r.rb;
+					nrb = std::max(nrb, static_cast<int>(u.attachment - GL_COLOR_ATTACHMENT0) + 1);
+				}
+				else
+				{
+					depth = r.rb;
+					depth_attachment = u.attachment;
+				}
+			}
+		}
+
+		for (int k = 0; k < ncolor; ++k)
+		{
+			if (colors[k] == NULL)
+			{
+				_error_bitfield |= error_invalid_index;
+				return false;
+			}
+		}
+		for (int k = 0; k < nrb; ++k)
+		{
+			if (rb_colors[k] == NULL)
+			{
+				_error_bitfield |= error_invalid_index;
+				return false;
+			}
+		}
+		// プールのフレームバッファで組み合わせられない取り付け先
+		if ((ncolor > 0 && nrb > 0) || (depth_texture != NULL && (nrb > 0 || depth != NULL)))
+		{
+			_error_bitfield |= error_invalid_index;
+			return false;
+		}
+
+		if (depth_texture != NULL)
+		{
+			fb = &_pool.acquire_framebuffer(colors, ncolor, *depth_texture, depth_attachment);
+		}
+		else if (ncolor > 0)
+		{
+			fb = &_pool.acquire_framebuffer(colors, ncolor, depth, depth_attachment);
+		}
+		else if (nrb > 0 || depth != NULL)
+		{
+			fb = &_pool.acquire_framebuffer(rb_colors, nrb, depth, depth_attachment);
+		}
+		if (fb == NULL)
+		{
+			return false;
+		}
+		fb->bind();
+		glViewport(0, 0, fb->width(), fb->height());
+		return true;
+	}
+
+	// 一時的な取り付け先の内容を捨てる
+	// beginがtrueなら最初に使う前, falseなら最後に使った後
+	void invalidate(int i, const pass& p, const framebuffer& fb, bool begin) const
+	{
+		GLenum attachments[framebuffer::max_color_attachments + 3];
+		int n = 0;
+		for (size_t k = 0; k < p.writes.size() && n < framebuffer::max_color_attachments + 3; ++k)
+		{
+			const use& u = p.writes[k];
+			const resource& r = _resources[u.id];
+			if (u.how != access::attachment || r.imported)
+			{
+				continue;
+			}
+			if ((begin && r.first == i) || (!begin && r.last == i))
+			{
+				attachments[n++] = u.attachment;
+			}
+		}
+		fb.invalidate(attachments, n);
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const frame_graph& v)
+{
+	os << io::widen("frame_graph: {") << std::endl <<
+		io::tab << io::widen("passes: ") << v.passes() << std::endl <<
+		io::tab << io::widen("resources: ") << v.resources() << std::endl <<
+		io::tab << io::widen("barriers: ") << v.barriers() << std::endl <<
+		io::tab << io::widen("targets: ") << v.pool().count() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+#endif // POCKET_USE_CXX11
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_FRAME_GRAPH_H__
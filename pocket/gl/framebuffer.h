@@ -0,0 +1,836 @@
+﻿#ifndef __POCKET_GL_FRAMEBUFFER_H__
+#define __POCKET_GL_FRAMEBUFFER_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "texture.h"
+#include "../io.h"
+#include <string>
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class renderbuffer;
+class framebuffer;
+
+//---------------------------------------------------------------------------------------
+// レンダーバッファ
+// サンプリングしない深度やMSAAの描画先に使う
+//---------------------------------------------------------------------------------------
+class renderbuffer
+{
+private:
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	GLuint _id;
+	GLenum _format;
+	int _width;
+	int _height;
+	int _samples;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	renderbuffer() :
+		_id(0),
+		_format(0),
+		_width(0),
+		_height(0),
+		_samples(0),
+		_error_bitfield(0)
+	{}
+	explicit renderbuffer(GLenum format, int width, int height, int samples = 0) :
+		_id(0),
+		_format(0),
+		_width(0),
+		_height(0),
+		_samples(0),
+		_error_bitfield(0)
+	{
+		initialize(format, width, height, samples);
+	}
+	renderbuffer(const renderbuffer& r) :
+		_id(r._id),
+		_format(r._format),
+		_width(r._width),
+		_height(r._height),
+		_samples(r._samples),
+		_error_bitfield(r._error_bitfield)
+	{}
+#ifdef POCKET_USE_CXX11
+	renderbuffer(renderbuffer&& r) POCKET_CXX11_NOEXCEPT :
+		_id(std::move(r._id)),
+		_format(std::move(r._format)),
+		_width(std::move(r._width)),
+		_height(std::move(r._height)),
+		_samples(std::move(r._samples)),
+		_error_bitfield(std::move(r._error_bitfield))
+	{
+		r._id = 0;
+		r._format = 0;
+		r._width = 0;
+		r._height = 0;
+		r._samples = 0;
+		r._error_bitfield = 0;
+	}
+#endif // POCKET_USE_CXX11
+	~renderbuffer()
+	{
+		finalize();
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	// samplesが0でなければマルチサンプル
+	bool initialize(GLenum format, int width, int height, int samples = 0)
+	{
+		finalize();
+
+		if (width < 1 || height < 1 || samples < 0)
+		{
+			_error_bitfield |= error_invalid_data;
+			return false;
+		}
+
+		glGenRenderbuffers(1, &_id);
+		if (_id == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+		glBindRenderbuffer(GL_RENDERBUFFER, _id);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		_format = format;
+		_width = width;
+		_height = height;
+		_samples = samples;
+		return true;
+	}
+
+	// 終了処理
+	void finalize()
+	{
+		if (_id != 0)
+		{
+			glDeleteRenderbuffers(1, &_id);
+			_id = 0;
+		}
+		_format = 0;
+		_width = 0;
+		_height = 0;
+		_samples = 0;
+		_error_bitfield = 0;
+	}
+
+	// 内部形式
+	GLenum format() const
+	{
+		return _format;
+	}
+	int width() const
+	{
+		return _width;
+	}
+	int height() const
+	{
+		return _height;
+	}
+	// サンプル数(マルチサンプルでなければ0)
+	int samples() const
+	{
+		return _samples;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_invalid_data))
+		{
+			return "invalid size.";
+		}
+		if (error_status(error_creating))
+		{
+			return "glGenRenderbuffers().";
+		}
+		if (_id == 0)
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		if (_id == 0 ||
+			_error_bitfield != 0)
+		{
+			return false;
+		}
+		return glIsRenderbuffer(_id) == GL_TRUE;
+	}
+
+	// ハンドルの取得
+	GLuint& get()
+	{
+		return _id;
+	}
+	const GLuint& get() const
+	{
+		return _id;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+	bool operator == (const renderbuffer& r) const
+	{
+		return _id == r._id;
+	}
+	bool operator != (const renderbuffer& r) const
+	{
+		return !(*this == r);
+	}
+
+	renderbuffer& operator = (const renderbuffer& r)
+	{
+		_id = r._id;
+		_format = r._format;
+		_width = r._width;
+		_height = r._height;
+		_samples = r._samples;
+		_error_bitfield = r._error_bitfield;
+		return *this;
+	}
+#ifdef POCKET_USE_CXX11
+	renderbuffer& operator = (renderbuffer&& r) POCKET_CXX11_NOEXCEPT
+	{
+		_id = std::move(r._id);
+		_format = std::move(r._format);
+		_width = std::move(r._width);
+		_height = std::move(r._height);
+		_samples = std::move(r._samples);
+		_error_bitfield = std::move(r._error_bitfield);
+		r._id = 0;
+		r._format = 0;
+		r._width = 0;
+		r._height = 0;
+		r._samples = 0;
+		r._error_bitfield = 0;
+		return *this;
+	}
+
+	renderbuffer& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+};
+
+//---------------------------------------------------------------------------------------
+// フレームバッファ
+// 取り付けた色の出力先は番号順にglDrawBuffersへ設定する
+// 描画の後に使わない深度やMSAAの取り付け先はtransientで印を付け, invalidate_transientで捨てる
+// タイル型のGPUではメモリへの書き戻しと読み込みが省かれる
+//
+// gl::framebuffer fb;
+// fb.initialize();
+// fb.attach(GL_COLOR_ATTACHMENT0, msaa_color);
+// fb.attach(GL_DEPTH_ATTACHMENT, msaa_depth);
+// fb.transient(GL_COLOR_ATTACHMENT0);
+// fb.transient(GL_DEPTH_ATTACHMENT);
+// fb.bind();
+// fb.invalidate_transient(); // 前の内容を読み込まない
+// draw...
+// fb.resolve(resolved); // MSAAの解決
+// fb.bind();
+// fb.invalidate_transient(); // 書き戻さない
+//---------------------------------------------------------------------------------------
+class framebuffer
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	typedef binder<framebuffer> binder_type;
+
+private:
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	GLuint _id;
+	int _width;
+	int _height;
+	unsigned int _attached; // 取り付けた場所(attachment_bit)
+	unsigned int _transient; // 捨ててよい場所
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// 扱う色の出力先の数
+	static const int max_color_attachments = 8;
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	framebuffer() :
+		_id(0),
+		_width(0),
+		_height(0),
+		_attached(0),
+		_transient(0),
+		_error_bitfield(0)
+	{}
+	framebuffer(const framebuffer& f) :
+		_id(f._id),
+		_width(f._width),
+		_height(f._height),
+		_attached(f._attached),
+		_transient(f._transient),
+		_error_bitfield(f._error_bitfield)
+	{}
+#ifdef POCKET_USE_CXX11
+	framebuffer(framebuffer&& f) POCKET_CXX11_NOEXCEPT :
+		_id(std::move(f._id)),
+		_width(std::move(f._width)),
+		_height(std::move(f._height)),
+		_attached(std::move(f._attached)),
+		_transient(std::move(f._transient)),
+		_error_bitfield(std::move(f._error_bitfield))
+	{
+		f._id = 0;
+		f._width = 0;
+		f._height = 0;
+		f._attached = 0;
+		f._transient = 0;
+		f._error_bitfield = 0;
+	}
+#endif // POCKET_USE_CXX11
+	~framebuffer()
+	{
+		finalize();
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	bool initialize()
+	{
+		finalize();
+
+		glGenFramebuffers(1, &_id);
+		if (_id == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+		// バインドして作成する
+		glBindFramebuffer(GL_FRAMEBUFFER, _id);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return true;
+	}
+
+	// 終了処理
+	// 取り付けたテクスチャとレンダーバッファは削除しない
+	void finalize()
+	{
+		if (_id != 0)
+		{
+			glDeleteFramebuffers(1, &_id);
+			_id = 0;
+		}
+		_width = 0;
+		_height = 0;
+		_attached = 0;
+		_transient = 0;
+		_error_bitfield = 0;
+	}
+
+	// テクスチャのレベルを取り付ける
+	// 配列, キューブマップ, 3Dは全ての層を取り付ける(レイヤー描画)
+	bool attach(GLenum attachment, const texture& t, int level = 0)
+	{
+		if (!begin(attachment))
+		{
+			return false;
+		}
+		glFramebufferTexture(GL_FRAMEBUFFER, attachment, t.get(), level);
+		end(attachment, t.level_width(level), t.level_height(level));
+		return true;
+	}
+	// 層を1枚取り付ける(キューブマップは面)
+	bool attach_layer(GLenum attachment, const texture& t, int layer, int level = 0)
+	{
+		if (!begin(attachment))
+		{
+			return false;
+		}
+		if (t.target() == texture_type::texture_cube)
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, t.get(), level);
+		}
+		else
+		{
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, attachment, t.get(), level, layer);
+		}
+		end(attachment, t.level_width(level), t.level_height(level));
+		return true;
+	}
+	// レンダーバッファを取り付ける
+	bool attach(GLenum attachment, const renderbuffer& r)
+	{
+		if (!begin(attachment))
+		{
+			return false;
+		}
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, r.get());
+		end(attachment, r.width(), r.height());
+		return true;
+	}
+	// 取り外す
+	void detach(GLenum attachment)
+	{
+		if (!begin(attachment))
+		{
+			return;
+		}
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, 0);
+		const unsigned int bit = attachment_bit(attachment);
+		_attached &= ~bit;
+		_transient &= ~bit;
+		update_draw_buffers();
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	// 取り付けているか
+	bool attached(GLenum attachment) const
+	{
+		return (_attached & attachment_bit(attachment)) != 0;
+	}
+
+	// 描画の後に内容を使わない取り付け先として印を付ける
+	void transient(GLenum attachment, bool b = true)
+	{
+		const unsigned int bit = attachment_bit(attachment);
+		if (b)
+		{
+			_transient |= bit;
+		}
+		else
+		{
+			_transient &= ~bit;
+		}
+	}
+	bool transient(GLenum attachment) const
+	{
+		return (_transient & attachment_bit(attachment)) != 0;
+	}
+
+	// 内容を捨てる(glInvalidateFramebuffer)
+	// 描画先にバインドしている状態で呼ぶ
+	void invalidate(const GLenum* attachments, int count) const
+	{
+		if (count > 0)
+		{
+			glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, count, attachments);
+		}
+	}
+	template <int N>
+	void invalidate(POCKET_CREF_ARRAY_ARG(GLenum, attachments, N)) const
+	{
+		invalidate(&attachments[0], N);
+	}
+	void invalidate(GLenum attachment) const
+	{
+		invalidate(&attachment, 1);
+	}
+	// transientで印を付けたものを捨てる
+	void invalidate_transient() const
+	{
+		GLenum attachments[max_color_attachments + 3];
+		int n = 0;
+		for (int i = 0; i < max_color_attachments + 3; ++i)
+		{
+			if ((_transient & (1U << i)) != 0)
+			{
+				attachments[n++] = bit_attachment(i);
+			}
+		}
+		invalidate(attachments, n);
+	}
+
+	// 完全な状態か
+	GLenum status() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, _id);
+		const GLenum s = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return s;
+	}
+	bool complete() const
+	{
+		return status() == GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	// 領域をdstへ転送する(dstが0の時は既定のフレームバッファ)
+	// 転送の後は読み込み先と描画先のバインドは外れる
+	void blit(GLuint dst, int x0, int y0, int x1, int y1, int dx0, int dy0, int dx1, int dy1,
+		GLbitfield mask = GL_COLOR_BUFFER_BIT, GLenum filter = GL_NEAREST) const
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, _id);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst);
+		glBlitFramebuffer(x0, y0, x1, y1, dx0, dy0, dx1, dy1, mask, filter);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	}
+	// 全体を同じ大きさでdstへ転送する
+	void blit(const framebuffer& dst, GLbitfield mask = GL_COLOR_BUFFER_BIT, GLenum filter = GL_NEAREST) const
+	{
+		blit(dst.get(), 0, 0, _width, _height, 0, 0, dst._width, dst._height, mask, filter);
+	}
+	// 全体を既定のフレームバッファへ転送する
+	void blit(int width, int height, GLbitfield mask = GL_COLOR_BUFFER_BIT, GLenum filter = GL_LINEAR) const
+	{
+		blit(0, 0, 0, _width, _height, 0, 0, width, height, mask, filter);
+	}
+	// MSAAの色をdstへ解決する
+	// 同じ大きさであること
+	// 転送の後は読み込み先を最初に取り付けた色に戻す
+	void resolve(const framebuffer& dst, GLenum attachment = GL_COLOR_ATTACHMENT0) const
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, _id);
+		glReadBuffer(attachment);
+		blit(dst.get(), 0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, _id);
+		glReadBuffer((_attached & ((1U << max_color_attachments) - 1)) != 0 ? GL_COLOR_ATTACHMENT0 + first_color() : GL_NONE);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	}
+
+	// バインド
+	void bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, _id);
+	}
+	void bind(framebuffer_type_t type) const
+	{
+		glBindFramebuffer(type, _id);
+	}
+	// バインド解除
+	void unbind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	void unbind(framebuffer_type_t type) const
+	{
+		glBindFramebuffer(type, 0);
+	}
+	// バインドされているか
+	bool binding() const
+	{
+		return gl::is_binding(GL_DRAW_FRAMEBUFFER_BINDING, _id);
+	}
+
+	// バインド状態を管理するオブジェクト生成
+	binder_type make_binder() const
+	{
+		return binder_type(*this);
+	}
+
+	// 最後に取り付けたものの大きさ
+	int width() const
+	{
+		return _width;
+	}
+	int height() const
+	{
+		return _height;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_creating))
+		{
+			return "glGenFramebuffers().";
+		}
+		if (error_status(error_invalid_index))
+		{
+			return "unsupported attachment.";
+		}
+		if (_id == 0)
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		if (_id == 0 ||
+			_error_bitfield != 0)
+		{
+			return false;
+		}
+		return glIsFramebuffer(_id) == GL_TRUE;
+	}
+
+	// ハンドルの取得
+	GLuint& get()
+	{
+		return _id;
+	}
+	const GLuint& get() const
+	{
+		return _id;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+	bool operator == (const framebuffer& f) const
+	{
+		return _id == f._id;
+	}
+	bool operator != (const framebuffer& f) const
+	{
+		return !(*this == f);
+	}
+
+	framebuffer& operator = (const framebuffer& f)
+	{
+		_id = f._id;
+		_width = f._width;
+		_height = f._height;
+		_attached = f._attached;
+		_transient = f._transient;
+		_error_bitfield = f._error_bitfield;
+		return *this;
+	}
+#ifdef POCKET_USE_CXX11
+	framebuffer& operator = (framebuffer&& f) POCKET_CXX11_NOEXCEPT
+	{
+		_id = std::move(f._id);
+		_width = std::move(f._width);
+		_height = std::move(f._height);
+		_attached = std::move(f._attached);
+		_transient = std::move(f._transient);
+		_error_bitfield = std::move(f._error_bitfield);
+		f._id = 0;
+		f._width = 0;
+		f._height = 0;
+		f._attached = 0;
+		f._transient = 0;
+		f._error_bitfield = 0;
+		return *this;
+	}
+
+	framebuffer& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+
+private:
+	// 取り付け先ごとのビット
+	// 色は0から, 深度, ステンシル, 深度ステンシルの順
+	static unsigned int attachment_bit(GLenum attachment)
+	{
+		if (attachment >= GL_COLOR_ATTACHMENT0 && attachment < GL_COLOR_ATTACHMENT0 + max_color_attachments)
+		{
+			return 1U << (attachment - GL_COLOR_ATTACHMENT0);
+		}
+		switch (attachment)
+		{
+		case GL_DEPTH_ATTACHMENT:
+			return 1U << max_color_attachments;
+		case GL_STENCIL_ATTACHMENT:
+			return 1U << (max_color_attachments + 1);
+		case GL_DEPTH_STENCIL_ATTACHMENT:
+			return 1U << (max_color_attachments + 2);
+		default:
+			break;
+		}
+		return 0;
+	}
+	static GLenum bit_attachment(int i)
+	{
+		if (i < max_color_attachments)
+		{
+			return GL_COLOR_ATTACHMENT0 + i;
+		}
+		switch (i - max_color_attachments)
+		{
+		case 0:
+			return GL_DEPTH_ATTACHMENT;
+		case 1:
+			return GL_STENCIL_ATTACHMENT;
+		default:
+			break;
+		}
+		return GL_DEPTH_STENCIL_ATTACHMENT;
+	}
+
+	bool begin(GLenum attachment)
+	{
+		if (attachment_bit(attachment) == 0)
+		{
+			_error_bitfield |= error_invalid_index;
+			return false;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, _id);
+		return true;
+	}
+	void end(GLenum attachment, int width, int height)
+	{
+		_attached |= attachment_bit(attachment);
+		_width = width;
+		_height = height;
+		update_draw_buffers();
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	// 取り付けた色の出力先を番号順に設定する
+	void update_draw_buffers() const
+	{
+		GLenum buffers[max_color_attachments];
+		int n = 0;
+		for (int i = 0; i < max_color_attachments; ++i)
+		{
+			if ((_attached & (1U << i)) != 0)
+			{
+				n = i + 1;
+				buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+			}
+			else
+			{
+				buffers[i] = GL_NONE;
+			}
+		}
+		if (n == 0)
+		{
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+		}
+		else
+		{
+			glDrawBuffers(n, buffers);
+			glReadBuffer(GL_COLOR_ATTACHMENT0 + first_color());
+		}
+	}
+	int first_color() const
+	{
+		for (int i = 0; i < max_color_attachments; ++i)
+		{
+			if ((_attached & (1U << i)) != 0)
+			{
+				return i;
+			}
+		}
+		return 0;
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const renderbuffer& v)
+{
+	std::ios_base::fmtflags flag = os.flags();
+	os << io::widen("renderbuffer: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.get() << std::endl <<
+		io::tab << io::widen("format: 0x") << std::hex << v.format() << std::dec << std::endl <<
+		io::tab << io::widen("size: [") << v.width() << io::widen(", ") << v.height() << io::box_brackets_right << std::endl <<
+		io::tab << io::widen("samples: ") << v.samples() << std::endl;
+	os.flags(flag);
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const framebuffer& v)
+{
+	os << io::widen("framebuffer: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.get() << std::endl <<
+		io::tab << io::widen("size: [") << v.width() << io::widen(", ") << v.height() << io::box_brackets_right << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_FRAMEBUFFER_H__
@@ -23,20 +23,47 @@ struct buffer_type;
 struct buffer_usage_type;
 struct buffer_map_type;
 struct buffer_binding_type;
+struct block_layout_type;
 
 class buffer;
 class buffer_view;
+class buffer_heap;
 template <int> class buffers;
 class shader;
 class program;
 class uniform_buffer;
+class uniform_arena;
+template <typename, typename> struct block_member;
+template <typename> struct block_layout_end;
+class block_validator;
+template <typename> class storage_buffer;
 class vertex_array;
 template <typename> class vertex_buffer;
 template <typename> class index_buffer;
 template <typename> class layered_vertex_buffer;
+class vertex_format_registry;
+class render_queue;
+class command_list;
 class draw_indirect_buffer;
 class sampler;
+class texture;
+class texture2d;
+class texture2d_array;
+class texture_cube;
+class texture3d;
+class texture_streamer;
+class texture_table;
+class renderbuffer;
+class framebuffer;
+class render_target_pool;
 class sync;
+class query;
+class profiler;
+class readback;
+#ifdef POCKET_USE_CXX11
+class loader;
+class frame_graph;
+#endif // POCKET_USE_CXX11
 struct viewport;
 struct depth_range;
 
@@ -20,6 +20,9 @@
 #	endif
 #endif // POCKET_INTERNAL_USE_GLEW
 
+// GL関数の計測(POCKET_USE_GL_TRACE)
+#include "trace.h"
+
 #include <vector>
 #include <cstring> // for std::strstr, std::strcmp, std::strlen
 #include <string>
@@ -495,6 +498,76 @@ int get_type_size(GLenum type)
 #undef __POCKET_TYPE_CASE_SIZE
 }
 
+//---------------------------------------------------------------------
+// 1ピクセルのバイト数(圧縮形式など対応していなければ0)
+//---------------------------------------------------------------------
+inline
+int get_pixel_size(GLenum format, GLenum type)
+{
+	switch (type)
+	{
+	case GL_UNSIGNED_INT_8_8_8_8:
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+	case GL_UNSIGNED_INT_10_10_10_2:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_24_8:
+	case GL_UNSIGNED_INT_10F_11F_11F_REV:
+		return 4;
+	case GL_UNSIGNED_SHORT_5_6_5:
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+	case GL_UNSIGNED_SHORT_5_5_5_1:
+		return 2;
+	default:
+		break;
+	}
+
+	int bytes = 0;
+	switch (type)
+	{
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		bytes = 1;
+		break;
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT:
+		bytes = 2;
+		break;
+	case GL_INT:
+	case GL_UNSIGNED_INT:
+	case GL_FLOAT:
+		bytes = 4;
+		break;
+	default:
+		return 0;
+	}
+
+	switch (format)
+	{
+	case GL_RED:
+	case GL_RED_INTEGER:
+	case GL_DEPTH_COMPONENT:
+	case GL_STENCIL_INDEX:
+		return bytes;
+	case GL_RG:
+	case GL_RG_INTEGER:
+		return bytes * 2;
+	case GL_RGB:
+	case GL_BGR:
+	case GL_RGB_INTEGER:
+	case GL_BGR_INTEGER:
+		return bytes * 3;
+	case GL_RGBA:
+	case GL_BGRA:
+	case GL_RGBA_INTEGER:
+	case GL_BGRA_INTEGER:
+		return bytes * 4;
+	default:
+		break;
+	}
+	return 0;
+}
+
 //---------------------------------------------------------------------
 // タイプに対する値が指定した値と一致しているか
 //---------------------------------------------------------------------
@@ -355,6 +355,24 @@ public:
 	{
 		glDrawElementsIndirect(type, gl_type<T>::value, NULL);
 	}
+	// first番目のインデックスからn個, 頂点番号にbase_vertexを加えて描画
+	void draw(draw_type_t type, GLsizei n, int first, GLint base_vertex) const
+	{
+		n = std::min(n, _count - first);
+		glDrawElementsBaseVertex(type, n, gl_type<T>::value, POCKET_BUFFER_OFFSET(sizeof(index_type) * first), base_vertex);
+	}
+	// インスタンス描画
+	void draw_instanced(draw_type_t type, GLsizei instances) const
+	{
+		glDrawElementsInstanced(type, _count, gl_type<T>::value, NULL, instances);
+	}
+	// base_instanceはdivisorを設定した属性の読み始める位置
+	void draw_instanced(draw_type_t type, GLsizei n, int first, GLint base_vertex, GLsizei instances, GLuint base_instance = 0) const
+	{
+		n = std::min(n, _count - first);
+		glDrawElementsInstancedBaseVertexBaseInstance(type, n, gl_type<T>::value, POCKET_BUFFER_OFFSET(sizeof(index_type) * first),
+			instances, base_vertex, base_instance);
+	}
 
 	// バッファを展開して先頭アドレスを取得
 	index_type* map(buffer_map_type_t type) const
@@ -381,6 +381,14 @@ public:
 	{
 		_vbo.draw(type, i);
 	}
+	void draw_instanced(draw_type_t type, GLsizei instances, GLuint base_instance = 0) const
+	{
+		_vbo.draw_instanced(type, instances, base_instance);
+	}
+	void draw_instanced(draw_type_t type, GLint first, GLsizei n, GLsizei instances, GLuint base_instance = 0) const
+	{
+		_vbo.draw_instanced(type, first, n, instances, base_instance);
+	}
 
 	// バッファを展開して先頭アドレスを取得
 	vertex_type* map(buffer_map_type_t type) const
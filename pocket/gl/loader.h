@@ -0,0 +1,439 @@
+﻿#ifndef __POCKET_GL_LOADER_H__
+#define __POCKET_GL_LOADER_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "shader.h"
+#include "program.h"
+#include "sync.h"
+#include "../io.h"
+#ifdef POCKET_USE_CXX11
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <string>
+#endif // POCKET_USE_CXX11
+
+namespace pocket
+{
+namespace gl
+{
+
+#ifdef POCKET_USE_CXX11
+
+// forward
+class loader;
+
+//---------------------------------------------------------------------------------------
+// 共有コンテキストでの読み込みスレッド
+// バッファの確保, シェーダーのコンパイルとリンクを別のスレッドで行い, 描画スレッドを止めない
+// 読み込みスレッドは処理の後ろにフェンス(gl::sync)を置き, 描画スレッドはpollでGPUの完了を確認してから関数を呼ぶ
+// pollで完了するまでは描画スレッドで対象のオブジェクトに触れないこと
+// VAOとFBOはコンテキスト間で共有されないため描画スレッドで作成する
+//
+// // 描画用のコンテキストと共有したコンテキストを作っておく
+// GLFWwindow* shared = glfwCreateWindow(1, 1, "", NULL, window); // GLFW_VISIBLEはfalse
+// gl::loader ld([=] { glfwMakeContextCurrent(shared); }, [] { glfwMakeContextCurrent(NULL); });
+// ld.upload(chunk.vbo, gl::buffer_type::array, vertices, size, [&] { chunk.vao.initialize(chunk.vbo, layouts); });
+// ld.compile(chunk.prog, vs, fs, [&] { chunk.ready = chunk.prog.valid(); });
+// do
+// {
+//     ld.poll(); // 完了したものの関数を呼ぶ
+//     ...
+// } while (...);
+//---------------------------------------------------------------------------------------
+class loader
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 読み込みの識別番号(0は無効)
+	typedef unsigned int ticket_type;
+
+	// 読み込みスレッドでコンテキストを設定, 解除する関数
+	typedef std::function<void ()> context_function;
+	// 読み込みスレッドで呼ぶ関数
+	typedef std::function<void ()> job_function;
+	// 完了後に描画スレッドで呼ぶ関数
+	typedef std::function<void ()> ready_function;
+
+private:
+	struct job
+	{
+		ticket_type ticket;
+		job_function func;
+		ready_function ready;
+		gl::sync fence; // 読み込みスレッドで作成
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _condition; // 読み込みスレッドへの通知
+	std::condition_variable _loaded_condition; // 描画スレッドへの通知
+	std::deque<job*> _queue; // 読み込みスレッドへ
+	std::deque<job*> _loaded; // フェンスを置いたもの
+	context_function _make_current;
+	context_function _release;
+	ticket_type _ticket;
+	ticket_type _completed; // 描画スレッドで完了を確認した最後の番号
+	int _pending;
+	bool _exit;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	loader() :
+		_ticket(0),
+		_completed(0),
+		_pending(0),
+		_exit(false),
+		_error_bitfield(0)
+	{}
+	// make_current: 読み込みスレッドで共有コンテキストを設定する関数
+	// release: 読み込みスレッドの終了時に呼ぶ関数
+	explicit loader(const context_function& make_current, const context_function& release = context_function()) :
+		_ticket(0),
+		_completed(0),
+		_pending(0),
+		_exit(false),
+		_error_bitfield(0)
+	{
+		initialize(make_current, release);
+	}
+	~loader()
+	{
+		finalize();
+	}
+
+private:
+	// スレッドを共有しないように複製は禁止
+	loader(const loader&);
+	loader& operator = (const loader&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	// 読み込みスレッドを開始する
+	bool initialize(const context_function& make_current, const context_function& release = context_function())
+	{
+		finalize();
+
+		if (!make_current)
+		{
+			_error_bitfield |= error_unsupported;
+			return false;
+		}
+		_make_current = make_current;
+		_release = release;
+		_exit = false;
+		_thread = std::thread(&loader::run, this);
+		return true;
+	}
+
+	// 終了処理
+	// 読み込み中のものは終わるまで待ち, 完了していないものの関数は呼ばない
+	// 描画スレッドで呼ぶこと
+	void finalize()
+	{
+		if (_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_exit = true;
+			}
+			_condition.notify_one();
+			_thread.join();
+		}
+		for (size_t i = 0; i < _queue.size(); ++i)
+		{
+			delete _queue[i];
+		}
+		_queue.clear();
+		for (size_t i = 0; i < _loaded.size(); ++i)
+		{
+			delete _loaded[i];
+		}
+		_loaded.clear();
+		_make_current = context_function();
+		_release = context_function();
+		_ticket = 0;
+		_completed = 0;
+		_pending = 0;
+		_exit = false;
+		_error_bitfield = 0;
+	}
+
+	// 読み込みスレッドで関数を呼ぶ
+	// readyはGPUの完了後にpollから描画スレッドで呼ばれる
+	ticket_type enqueue(const job_function& func, const ready_function& ready = ready_function())
+	{
+		if (!_thread.joinable())
+		{
+			return 0;
+		}
+		job* j = new job();
+		j->ticket = ++_ticket;
+		j->func = func;
+		j->ready = ready;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_queue.push_back(j);
+		}
+		++_pending;
+		_condition.notify_one();
+		return j->ticket;
+	}
+
+	// バッファの確保と書き込み(glBufferData)
+	// dataは複製するため呼び出し後に破棄してよい
+	// bは完了するまで有効であること
+	ticket_type upload(buffer& b, buffer_type_t type, const void* data, int size,
+		buffer_usage_type_t usg = buffer_usage_type::immutable_draw, const ready_function& ready = ready_function())
+	{
+		buffer* target = &b;
+		std::shared_ptr<std::vector<char> > copy = duplicate(data, size);
+		return enqueue([=] { target->initialize(type, usg, size, copy->empty() ? NULL : &(*copy)[0]); }, ready);
+	}
+	ticket_type upload(buffer& b, buffer_type_t type, const void* data, int size, const ready_function& ready)
+	{
+		return upload(b, type, data, size, buffer_usage_type::immutable_draw, ready);
+	}
+	// 変更できない領域の確保と書き込み(glBufferStorage)
+	ticket_type upload_storage(buffer& b, buffer_type_t type, const void* data, int size, GLbitfield flags,
+		const ready_function& ready = ready_function())
+	{
+		buffer* target = &b;
+		std::shared_ptr<std::vector<char> > copy = duplicate(data, size);
+		return enqueue([=] { target->initialize_storage(type, size, copy->empty() ? NULL : &(*copy)[0], flags); }, ready);
+	}
+
+	// 頂点シェーダーとフラグメントシェーダーの文字列からプログラムを作成
+	// pは完了するまで有効であること, 成否はreadyでp.valid()を確認する
+	ticket_type compile(program& p, const std::string& vertex, const std::string& fragment,
+		const ready_function& ready = ready_function())
+	{
+		program* target = &p;
+		return enqueue([=]
+		{
+			shader vs(shader_type::vertex, vertex.c_str(), shader::string);
+			shader fs(shader_type::fragment, fragment.c_str(), shader::string);
+			target->initialize(vs, fs);
+		}, ready);
+	}
+
+	// 描画スレッドでGPUの完了を確認し, 完了したものの関数を追加順に呼ぶ
+	// 呼んだ数を返す
+	int poll()
+	{
+		int n = 0;
+		for (;;)
+		{
+			job* j = NULL;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (_loaded.empty() || !_loaded.front()->fence.signaled())
+				{
+					break;
+				}
+				j = _loaded.front();
+				_loaded.pop_front();
+			}
+			complete(j);
+			++n;
+		}
+		return n;
+	}
+
+	// 描画スレッドでticketの完了まで待つ
+	void wait(ticket_type ticket)
+	{
+		if (ticket == 0 || ticket > _ticket)
+		{
+			return;
+		}
+		while (!done(ticket))
+		{
+			job* j = NULL;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_loaded_condition.wait(lock, [this] { return !_loaded.empty(); });
+				j = _loaded.front();
+				_loaded.pop_front();
+			}
+			j->fence.wait_client(GL_TIMEOUT_IGNORED, sync::flush);
+			complete(j);
+		}
+	}
+	// 全ての読み込みの完了まで待つ
+	void finish()
+	{
+		wait(_ticket);
+	}
+
+	// 完了してreadyを呼んだか
+	bool done(ticket_type ticket) const
+	{
+		return ticket != 0 && ticket <= _completed;
+	}
+	// 完了していない数
+	int pending() const
+	{
+		return _pending;
+	}
+
+	// 読み込みスレッドが動いているか
+	bool running() const
+	{
+		return _thread.joinable();
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_unsupported))
+		{
+			return "make_current function is empty.";
+		}
+		if (!running())
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return running() && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	static std::shared_ptr<std::vector<char> > duplicate(const void* data, int size)
+	{
+		std::shared_ptr<std::vector<char> > copy = std::make_shared<std::vector<char> >();
+		if (data != NULL && size > 0)
+		{
+			const char* p = static_cast<const char*>(data);
+			copy->assign(p, p + size);
+		}
+		return copy;
+	}
+
+	void complete(job* j)
+	{
+		_completed = j->ticket;
+		--_pending;
+		if (j->ready)
+		{
+			j->ready();
+		}
+		delete j;
+	}
+
+	// 読み込みスレッド
+	void run()
+	{
+#ifdef POCKET_USE_GL_TRACE
+		// 計測の状態は描画スレッドのみが使用する
+		trace::ignore_this_thread();
+#endif // POCKET_USE_GL_TRACE
+		_make_current();
+		for (;;)
+		{
+			job* j = NULL;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this] { return _exit || !_queue.empty(); });
+				if (_exit)
+				{
+					break;
+				}
+				j = _queue.front();
+				_queue.pop_front();
+			}
+			j->func();
+			// 描画スレッドから完了が見えるようにフェンスを置いて送信する
+			j->fence.initialize();
+			glFlush();
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_loaded.push_back(j);
+			}
+			_loaded_condition.notify_one();
+		}
+		glFinish();
+		if (_release)
+		{
+			_release();
+		}
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const loader& v)
+{
+	os << io::widen("loader: {") << std::endl <<
+		io::tab << io::widen("running: ") << v.running() << std::endl <<
+		io::tab << io::widen("pending: ") << v.pending() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+#endif // POCKET_USE_CXX11
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_LOADER_H__
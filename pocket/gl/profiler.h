@@ -0,0 +1,459 @@
+﻿#ifndef __POCKET_GL_PROFILER_H__
+#define __POCKET_GL_PROFILER_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "query.h"
+#include "../io.h"
+#include <vector>
+#include <cstring> // for std::strcmp
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class profiler;
+
+//---------------------------------------------------------------------------------------
+// GPU時間の階層計測
+// 区間の開始と終了にGL_TIMESTAMPを記録し, 結果はframesフレーム後に待機せずに回収する
+// 回収が間に合わなかったフレームは捨てる(dropped)
+//
+// gl::profiler prof(3);
+// do
+// {
+//     {
+//         gl::profiler::scope s(prof, "shadow");
+//         ...
+//     }
+//     prof.frame();
+//     std::cout << prof << std::endl; // framesフレーム前の結果
+// } while (...);
+//
+// 区間名の文字列は結果を参照し終わるまで有効であること
+//---------------------------------------------------------------------------------------
+class profiler
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 計測結果
+	struct section
+	{
+		const char* name;
+		int parent; // 親の区間(無ければ-1)
+		int depth;
+		GLuint64 begin; // フレームの最初の区間の開始を0としたナノ秒
+		GLuint64 end;
+
+		GLuint64 nanoseconds() const
+		{
+			return end - begin;
+		}
+		double milliseconds() const
+		{
+			return static_cast<double>(end - begin) * 1.0e-6;
+		}
+	};
+
+	// 生成時に区間を開始, 破棄時に終了
+	class scope
+	{
+	private:
+		profiler* _profiler;
+
+	public:
+		explicit scope(profiler& p, const char* name) :
+			_profiler(&p)
+		{
+			p.begin(name);
+		}
+		~scope()
+		{
+			_profiler->end();
+		}
+
+	private:
+		scope(const scope&);
+		scope& operator = (const scope&);
+	};
+
+private:
+	// 1フレーム分の記録
+	struct slot
+	{
+		std::vector<section> sections;
+		unsigned long long frame;
+		int last; // 最後に記録したクエリ
+		bool pending; // 結果の回収待ち
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::vector<GLuint> _ids; // [フレーム][区間][開始, 終了]
+	std::vector<slot> _slots;
+	std::vector<int> _stack;
+	std::vector<section> _results;
+	unsigned long long _frame;
+	unsigned long long _result_frame;
+	int _capacity;
+	int _current;
+	int _dropped;
+	int _overflow;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	profiler() :
+		_frame(0),
+		_result_frame(0),
+		_capacity(0),
+		_current(0),
+		_dropped(0),
+		_overflow(0),
+		_error_bitfield(0)
+	{}
+	// frames: 結果を回収するまでのフレーム数, capacity: 1フレームの区間の上限
+	explicit profiler(int frames, int capacity = 64) :
+		_frame(0),
+		_result_frame(0),
+		_capacity(0),
+		_current(0),
+		_dropped(0),
+		_overflow(0),
+		_error_bitfield(0)
+	{
+		initialize(frames, capacity);
+	}
+	~profiler()
+	{
+		finalize();
+	}
+
+private:
+	// クエリを共有しないように複製は禁止
+	profiler(const profiler&);
+	profiler& operator = (const profiler&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	bool initialize(int frames, int capacity = 64)
+	{
+		finalize();
+
+		if (frames < 1 || capacity < 1)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return false;
+		}
+
+		_capacity = capacity;
+		_ids.resize(static_cast<size_t>(frames) * capacity * 2, 0);
+		glGenQueries(static_cast<GLsizei>(_ids.size()), &_ids[0]);
+		if (_ids[0] == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		_slots.resize(frames);
+		for (int i = 0; i < frames; ++i)
+		{
+			_slots[i].sections.reserve(capacity);
+			_slots[i].frame = 0;
+			_slots[i].last = -1;
+			_slots[i].pending = false;
+		}
+		_stack.reserve(16);
+		_results.reserve(capacity);
+		return true;
+	}
+
+	// 終了処理
+	void finalize()
+	{
+		if (!_ids.empty() && _ids[0] != 0)
+		{
+			glDeleteQueries(static_cast<GLsizei>(_ids.size()), &_ids[0]);
+		}
+		_ids.clear();
+		_slots.clear();
+		_stack.clear();
+		_results.clear();
+		_frame = 0;
+		_result_frame = 0;
+		_capacity = 0;
+		_current = 0;
+		_dropped = 0;
+		_overflow = 0;
+		_error_bitfield = 0;
+	}
+
+	// 区間の開始
+	void begin(const char* name)
+	{
+		if (_slots.empty())
+		{
+			return;
+		}
+		slot& s = _slots[_current];
+		// 上限を超えた区間は計測しない
+		if (static_cast<int>(s.sections.size()) >= _capacity)
+		{
+			++_overflow;
+			_stack.push_back(-1);
+			return;
+		}
+
+		const int index = static_cast<int>(s.sections.size());
+		section sec;
+		sec.name = name;
+		sec.parent = _stack.empty() ? -1 : _stack.back();
+		sec.depth = static_cast<int>(_stack.size());
+		sec.begin = 0;
+		sec.end = 0;
+		s.sections.push_back(sec);
+		_stack.push_back(index);
+
+		s.last = query_index(_current, index, 0);
+		glQueryCounter(_ids[s.last], GL_TIMESTAMP);
+	}
+
+	// 区間の終了
+	void end()
+	{
+		if (_stack.empty())
+		{
+			return;
+		}
+		const int index = _stack.back();
+		_stack.pop_back();
+		if (index < 0)
+		{
+			return;
+		}
+
+		slot& s = _slots[_current];
+		s.last = query_index(_current, index, 1);
+		glQueryCounter(_ids[s.last], GL_TIMESTAMP);
+	}
+
+	// フレームの区切り
+	// 終わったフレームの結果を待機せずに回収する
+	void frame()
+	{
+		if (_slots.empty())
+		{
+			return;
+		}
+
+		// 閉じられていない区間を閉じる
+		while (!_stack.empty())
+		{
+			end();
+		}
+
+		slot& s = _slots[_current];
+		s.frame = _frame++;
+		s.pending = !s.sections.empty();
+
+		collect();
+
+		// 次に使う記録がまだ回収できていなければ捨てる
+		_current = (_current + 1) % static_cast<int>(_slots.size());
+		slot& next = _slots[_current];
+		if (next.pending)
+		{
+			++_dropped;
+		}
+		next.sections.clear();
+		next.last = -1;
+		next.pending = false;
+	}
+
+	// 最後に回収したフレームの結果(区間の開始順)
+	const std::vector<section>& results() const
+	{
+		return _results;
+	}
+	// 結果のフレーム番号
+	unsigned long long result_frame() const
+	{
+		return _result_frame;
+	}
+	// 同じ名前の区間の合計(ミリ秒)
+	double milliseconds(const char* name) const
+	{
+		double ms = 0.0;
+		for (size_t i = 0; i < _results.size(); ++i)
+		{
+			if (std::strcmp(_results[i].name, name) == 0)
+			{
+				ms += _results[i].milliseconds();
+			}
+		}
+		return ms;
+	}
+
+	// 結果が出るまでのフレーム数
+	int frames() const
+	{
+		return static_cast<int>(_slots.size());
+	}
+	// 1フレームの区間の上限
+	int capacity() const
+	{
+		return _capacity;
+	}
+	// 回収が間に合わずに捨てたフレーム数
+	int dropped() const
+	{
+		return _dropped;
+	}
+	// 上限を超えて計測しなかった区間の数
+	int overflow() const
+	{
+		return _overflow;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "frames or capacity is less than 1.";
+		}
+		if (error_status(error_creating))
+		{
+			return "glGenQueries().";
+		}
+		if (_ids.empty())
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return !_ids.empty() && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	int query_index(int frame, int index, int end) const
+	{
+		return (frame * _capacity + index) * 2 + end;
+	}
+
+	// 古いフレームから順に結果が出ているものを回収する
+	void collect()
+	{
+		const int count = static_cast<int>(_slots.size());
+		for (int i = 1; i <= count; ++i)
+		{
+			const int n = (_current + i) % count;
+			slot& s = _slots[n];
+			if (!s.pending)
+			{
+				continue;
+			}
+
+			// タイムスタンプは記録順に完了するため最後のクエリだけ確認する
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(_ids[s.last], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available != GL_TRUE)
+			{
+				break;
+			}
+
+			_results.assign(s.sections.begin(), s.sections.end());
+			for (size_t j = 0; j < _results.size(); ++j)
+			{
+				section& sec = _results[j];
+				glGetQueryObjectui64v(_ids[query_index(n, static_cast<int>(j), 0)], GL_QUERY_RESULT, &sec.begin);
+				glGetQueryObjectui64v(_ids[query_index(n, static_cast<int>(j), 1)], GL_QUERY_RESULT, &sec.end);
+			}
+			// 最初の区間の開始を基準にする
+			const GLuint64 origin = _results.front().begin;
+			for (size_t j = 0; j < _results.size(); ++j)
+			{
+				_results[j].begin -= origin;
+				_results[j].end -= origin;
+			}
+			_result_frame = s.frame;
+			s.pending = false;
+		}
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const profiler& v)
+{
+	os << io::widen("profiler: {") << std::endl <<
+		io::tab << io::widen("frame: ") << v.result_frame() << std::endl <<
+		io::tab << io::widen("dropped: ") << v.dropped() << std::endl;
+	const std::vector<profiler::section>& results = v.results();
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		for (int d = 0; d <= results[i].depth; ++d)
+		{
+			os << io::tab;
+		}
+		os << io::widen(results[i].name) << io::widen(": ") << results[i].milliseconds() << io::widen("ms") << std::endl;
+	}
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_PROFILER_H__
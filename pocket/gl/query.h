@@ -0,0 +1,352 @@
+﻿#ifndef __POCKET_GL_QUERY_H__
+#define __POCKET_GL_QUERY_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "../io.h"
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class query;
+
+class query
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 生成時に計測開始, 破棄時に計測終了
+	typedef binder<query> binder_type;
+
+	enum identifier_t
+	{
+		identifier = GL_QUERY
+	};
+
+private:
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	GLuint _id;
+	query_type_t _type;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	query() :
+		_id(0),
+		_type(query_type::unknown),
+		_error_bitfield(0)
+	{}
+	explicit query(query_type_t type) :
+		_id(0)
+	{
+		initialize(type);
+	}
+	query(const query& q) :
+		_id(q._id),
+		_type(q._type),
+		_error_bitfield(q._error_bitfield)
+	{}
+#ifdef POCKET_USE_CXX11
+	query(query&& q) :
+		_id(std::move(q._id)),
+		_type(std::move(q._type)),
+		_error_bitfield(std::move(q._error_bitfield))
+	{
+		q._id = 0;
+		q._type = query_type::unknown;
+		q._error_bitfield = 0;
+	}
+#endif // POCKET_USE_CXX11
+	~query()
+	{
+		finalize();
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	bool initialize(query_type_t type)
+	{
+		finalize();
+
+		_type = type;
+
+		glGenQueries(1, &_id);
+		if (_id == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+		return true;
+	}
+
+	// 終了処理
+	void finalize()
+	{
+		if (_id != 0)
+		{
+			glDeleteQueries(1, &_id);
+			_id = 0;
+		}
+		_error_bitfield = 0;
+		_type = query_type::unknown;
+	}
+
+	// エラー状態クリア
+	void clear()
+	{
+		_error_bitfield = 0;
+	}
+
+	// 計測開始
+	// timestampはその時点の時間を記録する
+	void begin() const
+	{
+		if (_type == query_type::timestamp)
+		{
+			glQueryCounter(_id, GL_TIMESTAMP);
+			return;
+		}
+		glBeginQuery(_type, _id);
+	}
+	// 計測終了
+	void end() const
+	{
+		if (_type == query_type::timestamp)
+		{
+			return;
+		}
+		glEndQuery(_type);
+	}
+
+	// GPUの現在の時間を記録する(timestampのみ)
+	void counter() const
+	{
+		glQueryCounter(_id, GL_TIMESTAMP);
+	}
+
+	// binderから呼ばれる
+	void bind() const
+	{
+		begin();
+	}
+	void unbind() const
+	{
+		end();
+	}
+
+	// 計測区間を管理するオブジェクト作成
+	binder_type make_binder() const
+	{
+		return binder_type(*this);
+	}
+
+	// 結果が取得できるか(待機しない)
+	bool available() const
+	{
+		GLuint a = GL_FALSE;
+		glGetQueryObjectuiv(_id, GL_QUERY_RESULT_AVAILABLE, &a);
+		return a == GL_TRUE;
+	}
+
+	// 結果の取得
+	// 結果が出るまでCPUが待機するため, 先にavailableで確認するかtry_resultを使う
+	// time_elapsed, timestampはナノ秒
+	GLuint64 result() const
+	{
+		GLuint64 r = 0;
+		glGetQueryObjectui64v(_id, GL_QUERY_RESULT, &r);
+		return r;
+	}
+	// 結果が出ていれば取得する
+	bool try_result(GLuint64& r) const
+	{
+		if (!available())
+		{
+			return false;
+		}
+		r = result();
+		return true;
+	}
+
+	// クエリの種類
+	query_type_t kind() const
+	{
+		return _type;
+	}
+	bool kind_of(query_type_t type) const
+	{
+		return _type == type;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_creating))
+		{
+			return "glGenQueries().";
+		}
+		// 作成されていない
+		// またはすでに破棄済み
+		if (_id == 0)
+		{
+			return "not created. or already destroyed.";
+		}
+		// エラーは起こしていない
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	// 一度も計測していないクエリはglIsQueryがGL_FALSEを返すため名前の有無で判定する
+	bool valid() const
+	{
+		return _id != 0 && _error_bitfield == 0;
+	}
+
+	// ハンドルの取得
+	GLuint& get()
+	{
+		return _id;
+	}
+	const GLuint& get() const
+	{
+		return _id;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+	bool operator == (const query& q) const
+	{
+		return _id == q._id;
+	}
+	bool operator != (const query& q) const
+	{
+		return !(*this == q);
+	}
+
+	query& operator = (const query& q)
+	{
+		_id = q._id;
+		_type = q._type;
+		_error_bitfield = q._error_bitfield;
+		return *this;
+	}
+#ifdef POCKET_USE_CXX11
+	query& operator = (query&& q)
+	{
+		_id = std::move(q._id);
+		_type = std::move(q._type);
+		_error_bitfield = std::move(q._error_bitfield);
+		q._id = 0;
+		q._type = query_type::unknown;
+		q._error_bitfield = 0;
+		return *this;
+	}
+
+	query& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+};
+
+//------------------------------
+// make_query
+// make_[type]_query
+//------------------------------
+
+inline
+query make_query(query_type_t type)
+{
+	return query(type);
+}
+inline
+query& make_query(query& q, query_type_t type)
+{
+	q.initialize(type);
+	return q;
+}
+
+#define __POCKET_MAKE_QUERY(TYPE) inline \
+	query make_##TYPE##_query() \
+	{ \
+		return query(query_type::TYPE); \
+	} \
+	inline \
+	query& make_##TYPE##_query(query& q) \
+	{ \
+		q.initialize(query_type::TYPE); \
+		return q; \
+	}
+
+__POCKET_MAKE_QUERY(time_elapsed);
+__POCKET_MAKE_QUERY(timestamp);
+__POCKET_MAKE_QUERY(samples_passed);
+__POCKET_MAKE_QUERY(any_samples_passed);
+__POCKET_MAKE_QUERY(primitives_generated);
+
+#undef __POCKET_MAKE_QUERY
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const query& v)
+{
+	std::ios_base::fmtflags flag = os.flags();
+	os << io::widen("query: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.get() << std::endl <<
+		io::tab << io::widen("type: 0x") << std::hex << static_cast<int>(v.kind()) << std::endl;
+	os.flags(flag);
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_QUERY_H__
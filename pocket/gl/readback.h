@@ -0,0 +1,537 @@
+﻿#ifndef __POCKET_GL_READBACK_H__
+#define __POCKET_GL_READBACK_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "buffer.h"
+#include "../io.h"
+#include <vector>
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class readback;
+
+//---------------------------------------------------------------------------------------
+// GPUからの非同期読み取り
+// 読み取り用のバッファへコピーしてフェンスを置き, 完了したものからpollで関数を呼ぶ
+// 関数は読み取りを発行した順(ticketの順)に呼ばれる
+// buffer::map(buffer_map_type::read)のようにGPUの完了をその場で待たない
+//
+// gl::readback rb(3, sizeof(int) * 1024);
+// do
+// {
+//     ... // カリング結果をresultに書き込む
+//     rb.read(result, 0, sizeof(int) * count, [&](const void* p, int size) { ... });
+//     rb.read_pixels(x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, [&](const void* p, int) { ... });
+//     rb.poll(); // 終わっている読み取りの関数を呼ぶ
+// } while (...);
+//
+// 関数は読み取った領域の先頭と大きさを受け取り, 呼び出し後に領域は無効になる
+// 関数の中からread, pollを呼んでもよいが, 展開中の読み取り用のバッファは使われないため
+// 他に空きも完了待ちも無ければreadは失敗する
+// 空いている読み取り用のバッファが無い時は一番古い読み取りの完了を待つ(stalled)
+//---------------------------------------------------------------------------------------
+class readback
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 読み取りの識別番号(0は無効)
+	typedef unsigned int ticket_type;
+
+private:
+	// 完了時に呼ぶ関数
+	struct callback_base
+	{
+		virtual ~callback_base()
+		{}
+		virtual void operator () (const void*, int) = 0;
+	};
+	template <typename F>
+	struct callback : public callback_base
+	{
+		F func;
+
+		explicit callback(const F& f) :
+			func(f)
+		{}
+		virtual void operator () (const void* address, int size)
+		{
+			func(address, size);
+		}
+	};
+
+	// 読み取り用のバッファ一つ分
+	struct slot
+	{
+		GLsync fence;
+		callback_base* func;
+		ticket_type ticket;
+		int size; // 読み取った大きさ
+		int capacity; // 確保済みの大きさ
+		bool mapped; // 展開して関数を呼んでいる最中
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::vector<GLuint> _ids;
+	std::vector<slot> _slots;
+	ticket_type _ticket;
+	int _pending;
+	int _stalled;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	readback() :
+		_ticket(0),
+		_pending(0),
+		_stalled(0),
+		_error_bitfield(0)
+	{}
+	// count: 同時に待てる読み取りの数, size: 読み取り用のバッファの初期サイズ
+	explicit readback(int count, int size = 0) :
+		_ticket(0),
+		_pending(0),
+		_stalled(0),
+		_error_bitfield(0)
+	{
+		initialize(count, size);
+	}
+	~readback()
+	{
+		finalize();
+	}
+
+private:
+	// 読み取り用のバッファとフェンスを共有しないように複製は禁止
+	readback(const readback&);
+	readback& operator = (const readback&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	bool initialize(int count, int size = 0)
+	{
+		finalize();
+
+		if (count < 1)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return false;
+		}
+
+		_ids.resize(count, 0);
+		glGenBuffers(count, &_ids[0]);
+		if (_ids[0] == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		_slots.resize(count);
+		for (int i = 0; i < count; ++i)
+		{
+			slot& s = _slots[i];
+			s.fence = NULL;
+			s.func = NULL;
+			s.ticket = 0;
+			s.size = 0;
+			s.capacity = 0;
+			s.mapped = false;
+			if (size > 0)
+			{
+				reserve(i, size);
+			}
+		}
+		return true;
+	}
+
+	// 終了処理
+	// 完了していない読み取りの関数は呼ばない
+	void finalize()
+	{
+		for (size_t i = 0; i < _slots.size(); ++i)
+		{
+			release(_slots[i]);
+		}
+		if (!_ids.empty() && _ids[0] != 0)
+		{
+			glDeleteBuffers(static_cast<GLsizei>(_ids.size()), &_ids[0]);
+		}
+		_ids.clear();
+		_slots.clear();
+		_ticket = 0;
+		_pending = 0;
+		_stalled = 0;
+		_error_bitfield = 0;
+	}
+
+	// バッファの範囲を読み取る
+	// 失敗した時は0を返す
+	template <typename F>
+	ticket_type read(const buffer& src, int offset, int size, F func)
+	{
+		const int n = acquire(size);
+		if (n < 0)
+		{
+			return 0;
+		}
+
+		glBindBuffer(GL_COPY_READ_BUFFER, src.get());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _ids[n]);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, size);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		return commit(n, size, new callback<F>(func));
+	}
+
+	// 読み込み先のフレームバッファの範囲を読み取る
+	// 行はGL_PACK_ALIGNMENTに揃えられて渡される
+	template <typename F>
+	ticket_type read_pixels(int x, int y, int width, int height, GLenum format, GLenum type, F func)
+	{
+		const int pixel = get_pixel_size(format, type);
+		if (pixel == 0)
+		{
+			_error_bitfield |= error_invalid_data;
+			return 0;
+		}
+		GLint alignment = 4;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+		const int row = (width * pixel + alignment - 1) / alignment * alignment;
+		const int size = row * height;
+
+		const int n = acquire(size);
+		if (n < 0)
+		{
+			return 0;
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, _ids[n]);
+		glReadPixels(x, y, width, height, format, type, NULL);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		return commit(n, size, new callback<F>(func));
+	}
+
+	// 完了している読み取りの関数を発行順に呼ぶ(待機しない)
+	// 古い読み取りが終わっていなければ, それより新しいものも呼ばない
+	// 呼んだ数を返す
+	int poll()
+	{
+		int called = 0;
+		while (_pending > 0)
+		{
+			const int n = oldest();
+			if (n < 0 || !signaled(_slots[n], 0))
+			{
+				break;
+			}
+			complete(n);
+			++called;
+		}
+		return called;
+	}
+
+	// 指定の読み取りが終わるまで待機して関数を呼ぶ
+	// 順番を保つため, それより古い読み取りの関数も先に呼ぶ
+	// すでに完了していればtrue
+	bool wait(ticket_type ticket)
+	{
+		while (find(ticket) >= 0)
+		{
+			const int n = oldest();
+			if (n < 0 || !signaled(_slots[n], GL_TIMEOUT_IGNORED))
+			{
+				return false;
+			}
+			complete(n);
+		}
+		return true;
+	}
+
+	// 全ての読み取りを待機して関数を呼ぶ
+	void finish()
+	{
+		while (_pending > 0)
+		{
+			const int n = oldest();
+			if (n < 0 || !wait(_slots[n].ticket))
+			{
+				break;
+			}
+		}
+	}
+
+	// 読み取りが完了して関数が呼ばれたか
+	bool done(ticket_type ticket) const
+	{
+		return find(ticket) < 0;
+	}
+
+	// 完了待ちの数
+	int pending() const
+	{
+		return _pending;
+	}
+	// 同時に待てる読み取りの数
+	int count() const
+	{
+		return static_cast<int>(_slots.size());
+	}
+	// 空きが無く古い読み取りを待機した回数
+	int stalled() const
+	{
+		return _stalled;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "count is less than 1.";
+		}
+		if (error_status(error_creating))
+		{
+			return "glGenBuffers().";
+		}
+		if (error_status(error_invalid_data))
+		{
+			return "unsupported pixel format or type.";
+		}
+		if (_ids.empty())
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return !_ids.empty() && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	// 読み取り用のバッファの確保
+	// 小さい時だけ作り直す
+	void reserve(int n, int size)
+	{
+		slot& s = _slots[n];
+		if (s.capacity >= size)
+		{
+			return;
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _ids[n]);
+		glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_READ);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		s.capacity = size;
+	}
+
+	// 空いている読み取り用のバッファを取得
+	// 無ければ一番古い読み取りを待機して空ける
+	int acquire(int size)
+	{
+		if (_slots.empty())
+		{
+			return -1;
+		}
+		for (size_t i = 0; i < _slots.size(); ++i)
+		{
+			if (_slots[i].fence == NULL && !_slots[i].mapped)
+			{
+				reserve(static_cast<int>(i), size);
+				return static_cast<int>(i);
+			}
+		}
+
+		// 関数の中から呼ばれ, 展開中のもの以外に待てる読み取りが無い
+		const int n = oldest();
+		if (n < 0)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return -1;
+		}
+		++_stalled;
+		if (!wait(_slots[n].ticket))
+		{
+			return -1;
+		}
+		reserve(n, size);
+		return n;
+	}
+
+	// フェンスを置いて完了待ちにする
+	ticket_type commit(int n, int size, callback_base* func)
+	{
+		slot& s = _slots[n];
+		s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		if (s.fence == NULL)
+		{
+			delete func;
+			_error_bitfield |= error_creating;
+			return 0;
+		}
+		s.func = func;
+		s.size = size;
+		// 0は無効な番号
+		if (++_ticket == 0)
+		{
+			++_ticket;
+		}
+		s.ticket = _ticket;
+		++_pending;
+		return s.ticket;
+	}
+
+	// 展開して関数を呼び, 空きに戻す
+	// 関数の中からread, pollが呼ばれても同じスロットを再び完了させないよう, 呼ぶ前に完了待ちから外す
+	void complete(int n)
+	{
+		slot& s = _slots[n];
+		callback_base* func = s.func;
+		const int size = s.size;
+		s.func = NULL;
+		release(s);
+		s.mapped = true;
+		--_pending;
+
+		glBindBuffer(GL_COPY_READ_BUFFER, _ids[n]);
+		const void* address = glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, GL_MAP_READ_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		if (address != NULL)
+		{
+			(*func)(address, size);
+			// 関数の中でバインドが変わっている場合があるので再度バインドする
+			glBindBuffer(GL_COPY_READ_BUFFER, _ids[n]);
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		_slots[n].mapped = false;
+		delete func;
+	}
+
+	void release(slot& s)
+	{
+		if (s.fence != NULL)
+		{
+			glDeleteSync(s.fence);
+			s.fence = NULL;
+		}
+		delete s.func;
+		s.func = NULL;
+		s.ticket = 0;
+		s.size = 0;
+	}
+
+	// フェンスがシグナル状態か
+	// 初回の確認でコマンドを送信して待ち続けないようにする
+	static bool signaled(const slot& s, GLuint64 timeout)
+	{
+		const GLenum status = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+	}
+
+	int find(ticket_type ticket) const
+	{
+		if (ticket == 0)
+		{
+			return -1;
+		}
+		for (size_t i = 0; i < _slots.size(); ++i)
+		{
+			if (_slots[i].ticket == ticket)
+			{
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	}
+
+	// 完了待ちの中で一番古いもの
+	int oldest() const
+	{
+		int n = -1;
+		for (size_t i = 0; i < _slots.size(); ++i)
+		{
+			if (_slots[i].fence == NULL)
+			{
+				continue;
+			}
+			// 番号の一周を考慮して差で比べる
+			if (n < 0 || static_cast<int>(_slots[i].ticket - _slots[n].ticket) < 0)
+			{
+				n = static_cast<int>(i);
+			}
+		}
+		return n;
+	}
+
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const readback& v)
+{
+	os << io::widen("readback: {") << std::endl <<
+		io::tab << io::widen("count: ") << v.count() << std::endl <<
+		io::tab << io::widen("pending: ") << v.pending() << std::endl <<
+		io::tab << io::widen("stalled: ") << v.stalled() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_READBACK_H__
@@ -0,0 +1,588 @@
+﻿#ifndef __POCKET_GL_RENDER_QUEUE_H__
+#define __POCKET_GL_RENDER_QUEUE_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "program.h"
+#include "vertex_array.h"
+#include "sampler.h"
+#include "uniform_buffer.h"
+#include "draw_indirect_buffer.h"
+#include "../io.h"
+#include <vector>
+#include <algorithm> // for std::swap
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class render_queue;
+
+//---------------------------------------------------------------------------------------
+// 描画の並び替え
+// submitで描画を溜め, 64bitの並び替えキーで基数ソートしてからまとめて描画する
+// 描画時は直前と同じプログラム, VAO, テクスチャなどの設定を省略する
+//
+// キーは上位から pass(4) program(12) format(12) material(12) depth(24)
+// 半透明はtranslucent_keyで pass(4) depth(24, 奥から) program(12) format(12) material(8)
+//
+// gl::render_queue queue;
+// gl::render_queue::item it;
+// it.prog = &prog;
+// it.vao = &formats.get(mesh.format);
+// it.vertex_buffer(mesh.vbo.get(), 0, sizeof(vertex)).index_buffer(mesh.ibo.get());
+// it.texture(GL_TEXTURE_2D, mesh.texture, &samp).uniform(arena, range, 0);
+// it.elements<unsigned short>(gl::draw_type::triangles, mesh.count);
+// queue.submit(gl::render_queue::key(0, prog_id, mesh.format, mesh.material, depth), it);
+// ...
+// queue.flush(); // 並び替えて描画し, 溜めた描画を消す
+//---------------------------------------------------------------------------------------
+class render_queue
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	typedef unsigned long long key_type;
+
+	// 描画一つ分
+	// ポインタの先はflushまで有効であること
+	struct item
+	{
+		const program* prog;
+		const vertex_array* vao;
+		// initialize_formatのVAOで使う頂点バッファ(0で変更しない)
+		GLuint vbo;
+		GLintptr vbo_offset;
+		GLsizei vbo_stride;
+		GLuint ibo; // 0で変更しない
+		// テクスチャユニット0
+		GLenum texture_target;
+		GLuint texture_id;
+		const gl::sampler* samp;
+		// ユニフォームブロック(uniform_sizeが0の時は全体)
+		GLuint uniform_id;
+		GLuint uniform_point;
+		GLintptr uniform_offset;
+		GLsizeiptr uniform_size;
+		// 描画
+		draw_type_t type;
+		GLenum index_type; // 0で頂点配列の描画
+		GLint first; // 頂点配列の開始位置
+		GLsizei count;
+		GLintptr offset; // インデックスの開始位置(バイト)
+		GLint base_vertex;
+		GLsizei instances;
+		GLuint base_instance;
+		const draw_indirect_buffer* indirect;
+		GLintptr indirect_offset;
+
+		item() :
+			prog(NULL),
+			vao(NULL),
+			vbo(0),
+			vbo_offset(0),
+			vbo_stride(0),
+			ibo(0),
+			texture_target(GL_TEXTURE_2D),
+			texture_id(0),
+			samp(NULL),
+			uniform_id(0),
+			uniform_point(0),
+			uniform_offset(0),
+			uniform_size(0),
+			type(draw_type::triangles),
+			index_type(0),
+			first(0),
+			count(0),
+			offset(0),
+			base_vertex(0),
+			instances(1),
+			base_instance(0),
+			indirect(NULL),
+			indirect_offset(0)
+		{}
+
+		item& vertex_buffer(GLuint id, GLintptr off, GLsizei stride)
+		{
+			vbo = id;
+			vbo_offset = off;
+			vbo_stride = stride;
+			return *this;
+		}
+		item& index_buffer(GLuint id)
+		{
+			ibo = id;
+			return *this;
+		}
+		item& texture(GLenum target, GLuint id, const gl::sampler* s = NULL)
+		{
+			texture_target = target;
+			texture_id = id;
+			samp = s;
+			return *this;
+		}
+		item& uniform(const uniform_buffer& ubo, GLuint point)
+		{
+			uniform_id = ubo.get();
+			uniform_point = point;
+			uniform_offset = 0;
+			uniform_size = 0;
+			return *this;
+		}
+		item& uniform(GLuint id, GLuint point, GLintptr off, GLsizeiptr size)
+		{
+			uniform_id = id;
+			uniform_point = point;
+			uniform_offset = off;
+			uniform_size = size;
+			return *this;
+		}
+		// uniform_arenaなどの範囲
+		template <typename ARENA, typename RANGE>
+		item& uniform(const ARENA& arena, const RANGE& r, GLuint point)
+		{
+			return uniform(arena.buffer().get(), point, r.offset, r.size);
+		}
+
+		item& arrays(draw_type_t t, GLint f, GLsizei n)
+		{
+			type = t;
+			index_type = 0;
+			first = f;
+			count = n;
+			return *this;
+		}
+		item& elements(draw_type_t t, GLenum itype, GLsizei n, GLintptr byte_offset = 0, GLint bv = 0)
+		{
+			type = t;
+			index_type = itype;
+			count = n;
+			offset = byte_offset;
+			base_vertex = bv;
+			return *this;
+		}
+		// f番目のインデックスからn個
+		template <typename T>
+		item& elements(draw_type_t t, GLsizei n, int f = 0, GLint bv = 0)
+		{
+			return elements(t, gl_type<T>::value, n, static_cast<GLintptr>(sizeof(T) * f), bv);
+		}
+		item& instanced(GLsizei n, GLuint base = 0)
+		{
+			instances = n;
+			base_instance = base;
+			return *this;
+		}
+		// index_typeが0の時はdraw_arrays_cmd, それ以外はdraw_elements_cmdを読み込む
+		item& indirect_buffer(const draw_indirect_buffer& b, GLintptr off = 0)
+		{
+			indirect = &b;
+			indirect_offset = off;
+			return *this;
+		}
+	};
+
+	// 描画時の切り替え回数
+	struct statistics
+	{
+		int draws;
+		int programs;
+		int vertex_arrays;
+		int vertex_buffers;
+		int index_buffers;
+		int textures;
+		int samplers;
+		int uniform_buffers;
+
+		statistics() :
+			draws(0),
+			programs(0),
+			vertex_arrays(0),
+			vertex_buffers(0),
+			index_buffers(0),
+			textures(0),
+			samplers(0),
+			uniform_buffers(0)
+		{}
+	};
+
+private:
+	// 並び替え用
+	struct entry
+	{
+		key_type key;
+		int index;
+	};
+
+	// 直前に設定した状態
+	struct state_cache
+	{
+		GLuint prog;
+		GLuint vao;
+		GLuint vbo;
+		GLintptr vbo_offset;
+		GLsizei vbo_stride;
+		GLuint ibo;
+		GLenum texture_target;
+		GLuint texture_id;
+		GLuint samp;
+		GLuint uniform_id;
+		GLuint uniform_point;
+		GLintptr uniform_offset;
+		GLsizeiptr uniform_size;
+		GLuint indirect;
+
+		// 最初の描画で必ず設定されるように存在しない値にする
+		void reset()
+		{
+			const GLuint none = ~0U;
+			prog = none;
+			vao = none;
+			vbo = none;
+			vbo_offset = -1;
+			vbo_stride = -1;
+			ibo = none;
+			texture_target = none;
+			texture_id = none;
+			samp = none;
+			uniform_id = none;
+			uniform_point = none;
+			uniform_offset = -1;
+			uniform_size = -1;
+			indirect = none;
+		}
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::vector<item> _items;
+	std::vector<entry> _entries;
+	std::vector<entry> _temp;
+	statistics _stats;
+	bool _sorted;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	static const int pass_bits = 4;
+	static const int program_bits = 12;
+	static const int format_bits = 12;
+	static const int material_bits = 12;
+	static const int depth_bits = 24;
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	render_queue() :
+		_sorted(true)
+	{}
+	explicit render_queue(int reserve) :
+		_sorted(true)
+	{
+		_items.reserve(reserve);
+		_entries.reserve(reserve);
+		_temp.reserve(reserve);
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 不透明用のキー
+	// 同じプログラム, フォーマット, マテリアルをまとめ, その中では手前から描画する
+	// depthは0.0-1.0
+	static key_type key(int pass, int prog, int format, int material, float depth)
+	{
+		return (field(pass, pass_bits) << (program_bits + format_bits + material_bits + depth_bits)) |
+			(field(prog, program_bits) << (format_bits + material_bits + depth_bits)) |
+			(field(format, format_bits) << (material_bits + depth_bits)) |
+			(field(material, material_bits) << depth_bits) |
+			quantize(depth);
+	}
+	// 半透明用のキー
+	// 奥から描画することを優先し, 同じ深度の中で状態をまとめる
+	static key_type translucent_key(int pass, float depth, int prog, int format, int material)
+	{
+		const int material8 = 8;
+		return (field(pass, pass_bits) << (depth_bits + program_bits + format_bits + material8)) |
+			((quantize(1.0f - depth)) << (program_bits + format_bits + material8)) |
+			(field(prog, program_bits) << (format_bits + material8)) |
+			(field(format, format_bits) << material8) |
+			field(material, material8);
+	}
+
+	// 描画の追加
+	void submit(key_type k, const item& it)
+	{
+		entry e;
+		e.key = k;
+		e.index = static_cast<int>(_items.size());
+		_items.push_back(it);
+		_entries.push_back(e);
+		_sorted = false;
+	}
+
+	// キーの昇順に並び替え(同じキーは追加順)
+	// 下位から8bitずつの基数ソートで, 全てのキーで同じ値になる桁は飛ばす
+	void sort()
+	{
+		if (_sorted)
+		{
+			return;
+		}
+		_sorted = true;
+		const size_t n = _entries.size();
+		if (n < 2)
+		{
+			return;
+		}
+		_temp.resize(n);
+		entry* src = &_entries[0];
+		entry* dst = &_temp[0];
+		for (int shift = 0; shift < 64; shift += 8)
+		{
+			size_t histogram[256] = { 0 };
+			for (size_t i = 0; i < n; ++i)
+			{
+				++histogram[(src[i].key >> shift) & 0xFF];
+			}
+			if (histogram[(src[0].key >> shift) & 0xFF] == n)
+			{
+				continue;
+			}
+			size_t sum = 0;
+			for (int i = 0; i < 256; ++i)
+			{
+				const size_t c = histogram[i];
+				histogram[i] = sum;
+				sum += c;
+			}
+			for (size_t i = 0; i < n; ++i)
+			{
+				dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+			}
+			std::swap(src, dst);
+		}
+		if (src != &_entries[0])
+		{
+			_entries.swap(_temp);
+		}
+	}
+
+	// 並び替えて描画
+	void execute()
+	{
+		sort();
+		_stats = statistics();
+		state_cache state;
+		state.reset();
+		for (size_t i = 0; i < _entries.size(); ++i)
+		{
+			draw(state, _items[_entries[i].index]);
+		}
+		glBindVertexArray(0);
+		if (state.indirect != ~0U && state.indirect != 0)
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		}
+	}
+
+	// 溜めた描画を消す
+	void clear()
+	{
+		_items.clear();
+		_entries.clear();
+		_sorted = true;
+	}
+
+	// 描画して消す
+	void flush()
+	{
+		execute();
+		clear();
+	}
+
+	// 溜めている描画の数
+	int size() const
+	{
+		return static_cast<int>(_items.size());
+	}
+	bool empty() const
+	{
+		return _items.empty();
+	}
+
+	// 並び替え後のキー
+	key_type key(int i) const
+	{
+		return _entries[i].key;
+	}
+
+	// 直前のexecuteでの切り替え回数
+	const statistics& stats() const
+	{
+		return _stats;
+	}
+
+private:
+	static key_type field(int v, int bits)
+	{
+		return static_cast<key_type>(v) & ((static_cast<key_type>(1) << bits) - 1);
+	}
+	static key_type quantize(float depth)
+	{
+		const float max = static_cast<float>((1 << depth_bits) - 1);
+		depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+		return static_cast<key_type>(depth * max);
+	}
+
+	void draw(state_cache& state, const item& it)
+	{
+		if (it.prog != NULL && it.prog->get() != state.prog)
+		{
+			state.prog = it.prog->get();
+			it.prog->bind();
+			++_stats.programs;
+		}
+		if (it.vao != NULL && it.vao->get() != state.vao)
+		{
+			state.vao = it.vao->get();
+			it.vao->bind();
+			++_stats.vertex_arrays;
+			// VAOが変わると頂点バッファとインデックスバッファも変わる
+			state.vbo = ~0U;
+			state.ibo = ~0U;
+		}
+		if (it.vbo != 0 && (it.vbo != state.vbo || it.vbo_offset != state.vbo_offset || it.vbo_stride != state.vbo_stride))
+		{
+			state.vbo = it.vbo;
+			state.vbo_offset = it.vbo_offset;
+			state.vbo_stride = it.vbo_stride;
+			glBindVertexBuffer(0, it.vbo, it.vbo_offset, it.vbo_stride);
+			++_stats.vertex_buffers;
+		}
+		if (it.ibo != 0 && it.ibo != state.ibo)
+		{
+			state.ibo = it.ibo;
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, it.ibo);
+			++_stats.index_buffers;
+		}
+		if (it.texture_id != 0 && (it.texture_id != state.texture_id || it.texture_target != state.texture_target))
+		{
+			state.texture_target = it.texture_target;
+			state.texture_id = it.texture_id;
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(it.texture_target, it.texture_id);
+			++_stats.textures;
+		}
+		const GLuint samp = it.samp != NULL ? it.samp->get() : 0;
+		if (it.texture_id != 0 && samp != state.samp)
+		{
+			state.samp = samp;
+			glBindSampler(0, samp);
+			++_stats.samplers;
+		}
+		if (it.uniform_id != 0 && (it.uniform_id != state.uniform_id || it.uniform_point != state.uniform_point ||
+			it.uniform_offset != state.uniform_offset || it.uniform_size != state.uniform_size))
+		{
+			state.uniform_id = it.uniform_id;
+			state.uniform_point = it.uniform_point;
+			state.uniform_offset = it.uniform_offset;
+			state.uniform_size = it.uniform_size;
+			if (it.uniform_size > 0)
+			{
+				glBindBufferRange(GL_UNIFORM_BUFFER, it.uniform_point, it.uniform_id, it.uniform_offset, it.uniform_size);
+			}
+			else
+			{
+				glBindBufferBase(GL_UNIFORM_BUFFER, it.uniform_point, it.uniform_id);
+			}
+			++_stats.uniform_buffers;
+		}
+
+		++_stats.draws;
+		if (it.indirect != NULL)
+		{
+			if (it.indirect->get() != state.indirect)
+			{
+				state.indirect = it.indirect->get();
+				it.indirect->bind();
+			}
+			if (it.index_type != 0)
+			{
+				glDrawElementsIndirect(it.type, it.index_type, POCKET_BUFFER_OFFSET(it.indirect_offset));
+			}
+			else
+			{
+				glDrawArraysIndirect(it.type, POCKET_BUFFER_OFFSET(it.indirect_offset));
+			}
+			return;
+		}
+
+		const bool instancing = it.instances != 1 || it.base_instance != 0;
+		if (it.index_type != 0)
+		{
+			if (instancing)
+			{
+				glDrawElementsInstancedBaseVertexBaseInstance(it.type, it.count, it.index_type, POCKET_BUFFER_OFFSET(it.offset),
+					it.instances, it.base_vertex, it.base_instance);
+			}
+			else if (it.base_vertex != 0)
+			{
+				glDrawElementsBaseVertex(it.type, it.count, it.index_type, POCKET_BUFFER_OFFSET(it.offset), it.base_vertex);
+			}
+			else
+			{
+				glDrawElements(it.type, it.count, it.index_type, POCKET_BUFFER_OFFSET(it.offset));
+			}
+		}
+		else
+		{
+			if (instancing)
+			{
+				glDrawArraysInstancedBaseInstance(it.type, it.first, it.count, it.instances, it.base_instance);
+			}
+			else
+			{
+				glDrawArrays(it.type, it.first, it.count);
+			}
+		}
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const render_queue& v)
+{
+	const render_queue::statistics& s = v.stats();
+	os << io::widen("render_queue: {") << std::endl <<
+		io::tab << io::widen("size: ") << v.size() << std::endl <<
+		io::tab << io::widen("draws: ") << s.draws << std::endl <<
+		io::tab << io::widen("programs: ") << s.programs << std::endl <<
+		io::tab << io::widen("vertex_arrays: ") << s.vertex_arrays << std::endl <<
+		io::tab << io::widen("vertex_buffers: ") << s.vertex_buffers << std::endl <<
+		io::tab << io::widen("index_buffers: ") << s.index_buffers << std::endl <<
+		io::tab << io::widen("textures: ") << s.textures << std::endl <<
+		io::tab << io::widen("samplers: ") << s.samplers << std::endl <<
+		io::tab << io::widen("uniform_buffers: ") << s.uniform_buffers << std::endl <<
+		io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_RENDER_QUEUE_H__
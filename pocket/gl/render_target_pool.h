@@ -0,0 +1,460 @@
+﻿#ifndef __POCKET_GL_RENDER_TARGET_POOL_H__
+#define __POCKET_GL_RENDER_TARGET_POOL_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "texture.h"
+#include "framebuffer.h"
+#include "../io.h"
+#include <vector>
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class render_target_pool;
+
+//---------------------------------------------------------------------------------------
+// 描画先の使い回し
+// パスごとに必要な描画先を形式と大きさで借り, 使い終わったら返す
+// 返したものは同じ形式と大きさを要求した後のパスに渡すため, フレーム内の一時的な描画先の数が減る
+// 取り付ける組み合わせが同じフレームバッファも作り直さずに使い回す
+// next_frameで全て返し, keepフレームの間使われなかったものを削除する
+//
+// gl::render_target_pool pool;
+// gl::texture2d& hdr = pool.acquire_texture(GL_RGBA16F, w, h);
+// gl::renderbuffer& depth = pool.acquire_renderbuffer(GL_DEPTH_COMPONENT24, w, h);
+// gl::framebuffer& fb = pool.acquire_framebuffer(hdr, depth);
+// ...
+// pool.release(depth); // 深度は次のパスで別の用途に使われてよい
+// ...
+// pool.next_frame();
+//---------------------------------------------------------------------------------------
+class render_target_pool
+{
+private:
+	// 描画先
+	struct target
+	{
+		texture2d* tex; // どちらか一方
+		renderbuffer* rb;
+		GLenum format;
+		int width;
+		int height;
+		int samples; // テクスチャはレベル数
+		bool used;
+		int frame; // 最後に借りたフレーム
+	};
+	// 取り付けの組み合わせと作成したフレームバッファ
+	struct framebuffer_entry
+	{
+		std::vector<GLuint> key; // 取り付け先ごとに場所, 種類(GL_TEXTURE, GL_RENDERBUFFER), 名前の3つを並べたもの
+		framebuffer* fb;
+		int frame;
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::vector<target> _targets;
+	std::vector<framebuffer_entry> _framebuffers;
+	int _frame;
+	int _created;
+	int _reused;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	render_target_pool() :
+		_frame(0),
+		_created(0),
+		_reused(0)
+	{}
+	~render_target_pool()
+	{
+		finalize();
+	}
+
+private:
+	// 描画先を共有しないように複製は禁止
+	render_target_pool(const render_target_pool&);
+	render_target_pool& operator = (const render_target_pool&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 終了処理
+	// 全ての描画先とフレームバッファを削除する
+	void finalize()
+	{
+		for (size_t i = 0; i < _framebuffers.size(); ++i)
+		{
+			delete _framebuffers[i].fb;
+		}
+		_framebuffers.clear();
+		for (size_t i = 0; i < _targets.size(); ++i)
+		{
+			delete _targets[i].tex;
+			delete _targets[i].rb;
+		}
+		_targets.clear();
+		_frame = 0;
+		_created = 0;
+		_reused = 0;
+	}
+
+	// 2Dテクスチャの描画先を借りる
+	texture2d& acquire_texture(GLenum format, int width, int height, int levels = 1)
+	{
+		target* t = find(true, format, width, height, levels);
+		if (t == NULL)
+		{
+			t = create(format, width, height, levels);
+			t->tex = new texture2d(format, width, height, levels);
+		}
+		return *t->tex;
+	}
+	// レンダーバッファの描画先を借りる
+	renderbuffer& acquire_renderbuffer(GLenum format, int width, int height, int samples = 0)
+	{
+		target* t = find(false, format, width, height, samples);
+		if (t == NULL)
+		{
+			t = create(format, width, height, samples);
+			t->rb = new renderbuffer(format, width, height, samples);
+		}
+		return *t->rb;
+	}
+
+	// 返す
+	void release(const texture& tex)
+	{
+		for (size_t i = 0; i < _targets.size(); ++i)
+		{
+			if (_targets[i].tex != NULL && _targets[i].tex->get() == tex.get())
+			{
+				_targets[i].used = false;
+				return;
+			}
+		}
+	}
+	void release(const renderbuffer& rb)
+	{
+		for (size_t i = 0; i < _targets.size(); ++i)
+		{
+			if (_targets[i].rb != NULL && _targets[i].rb->get() == rb.get())
+			{
+				_targets[i].used = false;
+				return;
+			}
+		}
+	}
+
+	// 取り付けた組み合わせのフレームバッファ
+	// 色はGL_COLOR_ATTACHMENT0から順に取り付ける, depthがNULLの時は深度なし
+	framebuffer& acquire_framebuffer(const texture* const* colors, int count, const renderbuffer* depth = NULL,
+		GLenum depth_attachment = GL_DEPTH_ATTACHMENT)
+	{
+		std::vector<GLuint> key;
+		key.reserve(count * 3 + 3);
+		for (int i = 0; i < count; ++i)
+		{
+			key.push_back(GL_COLOR_ATTACHMENT0 + i);
+			key.push_back(GL_TEXTURE);
+			key.push_back(colors[i]->get());
+		}
+		append_depth(key, depth, depth_attachment);
+
+		framebuffer* fb = find(key);
+		if (fb == NULL)
+		{
+			fb = create(key);
+			for (int i = 0; i < count; ++i)
+			{
+				fb->attach(GL_COLOR_ATTACHMENT0 + i, *colors[i]);
+			}
+			if (depth != NULL)
+			{
+				fb->attach(depth_attachment, *depth);
+			}
+		}
+		return *fb;
+	}
+	// 深度もテクスチャ(シャドウマップなど), 色がなくてもよい
+	framebuffer& acquire_framebuffer(const texture* const* colors, int count, const texture& depth,
+		GLenum depth_attachment = GL_DEPTH_ATTACHMENT)
+	{
+		std::vector<GLuint> key;
+		key.reserve(count * 3 + 3);
+		for (int i = 0; i < count; ++i)
+		{
+			key.push_back(GL_COLOR_ATTACHMENT0 + i);
+			key.push_back(GL_TEXTURE);
+			key.push_back(colors[i]->get());
+		}
+		key.push_back(depth_attachment);
+		key.push_back(GL_TEXTURE);
+		key.push_back(depth.get());
+
+		framebuffer* fb = find(key);
+		if (fb == NULL)
+		{
+			fb = create(key);
+			for (int i = 0; i < count; ++i)
+			{
+				fb->attach(GL_COLOR_ATTACHMENT0 + i, *colors[i]);
+			}
+			fb->attach(depth_attachment, depth);
+		}
+		return *fb;
+	}
+	framebuffer& acquire_framebuffer(const renderbuffer* const* colors, int count, const renderbuffer* depth = NULL,
+		GLenum depth_attachment = GL_DEPTH_ATTACHMENT)
+	{
+		std::vector<GLuint> key;
+		key.reserve(count * 3 + 3);
+		for (int i = 0; i < count; ++i)
+		{
+			key.push_back(GL_COLOR_ATTACHMENT0 + i);
+			key.push_back(GL_RENDERBUFFER);
+			key.push_back(colors[i]->get());
+		}
+		append_depth(key, depth, depth_attachment);
+
+		framebuffer* fb = find(key);
+		if (fb == NULL)
+		{
+			fb = create(key);
+			for (int i = 0; i < count; ++i)
+			{
+				fb->attach(GL_COLOR_ATTACHMENT0 + i, *colors[i]);
+			}
+			if (depth != NULL)
+			{
+				fb->attach(depth_attachment, *depth);
+			}
+		}
+		return *fb;
+	}
+	framebuffer& acquire_framebuffer(const texture& color)
+	{
+		const texture* colors[] = { &color };
+		return acquire_framebuffer(colors, 1);
+	}
+	framebuffer& acquire_framebuffer(const texture& color, const renderbuffer& depth, GLenum depth_attachment = GL_DEPTH_ATTACHMENT)
+	{
+		const texture* colors[] = { &color };
+		return acquire_framebuffer(colors, 1, &depth, depth_attachment);
+	}
+	// MSAAの描画先など
+	framebuffer& acquire_framebuffer(const renderbuffer& color, const renderbuffer& depth, GLenum depth_attachment = GL_DEPTH_ATTACHMENT)
+	{
+		const renderbuffer* colors[] = { &color };
+		return acquire_framebuffer(colors, 1, &depth, depth_attachment);
+	}
+
+	// フレームの終わり
+	// 全ての描画先を返し, keepフレームの間借りられなかった描画先とフレームバッファを削除する
+	void next_frame(int keep = 2)
+	{
+		++_frame;
+		// フレームバッファを先に削除する
+		for (size_t i = 0; i < _framebuffers.size(); )
+		{
+			if (_frame - _framebuffers[i].frame > keep)
+			{
+				delete _framebuffers[i].fb;
+				_framebuffers.erase(_framebuffers.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+		for (size_t i = 0; i < _targets.size(); )
+		{
+			target& t = _targets[i];
+			t.used = false;
+			if (_frame - t.frame > keep)
+			{
+				const GLuint id = t.tex != NULL ? t.tex->get() : t.rb->get();
+				remove_framebuffers(t.tex != NULL ? GL_TEXTURE : GL_RENDERBUFFER, id);
+				delete t.tex;
+				delete t.rb;
+				_targets.erase(_targets.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	// 持っている描画先の数
+	int count() const
+	{
+		return static_cast<int>(_targets.size());
+	}
+	// 借りられている描画先の数
+	int used() const
+	{
+		int n = 0;
+		for (size_t i = 0; i < _targets.size(); ++i)
+		{
+			if (_targets[i].used)
+			{
+				++n;
+			}
+		}
+		return n;
+	}
+	// 持っているフレームバッファの数
+	int framebuffers() const
+	{
+		return static_cast<int>(_framebuffers.size());
+	}
+	// 作成した描画先の数
+	int created() const
+	{
+		return _created;
+	}
+	// 使い回した描画先の数
+	int reused() const
+	{
+		return _reused;
+	}
+	// 今のフレーム
+	int frame() const
+	{
+		return _frame;
+	}
+
+private:
+	target* find(bool is_texture, GLenum format, int width, int height, int samples)
+	{
+		for (size_t i = 0; i < _targets.size(); ++i)
+		{
+			target& t = _targets[i];
+			if (!t.used && (t.tex != NULL) == is_texture &&
+				t.format == format && t.width == width && t.height == height && t.samples == samples)
+			{
+				t.used = true;
+				t.frame = _frame;
+				++_reused;
+				return &t;
+			}
+		}
+		return NULL;
+	}
+	target* create(GLenum format, int width, int height, int samples)
+	{
+		target t;
+		t.tex = NULL;
+		t.rb = NULL;
+		t.format = format;
+		t.width = width;
+		t.height = height;
+		t.samples = samples;
+		t.used = true;
+		t.frame = _frame;
+		_targets.push_back(t);
+		++_created;
+		return &_targets.back();
+	}
+
+	static void append_depth(std::vector<GLuint>& key, const renderbuffer* depth, GLenum depth_attachment)
+	{
+		if (depth != NULL)
+		{
+			key.push_back(depth_attachment);
+			key.push_back(GL_RENDERBUFFER);
+			key.push_back(depth->get());
+		}
+	}
+
+	framebuffer* find(const std::vector<GLuint>& key)
+	{
+		for (size_t i = 0; i < _framebuffers.size(); ++i)
+		{
+			if (_framebuffers[i].key == key)
+			{
+				_framebuffers[i].frame = _frame;
+				return _framebuffers[i].fb;
+			}
+		}
+		return NULL;
+	}
+	framebuffer* create(const std::vector<GLuint>& key)
+	{
+		framebuffer_entry e;
+		e.key = key;
+		e.fb = new framebuffer();
+		e.fb->initialize();
+		e.frame = _frame;
+		_framebuffers.push_back(e);
+		return e.fb;
+	}
+
+	// 描画先を取り付けているフレームバッファを削除する
+	// キーは取り付け先ごとの3つ組なので, 組の境目からのみ比べる
+	void remove_framebuffers(GLenum type, GLuint id)
+	{
+		for (size_t i = 0; i < _framebuffers.size(); )
+		{
+			const std::vector<GLuint>& key = _framebuffers[i].key;
+			bool found = false;
+			for (size_t k = 0; k + 2 < key.size(); k += 3)
+			{
+				if (key[k + 1] == static_cast<GLuint>(type) && key[k + 2] == id)
+				{
+					found = true;
+					break;
+				}
+			}
+			if (found)
+			{
+				delete _framebuffers[i].fb;
+				_framebuffers.erase(_framebuffers.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const render_target_pool& v)
+{
+	os << io::widen("render_target_pool: {") << std::endl <<
+		io::tab << io::widen("count: ") << v.count() << std::endl <<
+		io::tab << io::widen("used: ") << v.used() << std::endl <<
+		io::tab << io::widen("framebuffers: ") << v.framebuffers() << std::endl <<
+		io::tab << io::widen("created: ") << v.created() << std::endl <<
+		io::tab << io::widen("reused: ") << v.reused() << std::endl <<
+		io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_RENDER_TARGET_POOL_H__
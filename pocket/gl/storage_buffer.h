@@ -0,0 +1,417 @@
+﻿#ifndef __POCKET_GL_STORAGE_BUFFER_H__
+#define __POCKET_GL_STORAGE_BUFFER_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "block_layout.h"
+#include "../io.h"
+#include <vector>
+#include <cstring> // for std::memcpy
+#include <algorithm> // for std::min
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+template <typename> class storage_buffer;
+
+//---------------------------------------------------------------------------------------
+// シェーダーストレージバッファ(SSBO)
+// T型の配列をglBufferStorageで確保し, 永続的に展開したまま書き込む
+// regions個の領域を順番に使い, GPUが読み終わっていない領域にはフェンスで待ってから書き込む
+// Tはstd430の配列の要素と同じ大きさであること(vector3fは不可)
+//
+// // layout(std430, binding = 0) buffer instances { mat4 world[]; };
+// gl::storage_buffer<math::matrix4x4f> instances(10000, 3);
+// do
+// {
+//     instances.begin(); // 書き込む領域の切り替え
+//     for (int i = 0; i < n; ++i)
+//     {
+//         instances[i] = world[i];
+//     }
+//     instances.bind_range(0, 0, n);
+//     draw...
+// } while (...);
+//---------------------------------------------------------------------------------------
+template <typename T>
+class storage_buffer
+{
+	// std430での配列の間隔がsizeof(T)と一致しなければ要素の位置がずれる
+	POCKET_STATICAL_ASSERT(static_cast<size_t>(detail::block_type_layout<block_layout_type::std430, T[1]>::array_stride) == sizeof(T),
+		storage_buffer_element_is_not_std430_array_stride);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	typedef T value_type;
+
+	enum identifier_t
+	{
+		identifier = GL_BUFFER
+	};
+
+private:
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	gl::buffer _buffer;
+	T* _data; // 展開した先頭
+	std::vector<GLsync> _fences; // 領域ごと
+	int _count; // 1領域の要素数
+	int _stride; // 1領域のバイト数
+	int _current;
+	int _stalled;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	storage_buffer() :
+		_buffer(),
+		_data(NULL),
+		_count(0),
+		_stride(0),
+		_current(0),
+		_stalled(0),
+		_error_bitfield(0)
+	{}
+	// count: 1領域の要素数, regions: GPUが読み終わるのを待たずに書き込める領域の数
+	explicit storage_buffer(int count, int regions = 1, const T* data = NULL) :
+		_buffer(),
+		_data(NULL),
+		_count(0),
+		_stride(0),
+		_current(0),
+		_stalled(0),
+		_error_bitfield(0)
+	{
+		initialize(count, regions, data);
+	}
+	~storage_buffer()
+	{
+		finalize();
+	}
+
+private:
+	// 展開したアドレスとフェンスを共有しないように複製は禁止
+	storage_buffer(const storage_buffer&);
+	storage_buffer& operator = (const storage_buffer&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	// dataは全ての領域の初期値
+	bool initialize(int count, int regions = 1, const T* data = NULL)
+	{
+		finalize();
+
+		if (count < 1 || regions < 1)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return false;
+		}
+
+		// 領域の先頭はGL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENTに揃える
+		GLint alignment = 256;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if (alignment < 1)
+		{
+			alignment = 256;
+		}
+		const int bytes = static_cast<int>(sizeof(T)) * count;
+		_stride = (bytes + alignment - 1) / alignment * alignment;
+		_count = count;
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		if (!_buffer.initialize_storage(buffer_type::shader_storage, _stride * regions, NULL, flags | GL_DYNAMIC_STORAGE_BIT))
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		_buffer.bind();
+		void* address = glMapBufferRange(buffer_type::shader_storage, 0, static_cast<GLsizeiptr>(_stride * regions), flags);
+		_buffer.unbind();
+		if (address == NULL)
+		{
+			_buffer.finalize();
+			_error_bitfield |= error_binding;
+			return false;
+		}
+		_data = static_cast<T*>(address);
+		_fences.resize(regions, NULL);
+
+		if (data != NULL)
+		{
+			for (int i = 0; i < regions; ++i)
+			{
+				std::memcpy(region(i), data, bytes);
+			}
+		}
+		return true;
+	}
+
+	// 終了処理
+	void finalize()
+	{
+		for (size_t i = 0; i < _fences.size(); ++i)
+		{
+			if (_fences[i] != NULL)
+			{
+				glDeleteSync(_fences[i]);
+			}
+		}
+		_fences.clear();
+		if (_data != NULL)
+		{
+			_buffer.bind();
+			glUnmapBuffer(buffer_type::shader_storage);
+			_buffer.unbind();
+			_data = NULL;
+		}
+		_buffer.finalize();
+		_count = 0;
+		_stride = 0;
+		_current = 0;
+		_stalled = 0;
+		_error_bitfield = 0;
+	}
+
+	// 書き込む領域の切り替え
+	// 今の領域を使う描画の後ろにフェンスを置き, 次の領域をGPUが読み終わるまで待つ
+	// 領域が一つの時は前の描画が終わるまで待つ
+	void begin()
+	{
+		if (_fences.empty())
+		{
+			return;
+		}
+		fence();
+		_current = (_current + 1) % static_cast<int>(_fences.size());
+		wait();
+	}
+
+	// 今の領域を使う描画の後ろにフェンスを置く
+	void fence()
+	{
+		if (_fences.empty())
+		{
+			return;
+		}
+		GLsync& f = _fences[_current];
+		if (f != NULL)
+		{
+			glDeleteSync(f);
+		}
+		f = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	// 今の領域をGPUが読み終わるまで待つ
+	void wait()
+	{
+		if (_fences.empty())
+		{
+			return;
+		}
+		GLsync& f = _fences[_current];
+		if (f == NULL)
+		{
+			return;
+		}
+		if (glClientWaitSync(f, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			++_stalled;
+			glClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		}
+		glDeleteSync(f);
+		f = NULL;
+	}
+
+	// 今の領域への書き込み
+	void write(int first, const T* values, int n)
+	{
+		n = std::min(n, _count - first);
+		if (n > 0)
+		{
+			std::memcpy(data() + first, values, sizeof(T) * n);
+		}
+	}
+
+	// 今の領域をバインディングポイントに設定
+	void bind_base(GLuint point) const
+	{
+		bind_range(point, 0, _count);
+	}
+	// firstからn個の要素を設定
+	// firstの位置がGL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENTに揃っていること
+	void bind_range(GLuint point, int first, int n) const
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, point, _buffer.get(),
+			static_cast<GLintptr>(_stride * _current + sizeof(T) * first), static_cast<GLsizeiptr>(sizeof(T) * n));
+	}
+	void unbind_base(GLuint point) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, point, 0);
+	}
+
+	// 今の領域の先頭
+	T* data()
+	{
+		return region(_current);
+	}
+	const T* data() const
+	{
+		return region(_current);
+	}
+
+	// 1領域の要素数
+	int count() const
+	{
+		return _count;
+	}
+	// 1領域のバイト数
+	int size() const
+	{
+		return static_cast<int>(sizeof(T)) * _count;
+	}
+	// 領域の数
+	int regions() const
+	{
+		return static_cast<int>(_fences.size());
+	}
+	// 今の領域の番号
+	int current() const
+	{
+		return _current;
+	}
+	// GPUが読み終わるのを待った回数
+	int stalled() const
+	{
+		return _stalled;
+	}
+
+	// 全体のバッファ
+	const gl::buffer& buffer() const
+	{
+		return _buffer;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "count or regions is less than 1.";
+		}
+		if (error_status(error_creating))
+		{
+			return _buffer.error();
+		}
+		if (error_status(error_binding))
+		{
+			return "glMapBufferRange().";
+		}
+		if (_data == NULL)
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return _data != NULL && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+	T& operator [] (int i)
+	{
+		return data()[i];
+	}
+	const T& operator [] (int i) const
+	{
+		return data()[i];
+	}
+
+private:
+	T* region(int n) const
+	{
+		return reinterpret_cast<T*>(reinterpret_cast<char*>(_data) + _stride * n);
+	}
+};
+
+//------------------------------
+// make_storage_buffer
+//------------------------------
+
+template <typename T> inline
+storage_buffer<T>& make_storage_buffer(storage_buffer<T>& b, int count, int regions = 1, const T* data = NULL)
+{
+	b.initialize(count, regions, data);
+	return b;
+}
+
+template <typename CharT, typename CharTraits, typename T> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const storage_buffer<T>& v)
+{
+	os << io::widen("storage_buffer: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.buffer().get() << std::endl <<
+		io::tab << io::widen("count: ") << v.count() << std::endl <<
+		io::tab << io::widen("size: ") << v.size() << std::endl <<
+		io::tab << io::widen("regions: ") << v.regions() << std::endl <<
+		io::tab << io::widen("stalled: ") << v.stalled() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_STORAGE_BUFFER_H__
@@ -0,0 +1,646 @@
+﻿#ifndef __POCKET_GL_TEXTURE_H__
+#define __POCKET_GL_TEXTURE_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "sampler.h"
+#include "../io.h"
+#include <algorithm> // for std::max
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class texture;
+class texture2d;
+class texture2d_array;
+class texture_cube;
+class texture3d;
+
+//---------------------------------------------------------------------------------------
+// テクスチャ
+// glTexStorage*で変更できない領域を確保し, glTexSubImage*で書き込む
+// 書き込みは今のテクスチャユニットにバインドして行い, 終わったらバインドを解除する
+// GL_PIXEL_UNPACK_BUFFERをバインドしている時はdataにバッファの位置(POCKET_BUFFER_OFFSET)を渡す
+//
+// gl::texture2d albedo(GL_RGBA8, 1024, 1024); // levelsが0の時はミップマップを全て確保
+// albedo.write(0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+// albedo.generate_mipmap();
+// ...
+// albedo.bind(0, linear_sampler); // ユニット0にテクスチャとサンプラーを設定
+//---------------------------------------------------------------------------------------
+class texture
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	typedef binder1<texture, GLuint> binder_type;
+
+protected:
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	GLuint _id;
+	texture_type_t _target;
+	GLenum _format; // 内部形式
+	int _width;
+	int _height;
+	int _depth; // 3Dは奥行き, 配列は層の数, キューブマップは6
+	int _levels;
+	int _base_level;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	texture() :
+		_id(0),
+		_target(texture_type::unknown),
+		_format(0),
+		_width(0),
+		_height(0),
+		_depth(0),
+		_levels(0),
+		_base_level(0),
+		_error_bitfield(0)
+	{}
+	explicit texture(texture_type_t target, GLenum format, int width, int height, int depth, int levels = 0) :
+		_id(0),
+		_target(texture_type::unknown),
+		_format(0),
+		_width(0),
+		_height(0),
+		_depth(0),
+		_levels(0),
+		_base_level(0),
+		_error_bitfield(0)
+	{
+		initialize(target, format, width, height, depth, levels);
+	}
+	texture(const texture& t) :
+		_id(t._id),
+		_target(t._target),
+		_format(t._format),
+		_width(t._width),
+		_height(t._height),
+		_depth(t._depth),
+		_levels(t._levels),
+		_base_level(t._base_level),
+		_error_bitfield(t._error_bitfield)
+	{}
+#ifdef POCKET_USE_CXX11
+	texture(texture&& t) POCKET_CXX11_NOEXCEPT :
+		_id(std::move(t._id)),
+		_target(std::move(t._target)),
+		_format(std::move(t._format)),
+		_width(std::move(t._width)),
+		_height(std::move(t._height)),
+		_depth(std::move(t._depth)),
+		_levels(std::move(t._levels)),
+		_base_level(std::move(t._base_level)),
+		_error_bitfield(std::move(t._error_bitfield))
+	{
+		t._id = 0;
+		t._target = texture_type::unknown;
+		t._format = 0;
+		t._width = 0;
+		t._height = 0;
+		t._depth = 0;
+		t._levels = 0;
+		t._base_level = 0;
+		t._error_bitfield = 0;
+	}
+#endif // POCKET_USE_CXX11
+	~texture()
+	{
+		finalize();
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	// levelsが0の時は1x1までのミップマップを全て確保する
+	bool initialize(texture_type_t target, GLenum format, int width, int height, int depth, int levels = 0)
+	{
+		finalize();
+
+		if (target == texture_type::texture_2d || target == texture_type::texture_cube)
+		{
+			depth = target == texture_type::texture_cube ? 6 : 1;
+		}
+		if (width < 1 || height < 1 || depth < 1 ||
+			(target == texture_type::texture_cube && width != height))
+		{
+			_error_bitfield |= error_invalid_data;
+			return false;
+		}
+		const int count = level_count(width, height, target == texture_type::texture_3d ? depth : 1);
+		if (levels <= 0 || levels > count)
+		{
+			levels = count;
+		}
+
+		glGenTextures(1, &_id);
+		if (_id == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		glBindTexture(target, _id);
+		switch (target)
+		{
+		case texture_type::texture_2d:
+		case texture_type::texture_cube:
+			glTexStorage2D(target, levels, format, width, height);
+			break;
+		case texture_type::texture_2d_array:
+		case texture_type::texture_3d:
+			glTexStorage3D(target, levels, format, width, height, depth);
+			break;
+		default:
+			break;
+		}
+		glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		glBindTexture(target, 0);
+
+		if (glIsTexture(_id) == GL_FALSE)
+		{
+			glDeleteTextures(1, &_id);
+			_id = 0;
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		_target = target;
+		_format = format;
+		_width = width;
+		_height = height;
+		_depth = depth;
+		_levels = levels;
+		_base_level = 0;
+		return true;
+	}
+
+	// 終了処理
+	void finalize()
+	{
+		if (_id != 0)
+		{
+			glDeleteTextures(1, &_id);
+			_id = 0;
+		}
+		_target = texture_type::unknown;
+		_format = 0;
+		_width = 0;
+		_height = 0;
+		_depth = 0;
+		_levels = 0;
+		_base_level = 0;
+		_error_bitfield = 0;
+	}
+
+	// 領域への書き込み
+	// 2Dとキューブマップ(zが面), 配列(zが層), 3Dの全てで使える
+	// キューブマップで複数の面に書き込む時は面の間が詰まっていること
+	void write(int level, int x, int y, int z, int width, int height, int depth, GLenum format, GLenum type, const void* data) const
+	{
+		glBindTexture(_target, _id);
+		switch (_target)
+		{
+		case texture_type::texture_2d:
+			glTexSubImage2D(_target, level, x, y, width, height, format, type, data);
+			break;
+		case texture_type::texture_cube:
+			{
+				// 面ごとに書き込む(glTexSubImage3DはGL4.5から)
+				// 面の間隔はglTexSubImage2Dが読む範囲と同じく行の長さと揃えを考慮する
+				GLint alignment = 4, row_length = 0;
+				glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+				glGetIntegerv(GL_UNPACK_ROW_LENGTH, &row_length);
+				const size_t row = static_cast<size_t>(get_pixel_size(format, type)) * (row_length > 0 ? row_length : width);
+				const size_t face = (row + alignment - 1) / alignment * alignment * height;
+				const char* p = static_cast<const char*>(data);
+				for (int i = 0; i < depth; ++i)
+				{
+					glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + z + i, level, x, y, width, height, format, type, p + face * i);
+				}
+			}
+			break;
+		case texture_type::texture_2d_array:
+		case texture_type::texture_3d:
+			glTexSubImage3D(_target, level, x, y, z, width, height, depth, format, type, data);
+			break;
+		default:
+			break;
+		}
+		glBindTexture(_target, 0);
+	}
+	void write(int level, int x, int y, int width, int height, GLenum format, GLenum type, const void* data) const
+	{
+		write(level, x, y, 0, width, height, 1, format, type, data);
+	}
+	// レベル全体への書き込み
+	void write(int level, GLenum format, GLenum type, const void* data) const
+	{
+		write(level, 0, 0, 0, level_width(level), level_height(level), level_depth(level), format, type, data);
+	}
+
+	// level 0の内容からミップマップを作成
+	void generate_mipmap() const
+	{
+		glBindTexture(_target, _id);
+		glGenerateMipmap(_target);
+		glBindTexture(_target, 0);
+	}
+
+	// サンプリングする最も詳細なレベルを設定・取得
+	// 書き込みの済んでいない詳細なレベルを使わないようにする
+	void base_level(int level)
+	{
+		level = std::min(std::max(level, 0), _levels - 1);
+		glBindTexture(_target, _id);
+		glTexParameteri(_target, GL_TEXTURE_BASE_LEVEL, level);
+		glBindTexture(_target, 0);
+		_base_level = level;
+	}
+	int base_level() const
+	{
+		return _base_level;
+	}
+
+	// テクスチャユニットにバインド
+	// 今のテクスチャユニットはunitのままになる
+	void bind(GLuint unit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(_target, _id);
+	}
+	// サンプラーも同じユニットに設定
+	void bind(GLuint unit, const sampler& s) const
+	{
+		bind(unit);
+		s.bind(unit);
+	}
+	// バインド解除
+	void unbind(GLuint unit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(_target, 0);
+	}
+	void unbind(GLuint unit, const sampler& s) const
+	{
+		unbind(unit);
+		s.unbind(unit);
+	}
+
+	// バインド状態を管理するオブジェクト生成
+	binder_type make_binder(GLuint unit) const
+	{
+		return binder_type(*this, unit);
+	}
+
+	// レベルの大きさ
+	int level_width(int level) const
+	{
+		return std::max(_width >> level, 1);
+	}
+	int level_height(int level) const
+	{
+		return std::max(_height >> level, 1);
+	}
+	// 3D以外は小さくならない
+	int level_depth(int level) const
+	{
+		return _target == texture_type::texture_3d ? std::max(_depth >> level, 1) : _depth;
+	}
+	// 詰めて並べた時のレベル全体のバイト数(対応していない形式は0)
+	int level_size(int level, GLenum format, GLenum type) const
+	{
+		return get_pixel_size(format, type) * level_width(level) * level_height(level) * level_depth(level);
+	}
+
+	// 種類
+	texture_type_t target() const
+	{
+		return _target;
+	}
+	// 内部形式
+	GLenum format() const
+	{
+		return _format;
+	}
+	int width() const
+	{
+		return _width;
+	}
+	int height() const
+	{
+		return _height;
+	}
+	int depth() const
+	{
+		return _depth;
+	}
+	// ミップマップの数
+	int levels() const
+	{
+		return _levels;
+	}
+
+	// 1x1までのミップマップの数
+	static int level_count(int width, int height, int depth = 1)
+	{
+		int size = std::max(std::max(width, height), depth);
+		int n = 1;
+		while (size > 1)
+		{
+			size >>= 1;
+			++n;
+		}
+		return n;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_invalid_data))
+		{
+			return "invalid size.";
+		}
+		if (error_status(error_creating))
+		{
+			return "glGenTextures().";
+		}
+		if (_id == 0)
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		if (_id == 0 ||
+			_error_bitfield != 0)
+		{
+			return false;
+		}
+		return glIsTexture(_id) == GL_TRUE;
+	}
+
+	// ハンドルの取得
+	GLuint& get()
+	{
+		return _id;
+	}
+	const GLuint& get() const
+	{
+		return _id;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+	bool operator == (const texture& t) const
+	{
+		return _id == t._id;
+	}
+	bool operator != (const texture& t) const
+	{
+		return !(*this == t);
+	}
+
+	texture& operator = (const texture& t)
+	{
+		_id = t._id;
+		_target = t._target;
+		_format = t._format;
+		_width = t._width;
+		_height = t._height;
+		_depth = t._depth;
+		_levels = t._levels;
+		_base_level = t._base_level;
+		_error_bitfield = t._error_bitfield;
+		return *this;
+	}
+#ifdef POCKET_USE_CXX11
+	texture& operator = (texture&& t) POCKET_CXX11_NOEXCEPT
+	{
+		_id = std::move(t._id);
+		_target = std::move(t._target);
+		_format = std::move(t._format);
+		_width = std::move(t._width);
+		_height = std::move(t._height);
+		_depth = std::move(t._depth);
+		_levels = std::move(t._levels);
+		_base_level = std::move(t._base_level);
+		_error_bitfield = std::move(t._error_bitfield);
+		t._id = 0;
+		t._target = texture_type::unknown;
+		t._format = 0;
+		t._width = 0;
+		t._height = 0;
+		t._depth = 0;
+		t._levels = 0;
+		t._base_level = 0;
+		t._error_bitfield = 0;
+		return *this;
+	}
+
+	texture& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+};
+
+//---------------------------------------------------------------------------------------
+// 2Dテクスチャ
+//---------------------------------------------------------------------------------------
+class texture2d : public texture
+{
+public:
+	texture2d() :
+		texture()
+	{}
+	explicit texture2d(GLenum format, int width, int height, int levels = 0) :
+		texture(texture_type::texture_2d, format, width, height, 1, levels)
+	{}
+
+	// 初期化
+	bool initialize(GLenum format, int width, int height, int levels = 0)
+	{
+		return texture::initialize(texture_type::texture_2d, format, width, height, 1, levels);
+	}
+
+#ifdef POCKET_USE_CXX11
+	texture2d& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+};
+
+//---------------------------------------------------------------------------------------
+// 2Dテクスチャ配列
+//---------------------------------------------------------------------------------------
+class texture2d_array : public texture
+{
+public:
+	texture2d_array() :
+		texture()
+	{}
+	explicit texture2d_array(GLenum format, int width, int height, int layers, int levels = 0) :
+		texture(texture_type::texture_2d_array, format, width, height, layers, levels)
+	{}
+
+	// 初期化
+	bool initialize(GLenum format, int width, int height, int layers, int levels = 0)
+	{
+		return texture::initialize(texture_type::texture_2d_array, format, width, height, layers, levels);
+	}
+
+	// 層の数
+	int layers() const
+	{
+		return _depth;
+	}
+
+#ifdef POCKET_USE_CXX11
+	texture2d_array& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+};
+
+//---------------------------------------------------------------------------------------
+// キューブマップ
+// 面の番号はGL_TEXTURE_CUBE_MAP_POSITIVE_Xからの順番
+//---------------------------------------------------------------------------------------
+class texture_cube : public texture
+{
+public:
+	texture_cube() :
+		texture()
+	{}
+	explicit texture_cube(GLenum format, int size, int levels = 0) :
+		texture(texture_type::texture_cube, format, size, size, 6, levels)
+	{}
+
+	// 初期化
+	bool initialize(GLenum format, int size, int levels = 0)
+	{
+		return texture::initialize(texture_type::texture_cube, format, size, size, 6, levels);
+	}
+
+	// 面への書き込み
+	void write_face(int face, int level, GLenum format, GLenum type, const void* data) const
+	{
+		write(level, 0, 0, face, level_width(level), level_height(level), 1, format, type, data);
+	}
+
+#ifdef POCKET_USE_CXX11
+	texture_cube& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+};
+
+//---------------------------------------------------------------------------------------
+// 3Dテクスチャ
+//---------------------------------------------------------------------------------------
+class texture3d : public texture
+{
+public:
+	texture3d() :
+		texture()
+	{}
+	explicit texture3d(GLenum format, int width, int height, int depth, int levels = 0) :
+		texture(texture_type::texture_3d, format, width, height, depth, levels)
+	{}
+
+	// 初期化
+	bool initialize(GLenum format, int width, int height, int depth, int levels = 0)
+	{
+		return texture::initialize(texture_type::texture_3d, format, width, height, depth, levels);
+	}
+
+#ifdef POCKET_USE_CXX11
+	texture3d& operator = (std::nullptr_t)
+	{
+		finalize();
+		return *this;
+	}
+#endif // POCKET_USE_CXX11
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const texture& v)
+{
+	std::ios_base::fmtflags flag = os.flags();
+	os << io::widen("texture: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.get() << std::endl <<
+		io::tab << io::widen("target: 0x") << std::hex << v.target() << std::endl <<
+		io::tab << io::widen("format: 0x") << v.format() << std::dec << std::endl <<
+		io::tab << io::widen("size: [") << v.width() << io::widen(", ") << v.height() << io::widen(", ") << v.depth() << io::box_brackets_right << std::endl <<
+		io::tab << io::widen("levels: ") << v.levels() << std::endl <<
+		io::tab << io::widen("base level: ") << v.base_level() << std::endl;
+	os.flags(flag);
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_TEXTURE_H__
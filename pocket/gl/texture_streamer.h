@@ -0,0 +1,520 @@
+﻿#ifndef __POCKET_GL_TEXTURE_STREAMER_H__
+#define __POCKET_GL_TEXTURE_STREAMER_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "texture.h"
+#include "../io.h"
+#include <deque>
+#include <map>
+#include <functional> // for std::greater
+#include <cstring> // for std::memcpy
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class texture_streamer;
+
+//---------------------------------------------------------------------------------------
+// テクスチャの非同期書き込み
+// 永続的に展開したGL_PIXEL_UNPACK_BUFFERをリングとして使い, 画素を複製してからglTexSubImage*で送る
+// 転送はGPU側で行われるため, 書き込みの呼び出しでは待たない
+// リングの領域はフェンスでGPUが読み終わったことを確認してから再利用し, 空きがなければ次のフレームに回す
+//
+// streamはミップマップを小さいレベルから順に送り, 送り終わったレベルまでbase_levelを下げる
+// 全てのテクスチャの小さいレベルが先に揃うため, 読み込み中は粗いテクスチャで描画を続けられる
+// 画素の行は詰めて並べること(GL_UNPACK_ALIGNMENTは1で送る)
+//
+// gl::texture_streamer streamer(16 * 1024 * 1024);
+// gl::texture2d albedo(GL_RGBA8, 2048, 2048);
+// streamer.stream(albedo, GL_RGBA, GL_UNSIGNED_BYTE, mips); // mips[level]は完了するまで有効であること
+// do
+// {
+//     streamer.update(4 * 1024 * 1024); // 1フレームで送るバイト数
+//     albedo.bind(0, sampler);
+//     ...
+// } while (...);
+//---------------------------------------------------------------------------------------
+class texture_streamer
+{
+private:
+	// 送るレベル
+	struct request
+	{
+		texture* tex;
+		int level;
+		GLenum format;
+		GLenum type;
+		const void* data;
+	};
+	// 小さいレベルから順番に, 同じレベルは追加順
+	typedef std::multimap<int, request, std::greater<int> > request_map;
+
+	// フェンスを置いたリングの範囲
+	struct segment
+	{
+		GLsync fence;
+		int end;
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	gl::buffer _buffer;
+	char* _data; // 展開した先頭
+	int _size;
+	int _head; // 次に書き込む位置
+	int _tail; // GPUが読み終わっていない先頭
+	bool _unfenced; // フェンスを置いていない書き込みがあるか
+	std::deque<segment> _segments;
+	request_map _requests;
+	GLint _alignment; // 書き込み中に戻すGL_UNPACK_ALIGNMENT
+	int _uploaded;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	texture_streamer() :
+		_buffer(),
+		_data(NULL),
+		_size(0),
+		_head(0),
+		_tail(0),
+		_unfenced(false),
+		_alignment(4),
+		_uploaded(0),
+		_error_bitfield(0)
+	{}
+	// size: リングのバイト数
+	explicit texture_streamer(int size) :
+		_buffer(),
+		_data(NULL),
+		_size(0),
+		_head(0),
+		_tail(0),
+		_unfenced(false),
+		_alignment(4),
+		_uploaded(0),
+		_error_bitfield(0)
+	{
+		initialize(size);
+	}
+	~texture_streamer()
+	{
+		finalize();
+	}
+
+private:
+	// 展開したアドレスとフェンスを共有しないように複製は禁止
+	texture_streamer(const texture_streamer&);
+	texture_streamer& operator = (const texture_streamer&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	bool initialize(int size)
+	{
+		finalize();
+
+		if (size < 1)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return false;
+		}
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		if (!_buffer.initialize_storage(buffer_type::pixel_unpack, size, NULL, flags))
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		_buffer.bind();
+		void* address = glMapBufferRange(buffer_type::pixel_unpack, 0, static_cast<GLsizeiptr>(size), flags);
+		_buffer.unbind();
+		if (address == NULL)
+		{
+			_buffer.finalize();
+			_error_bitfield |= error_binding;
+			return false;
+		}
+		_data = static_cast<char*>(address);
+		_size = size;
+		return true;
+	}
+
+	// 終了処理
+	// 送っていないレベルは破棄する
+	void finalize()
+	{
+		for (size_t i = 0; i < _segments.size(); ++i)
+		{
+			glDeleteSync(_segments[i].fence);
+		}
+		_segments.clear();
+		_requests.clear();
+		if (_data != NULL)
+		{
+			_buffer.bind();
+			glUnmapBuffer(buffer_type::pixel_unpack);
+			_buffer.unbind();
+			_data = NULL;
+		}
+		_buffer.finalize();
+		_size = 0;
+		_head = 0;
+		_tail = 0;
+		_unfenced = false;
+		_uploaded = 0;
+		_error_bitfield = 0;
+	}
+
+	// リングを通して領域に書き込む
+	// リングに空きがなければ何もせずfalseを返す
+	bool write(texture& t, int level, int x, int y, int z, int width, int height, int depth, GLenum format, GLenum type, const void* data)
+	{
+		const int size = get_pixel_size(format, type) * width * height * depth;
+		if (size <= 0)
+		{
+			_error_bitfield |= error_invalid_data;
+			return false;
+		}
+		const int offset = allocate(size);
+		if (offset < 0)
+		{
+			return false;
+		}
+		std::memcpy(_data + offset, data, size);
+
+		begin();
+		t.write(level, x, y, z, width, height, depth, format, type, POCKET_BUFFER_OFFSET(offset));
+		end();
+		_uploaded += size;
+		return true;
+	}
+	bool write(texture& t, int level, int x, int y, int width, int height, GLenum format, GLenum type, const void* data)
+	{
+		return write(t, level, x, y, 0, width, height, 1, format, type, data);
+	}
+
+	// ミップマップを小さいレベルから順に送る
+	// levels[i]はレベルiの全体(配列は全ての層, キューブマップは全ての面)で, 送り終わるまで有効であること
+	// 送り終わるまでbase_levelは送ったレベルになる
+	void stream(texture& t, GLenum format, GLenum type, const void* const* levels)
+	{
+		if (get_pixel_size(format, type) == 0)
+		{
+			_error_bitfield |= error_invalid_data;
+			return;
+		}
+		cancel(t);
+		t.base_level(t.levels() - 1);
+		for (int i = 0; i < t.levels(); ++i)
+		{
+			request r;
+			r.tex = &t;
+			r.level = i;
+			r.format = format;
+			r.type = type;
+			r.data = levels[i];
+			_requests.insert(std::make_pair(i, r));
+		}
+	}
+
+	// 送っていないレベルを取り除く
+	// 読み込み中のテクスチャを破棄する前に呼ぶこと
+	void cancel(const texture& t)
+	{
+		for (request_map::iterator i = _requests.begin(); i != _requests.end(); )
+		{
+			if (i->second.tex->get() == t.get())
+			{
+				_requests.erase(i++);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	// フレームごとの更新
+	// GPUが読み終わった領域を再利用し, budgetバイトまで小さいレベルから送る
+	// リングより大きいレベルは直接送る
+	// 送ったレベルの数を返す
+	int update(int budget)
+	{
+		retire();
+
+		int n = 0;
+		int sent = 0;
+		begin();
+		while (!_requests.empty())
+		{
+			const request& r = _requests.begin()->second;
+			texture& t = *r.tex;
+			const int size = t.level_size(r.level, r.format, r.type);
+			if (sent > 0 && sent + size > budget)
+			{
+				break;
+			}
+			if (size > _size)
+			{
+				glBindBuffer(buffer_type::pixel_unpack, 0);
+				t.write(r.level, r.format, r.type, r.data);
+				_buffer.bind();
+			}
+			else
+			{
+				const int offset = allocate(size);
+				if (offset < 0)
+				{
+					// 空きがなければ次のフレームで送る
+					break;
+				}
+				std::memcpy(_data + offset, r.data, size);
+				t.write(r.level, r.format, r.type, POCKET_BUFFER_OFFSET(offset));
+			}
+			// 後の描画はGPU側で書き込みの後になるため, すぐにサンプリングできる
+			if (r.level < t.base_level())
+			{
+				t.base_level(r.level);
+			}
+			sent += size;
+			_uploaded += size;
+			++n;
+			_requests.erase(_requests.begin());
+		}
+		end();
+		fence();
+		return n;
+	}
+
+	// これまでの書き込みの後ろにフェンスを置く
+	void fence()
+	{
+		if (!_unfenced)
+		{
+			return;
+		}
+		segment s;
+		s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		s.end = _head;
+		_segments.push_back(s);
+		_unfenced = false;
+	}
+
+	// 送っていないレベルの数
+	int pending() const
+	{
+		return static_cast<int>(_requests.size());
+	}
+	// テクスチャの送っていないレベルの数
+	int pending(const texture& t) const
+	{
+		int n = 0;
+		for (request_map::const_iterator i = _requests.begin(); i != _requests.end(); ++i)
+		{
+			if (i->second.tex->get() == t.get())
+			{
+				++n;
+			}
+		}
+		return n;
+	}
+	// 全てのレベルを送り終わったか
+	bool done(const texture& t) const
+	{
+		return pending(t) == 0;
+	}
+
+	// リングのバイト数
+	int size() const
+	{
+		return _size;
+	}
+	// GPUが読み終わっていないバイト数
+	int used() const
+	{
+		return _head >= _tail ? _head - _tail : _size - _tail + _head;
+	}
+	// 送ったバイト数の合計
+	int uploaded() const
+	{
+		return _uploaded;
+	}
+
+	// リングのバッファ
+	const gl::buffer& buffer() const
+	{
+		return _buffer;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "size is less than 1.";
+		}
+		if (error_status(error_creating))
+		{
+			return _buffer.error();
+		}
+		if (error_status(error_binding))
+		{
+			return "glMapBufferRange().";
+		}
+		if (error_status(error_invalid_data))
+		{
+			return "unsupported pixel format or type.";
+		}
+		if (_data == NULL)
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return _data != NULL && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	// GPUが読み終わった範囲を再利用できるようにする
+	void retire()
+	{
+		while (!_segments.empty())
+		{
+			segment& s = _segments.front();
+			if (glClientWaitSync(s.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			{
+				break;
+			}
+			glDeleteSync(s.fence);
+			_tail = s.end;
+			_segments.pop_front();
+		}
+		// 全て読み終わっていれば先頭から使う
+		if (_segments.empty() && !_unfenced)
+		{
+			_head = 0;
+			_tail = 0;
+		}
+	}
+
+	// リングからsizeバイト確保して位置を返す(空きがなければ-1)
+	// 書き込み中の範囲と重ならないように, 先頭が読み終わっていない位置に追いつくことはない
+	int allocate(int size)
+	{
+		if (_data == NULL || size > _size)
+		{
+			return -1;
+		}
+		// 4バイトに揃える
+		size = (size + 3) & ~3;
+		int offset = -1;
+		if (_head >= _tail)
+		{
+			if (_size - _head >= size)
+			{
+				offset = _head;
+			}
+			else if (_tail > size)
+			{
+				// 末尾の余りは使わずに先頭へ戻る
+				offset = 0;
+			}
+		}
+		else if (_tail - _head > size)
+		{
+			offset = _head;
+		}
+		if (offset < 0)
+		{
+			return -1;
+		}
+		_head = offset + size;
+		_unfenced = true;
+		return offset;
+	}
+
+	// GL_PIXEL_UNPACK_BUFFERのバインドと行の揃えの設定
+	void begin()
+	{
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &_alignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		_buffer.bind();
+	}
+	void end()
+	{
+		_buffer.unbind();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, _alignment);
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const texture_streamer& v)
+{
+	os << io::widen("texture_streamer: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.buffer().get() << std::endl <<
+		io::tab << io::widen("size: ") << v.size() << std::endl <<
+		io::tab << io::widen("used: ") << v.used() << std::endl <<
+		io::tab << io::widen("pending: ") << v.pending() << std::endl <<
+		io::tab << io::widen("uploaded: ") << v.uploaded() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_TEXTURE_STREAMER_H__
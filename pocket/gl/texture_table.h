@@ -0,0 +1,527 @@
+﻿#ifndef __POCKET_GL_TEXTURE_TABLE_H__
+#define __POCKET_GL_TEXTURE_TABLE_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "sampler.h"
+#include "texture.h"
+#include "../io.h"
+#include <vector>
+#include <string>
+#include <algorithm> // for std::min, std::max
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class texture_table;
+
+//---------------------------------------------------------------------------------------
+// テクスチャのハンドル表
+// テクスチャを番号(slot)で登録し, 番号からテクスチャを引く表をSSBO(uvec2の配列)に置く
+// マテリアルのSSBOに番号を入れておけば, 1回のマルチドローでマテリアルをIDで切り替えて描画できる
+//
+// GL_ARB_bindless_textureがあればハンドル(64bit)を常駐させて表に入れ, テクスチャユニットは使わない
+// なければテクスチャユニットfirst_unitから番号順にバインドし, 表には番号を入れる(登録数はfirst_unitから後のユニットの数まで)
+// シェーダーはsource_header()を先頭に付け, 両方に対応して書く
+//
+// #ifdef POCKET_BINDLESS_TEXTURE
+// layout(std430, binding = 1) buffer textures { uvec2 handles[]; };
+// #define TEXTURE(ID) sampler2D(handles[ID])
+// #else
+// uniform sampler2D textures[16];
+// #define TEXTURE(ID) textures[ID]
+// #endif
+//
+// gl::texture_table table(256);
+// mat.albedo = table.add(albedo, linear_sampler);
+// ...
+// prog.uniform("textures", units, n); // 非対応の時はtable.units(units)でユニットを設定
+// table.bind(1);
+// indirect.draw(...);
+//
+// ハンドルを作ったテクスチャとサンプラーはパラメータを変更できない(base_levelも不可)
+// 破棄する前にremoveでハンドルの常駐を解除すること
+//---------------------------------------------------------------------------------------
+class texture_table
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 表の番号(-1は無効)
+	typedef int slot_type;
+
+private:
+	struct entry
+	{
+		GLuint texture;
+		GLuint sampler;
+		texture_type_t target;
+		GLuint64 handle;
+		bool resident;
+		bool used;
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	gl::buffer _buffer;
+	std::vector<entry> _entries;
+	std::vector<GLuint> _table; // 番号ごとにuvec2
+	std::vector<slot_type> _free;
+	int _count;
+	int _dirty_first; // 書き込んでいない範囲
+	int _dirty_last;
+	bool _bindless;
+	int _units; // 使えるテクスチャユニットの数(ハンドルを使う時は0)
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	texture_table() :
+		_buffer(),
+		_count(0),
+		_dirty_first(0),
+		_dirty_last(0),
+		_bindless(false),
+		_units(0),
+		_error_bitfield(0)
+	{}
+	// capacity: 登録できる数, use_bindless: falseの時は拡張があってもテクスチャユニットを使う
+	// first_unit: テクスチャユニットを使う時にbindする最初のユニット
+	explicit texture_table(int capacity, bool use_bindless = true, GLuint first_unit = 0) :
+		_buffer(),
+		_count(0),
+		_dirty_first(0),
+		_dirty_last(0),
+		_bindless(false),
+		_units(0),
+		_error_bitfield(0)
+	{
+		initialize(capacity, use_bindless, first_unit);
+	}
+	~texture_table()
+	{
+		finalize();
+	}
+
+private:
+	// ハンドルの常駐を共有しないように複製は禁止
+	texture_table(const texture_table&);
+	texture_table& operator = (const texture_table&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// GL_ARB_bindless_textureが使えるか
+	static bool supported()
+	{
+		return is_extension_support("GL_ARB_bindless_texture");
+	}
+
+	// 初期化
+	// 拡張がなければフラグメントシェーダーのテクスチャユニットのうちfirst_unitから後の数までに減らす
+	bool initialize(int capacity, bool use_bindless = true, GLuint first_unit = 0)
+	{
+		finalize();
+
+		_bindless = use_bindless && supported();
+		if (!_bindless)
+		{
+			GLint units = 16;
+			glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+			_units = static_cast<int>(units);
+			capacity = std::min(capacity, _units - static_cast<int>(first_unit));
+		}
+		if (capacity < 1)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return false;
+		}
+
+		_table.assign(capacity * 2, 0);
+		if (!_buffer.initialize(buffer_type::shader_storage, buffer_usage_type::dynamic_draw,
+			static_cast<int>(sizeof(GLuint)) * capacity * 2, &_table[0]))
+		{
+			_table.clear();
+			_error_bitfield |= error_creating;
+			return false;
+		}
+
+		entry e = { 0, 0, texture_type::unknown, 0, false, false };
+		_entries.assign(capacity, e);
+		_free.reserve(capacity);
+		for (int i = capacity - 1; i >= 0; --i)
+		{
+			_free.push_back(i);
+		}
+		return true;
+	}
+
+	// 終了処理
+	// 全てのハンドルの常駐を解除する
+	void finalize()
+	{
+		make_non_resident();
+		_buffer.finalize();
+		_entries.clear();
+		_table.clear();
+		_free.clear();
+		_count = 0;
+		_dirty_first = 0;
+		_dirty_last = 0;
+		_bindless = false;
+		_units = 0;
+		_error_bitfield = 0;
+	}
+
+	// テクスチャを登録して番号を返す
+	// 空きがなければ-1
+	slot_type add(const texture& t)
+	{
+		return add(t.get(), 0, t.target());
+	}
+	slot_type add(const texture& t, const sampler& s)
+	{
+		return add(t.get(), s.get(), t.target());
+	}
+
+	// 登録の解除
+	void remove(slot_type slot)
+	{
+		if (!contains(slot))
+		{
+			return;
+		}
+		make_non_resident(slot);
+		entry& e = _entries[slot];
+		e.texture = 0;
+		e.sampler = 0;
+		e.target = texture_type::unknown;
+		e.handle = 0;
+		e.used = false;
+		set(slot, 0, 0);
+		_free.push_back(slot);
+		--_count;
+	}
+
+	// ハンドルの常駐
+	// 使わない間は常駐を解除しておくとドライバーが管理する量が減る
+	void make_resident(slot_type slot)
+	{
+		if (!_bindless || !contains(slot))
+		{
+			return;
+		}
+		entry& e = _entries[slot];
+		if (!e.resident)
+		{
+			glMakeTextureHandleResidentARB(e.handle);
+			e.resident = true;
+		}
+	}
+	void make_resident()
+	{
+		for (int i = 0; i < capacity(); ++i)
+		{
+			make_resident(i);
+		}
+	}
+	void make_non_resident(slot_type slot)
+	{
+		if (!_bindless || !contains(slot))
+		{
+			return;
+		}
+		entry& e = _entries[slot];
+		if (e.resident)
+		{
+			glMakeTextureHandleNonResidentARB(e.handle);
+			e.resident = false;
+		}
+	}
+	void make_non_resident()
+	{
+		for (int i = 0; i < capacity(); ++i)
+		{
+			make_non_resident(i);
+		}
+	}
+	// 常駐しているか(テクスチャユニットを使う時は登録していれば常にtrue)
+	bool resident(slot_type slot) const
+	{
+		return contains(slot) && (!_bindless || _entries[slot].resident);
+	}
+
+	// 変更した表をSSBOに書き込む
+	void update()
+	{
+		if (_dirty_first >= _dirty_last)
+		{
+			return;
+		}
+		_buffer.bind();
+		glBufferSubData(buffer_type::shader_storage, static_cast<GLintptr>(sizeof(GLuint) * 2 * _dirty_first),
+			static_cast<GLsizeiptr>(sizeof(GLuint) * 2 * (_dirty_last - _dirty_first)), &_table[_dirty_first * 2]);
+		_buffer.unbind();
+		_dirty_first = 0;
+		_dirty_last = 0;
+	}
+
+	// 表をバインディングポイントに設定
+	// テクスチャユニットを使う時は登録したテクスチャとサンプラーをfirst_unitから番号順にバインドする
+	// ユニットの数を超える番号はバインドせずにerror_invalid_indexを設定する
+	void bind(GLuint point, GLuint first_unit = 0)
+	{
+		update();
+		_buffer.bind_base(point);
+		if (_bindless)
+		{
+			return;
+		}
+		const int n = bindable(first_unit);
+		for (int i = 0; i < capacity(); ++i)
+		{
+			const entry& e = _entries[i];
+			if (!e.used)
+			{
+				continue;
+			}
+			if (i >= n)
+			{
+				_error_bitfield |= error_invalid_index;
+				break;
+			}
+			glActiveTexture(GL_TEXTURE0 + first_unit + i);
+			glBindTexture(e.target, e.texture);
+			glBindSampler(first_unit + i, e.sampler);
+		}
+	}
+	void unbind(GLuint point, GLuint first_unit = 0) const
+	{
+		_buffer.unbind_base(point);
+		if (_bindless)
+		{
+			return;
+		}
+		const int n = bindable(first_unit);
+		for (int i = 0; i < n; ++i)
+		{
+			const entry& e = _entries[i];
+			if (!e.used)
+			{
+				continue;
+			}
+			glActiveTexture(GL_TEXTURE0 + first_unit + i);
+			glBindTexture(e.target, 0);
+			glBindSampler(first_unit + i, 0);
+		}
+	}
+
+	// テクスチャユニットを使う時にシェーダーのsampler配列へ設定する値
+	// outはcapacity()個
+	void units(GLint* out, GLuint first_unit = 0) const
+	{
+		for (int i = 0; i < capacity(); ++i)
+		{
+			out[i] = static_cast<GLint>(first_unit + i);
+		}
+	}
+
+	// シェーダーの先頭(#versionの後)に付ける文字列
+	std::string source_header() const
+	{
+		if (_bindless)
+		{
+			return "#extension GL_ARB_bindless_texture : require\n#define POCKET_BINDLESS_TEXTURE 1\n";
+		}
+		return "";
+	}
+
+	// ハンドルを使っているか
+	bool bindless() const
+	{
+		return _bindless;
+	}
+	// 番号のハンドル(テクスチャユニットを使う時は0)
+	GLuint64 handle(slot_type slot) const
+	{
+		return contains(slot) ? _entries[slot].handle : 0;
+	}
+	// 登録されているか
+	bool contains(slot_type slot) const
+	{
+		return slot >= 0 && slot < capacity() && _entries[slot].used;
+	}
+
+	// 登録できる数
+	int capacity() const
+	{
+		return static_cast<int>(_entries.size());
+	}
+	// 登録されている数
+	int count() const
+	{
+		return _count;
+	}
+
+	// 表のバッファ
+	const gl::buffer& buffer() const
+	{
+		return _buffer;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "capacity is less than 1.";
+		}
+		if (error_status(error_creating))
+		{
+			return _buffer.error();
+		}
+		if (error_status(error_invalid_data))
+		{
+			return "texture is not created.";
+		}
+		if (error_status(error_invalid_index))
+		{
+			return "slot exceeds texture units.";
+		}
+		if (capacity() == 0)
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return capacity() > 0 && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	slot_type add(GLuint tex, GLuint samp, texture_type_t target)
+	{
+		if (tex == 0)
+		{
+			_error_bitfield |= error_invalid_data;
+			return -1;
+		}
+		if (_free.empty())
+		{
+			return -1;
+		}
+		const slot_type slot = _free.back();
+		_free.pop_back();
+
+		entry& e = _entries[slot];
+		e.texture = tex;
+		e.sampler = samp;
+		e.target = target;
+		e.used = true;
+		e.resident = false;
+		if (_bindless)
+		{
+			e.handle = samp != 0 ? glGetTextureSamplerHandleARB(tex, samp) : glGetTextureHandleARB(tex);
+			glMakeTextureHandleResidentARB(e.handle);
+			e.resident = true;
+			set(slot, static_cast<GLuint>(e.handle & 0xFFFFFFFFU), static_cast<GLuint>(e.handle >> 32));
+		}
+		else
+		{
+			e.handle = 0;
+			set(slot, static_cast<GLuint>(slot), 0);
+		}
+		++_count;
+		return slot;
+	}
+
+	// first_unitからバインドできる番号の数
+	int bindable(GLuint first_unit) const
+	{
+		return std::max(std::min(capacity(), _units - static_cast<int>(first_unit)), 0);
+	}
+
+	void set(slot_type slot, GLuint x, GLuint y)
+	{
+		_table[slot * 2 + 0] = x;
+		_table[slot * 2 + 1] = y;
+		if (_dirty_first >= _dirty_last)
+		{
+			_dirty_first = slot;
+			_dirty_last = slot + 1;
+		}
+		else
+		{
+			_dirty_first = std::min(_dirty_first, static_cast<int>(slot));
+			_dirty_last = std::max(_dirty_last, static_cast<int>(slot) + 1);
+		}
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const texture_table& v)
+{
+	os << io::widen("texture_table: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.buffer().get() << std::endl <<
+		io::tab << io::widen("bindless: ") << v.bindless() << std::endl <<
+		io::tab << io::widen("capacity: ") << v.capacity() << std::endl <<
+		io::tab << io::widen("count: ") << v.count() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_TEXTURE_TABLE_H__
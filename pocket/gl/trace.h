@@ -0,0 +1,1068 @@
+﻿#ifndef __POCKET_GL_TRACE_H__
+#define __POCKET_GL_TRACE_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+
+//---------------------------------------------------------------------------------------
+// GL関数の呼び出し回数と時間の計測
+// POCKET_USE_GL_TRACEを定義するとpocket/glが使用するGL関数をマクロで置き換える
+// gl.hから読み込まれるため, GLのヘッダはpocket/glより先に読み込んでおくこと
+//
+// pocket::gl::trace::enable_timing(true); // 時間も計測する
+// pocket::gl::trace::start_recording(); // Chrome traceの区間を記録する
+// do
+// {
+//     POCKET_GL_TRACE_ZONE("shadow pass");
+//     ...
+//     pocket::gl::trace::frame(); // フレームの区切り
+// } while (...);
+// pocket::gl::trace::save_chrome_trace("trace.json"); // chrome://tracing で開く
+// pocket::gl::trace::save_csv("trace.csv");
+//
+// 計測の状態はスレッド間で共有されず, 一つのスレッド(描画スレッド)から行なわれることを前提とする
+// 他のスレッドでGL関数を呼ぶ場合は, そのスレッドでignore_this_threadを呼んで計測から外すこと
+// (gl::loaderの読み込みスレッドは自動で外される)
+//---------------------------------------------------------------------------------------
+
+#ifdef POCKET_USE_GL_TRACE
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm> // for std::min
+#include <iomanip>
+#ifdef POCKET_USE_CXX11
+#include <chrono>
+#endif // POCKET_USE_CXX11
+
+// スレッドごとの変数(VC++12はthread_localが使用できない)
+#ifndef __POCKET_GL_TRACE_THREAD_LOCAL
+#	if !defined(POCKET_USE_CXX11)
+#		define __POCKET_GL_TRACE_THREAD_LOCAL
+#	elif POCKET_COMPILER_IF(VC) && !POCKET_VCXX_HAS_VERSION(14)
+#		define __POCKET_GL_TRACE_THREAD_LOCAL __declspec(thread)
+#	else
+#		define __POCKET_GL_TRACE_THREAD_LOCAL thread_local
+#	endif
+#endif // __POCKET_GL_TRACE_THREAD_LOCAL
+
+//---------------------------------------------------------------------
+// 置き換えるGL関数
+// CORE: GL1.1の関数(glewでも直接リンクされる)
+// EXT: glewでは関数ポインタを経由する関数
+//---------------------------------------------------------------------
+#define POCKET_GL_TRACE_CORE_FUNCTIONS(X) \
+	X(BindTexture) \
+	X(Clear) \
+	X(ClearColor) \
+	X(DeleteTextures) \
+	X(DepthRange) \
+	X(DrawArrays) \
+	X(DrawBuffer) \
+	X(DrawElements) \
+	X(Finish) \
+	X(Flush) \
+	X(GenTextures) \
+	X(GetError) \
+	X(GetFloatv) \
+	X(GetIntegerv) \
+	X(GetString) \
+	X(IsTexture) \
+	X(PixelStorei) \
+	X(ReadBuffer) \
+	X(ReadPixels) \
+	X(TexParameteri) \
+	X(TexSubImage2D) \
+	X(Viewport)
+
+#define POCKET_GL_TRACE_EXT_FUNCTIONS(X) \
+	X(ActiveTexture) \
+	X(AttachShader) \
+	X(BeginQuery) \
+	X(BindBuffer) \
+	X(BindBufferBase) \
+	X(BindBufferRange) \
+	X(BindFramebuffer) \
+	X(BindRenderbuffer) \
+	X(BindSampler) \
+	X(BindVertexArray) \
+	X(BindVertexBuffer) \
+	X(BlitFramebuffer) \
+	X(BufferData) \
+	X(BufferStorage) \
+	X(BufferSubData) \
+	X(CheckFramebufferStatus) \
+	X(ClientWaitSync) \
+	X(CompileShader) \
+	X(CopyBufferSubData) \
+	X(CreateProgram) \
+	X(CreateShader) \
+	X(DeleteBuffers) \
+	X(DeleteFramebuffers) \
+	X(DeleteProgram) \
+	X(DeleteQueries) \
+	X(DeleteRenderbuffers) \
+	X(DeleteSamplers) \
+	X(DeleteShader) \
+	X(DeleteSync) \
+	X(DeleteVertexArrays) \
+	X(DetachShader) \
+	X(DispatchComputeIndirect) \
+	X(DrawArraysIndirect) \
+	X(DrawArraysInstanced) \
+	X(DrawArraysInstancedBaseInstance) \
+	X(DrawBuffers) \
+	X(DrawElementsBaseVertex) \
+	X(DrawElementsIndirect) \
+	X(DrawElementsInstanced) \
+	X(DrawElementsInstancedBaseVertexBaseInstance) \
+	X(EnableVertexAttribArray) \
+	X(EndQuery) \
+	X(FenceSync) \
+	X(FramebufferRenderbuffer) \
+	X(FramebufferTexture) \
+	X(FramebufferTexture2D) \
+	X(FramebufferTextureLayer) \
+	X(GenBuffers) \
+	X(GenFramebuffers) \
+	X(GenQueries) \
+	X(GenRenderbuffers) \
+	X(GenSamplers) \
+	X(GenVertexArrays) \
+	X(GenerateMipmap) \
+	X(GetActiveSubroutineUniformiv) \
+	X(GetActiveUniformBlockName) \
+	X(GetActiveUniformBlockiv) \
+	X(GetActiveUniformName) \
+	X(GetActiveUniformsiv) \
+	X(GetBufferParameteriv) \
+	X(GetObjectLabel) \
+	X(GetProgramBinary) \
+	X(GetProgramInfoLog) \
+	X(GetProgramResourceIndex) \
+	X(GetProgramResourceiv) \
+	X(GetProgramiv) \
+	X(GetQueryObjectui64v) \
+	X(GetQueryObjectuiv) \
+	X(GetSamplerParameteriv) \
+	X(GetShaderInfoLog) \
+	X(GetShaderSource) \
+	X(GetShaderiv) \
+	X(GetStringi) \
+	X(GetSubroutineIndex) \
+	X(GetSynciv) \
+	X(GetTextureHandleARB) \
+	X(GetTextureSamplerHandleARB) \
+	X(GetUniformBlockIndex) \
+	X(GetUniformIndices) \
+	X(GetUniformLocation) \
+	X(GetVertexAttribiv) \
+	X(InvalidateFramebuffer) \
+	X(IsBuffer) \
+	X(IsFramebuffer) \
+	X(IsProgram) \
+	X(IsRenderbuffer) \
+	X(IsSampler) \
+	X(IsShader) \
+	X(IsSync) \
+	X(IsVertexArray) \
+	X(LinkProgram) \
+	X(MakeTextureHandleNonResidentARB) \
+	X(MakeTextureHandleResidentARB) \
+	X(MapBuffer) \
+	X(MapBufferRange) \
+	X(MemoryBarrier) \
+	X(ObjectLabel) \
+	X(ProgramBinary) \
+	X(ProgramParameteri) \
+	X(QueryCounter) \
+	X(RenderbufferStorageMultisample) \
+	X(SamplerParameteri) \
+	X(ShaderSource) \
+	X(TexStorage2D) \
+	X(TexStorage3D) \
+	X(TexSubImage3D) \
+	X(Uniform1f) \
+	X(Uniform1fv) \
+	X(Uniform1i) \
+	X(Uniform1iv) \
+	X(Uniform1ui) \
+	X(Uniform1uiv) \
+	X(Uniform2f) \
+	X(Uniform2fv) \
+	X(Uniform2i) \
+	X(Uniform2iv) \
+	X(Uniform2ui) \
+	X(Uniform2uiv) \
+	X(Uniform3f) \
+	X(Uniform3fv) \
+	X(Uniform3i) \
+	X(Uniform3iv) \
+	X(Uniform3ui) \
+	X(Uniform3uiv) \
+	X(Uniform4f) \
+	X(Uniform4fv) \
+	X(Uniform4i) \
+	X(Uniform4iv) \
+	X(Uniform4ui) \
+	X(Uniform4uiv) \
+	X(UniformBlockBinding) \
+	X(UniformMatrix3fv) \
+	X(UniformMatrix4fv) \
+	X(UniformSubroutinesuiv) \
+	X(UnmapBuffer) \
+	X(UseProgram) \
+	X(ValidateProgram) \
+	X(VertexAttribBinding) \
+	X(VertexAttribDivisor) \
+	X(VertexAttribFormat) \
+	X(VertexAttribPointer) \
+	X(VertexBindingDivisor) \
+	X(WaitSync)
+
+namespace pocket
+{
+namespace gl
+{
+namespace trace
+{
+
+// 関数の識別子
+enum function_t
+{
+#define __POCKET_GL_TRACE_ENUM(NAME) id_##NAME,
+	POCKET_GL_TRACE_CORE_FUNCTIONS(__POCKET_GL_TRACE_ENUM)
+	POCKET_GL_TRACE_EXT_FUNCTIONS(__POCKET_GL_TRACE_ENUM)
+#undef __POCKET_GL_TRACE_ENUM
+
+	function_count
+};
+
+// 関数名
+inline
+const char* name(function_t f)
+{
+#define __POCKET_GL_TRACE_NAME(NAME) "gl" #NAME,
+	static const char* const names[] = {
+		POCKET_GL_TRACE_CORE_FUNCTIONS(__POCKET_GL_TRACE_NAME)
+		POCKET_GL_TRACE_EXT_FUNCTIONS(__POCKET_GL_TRACE_NAME)
+	};
+#undef __POCKET_GL_TRACE_NAME
+	return f >= 0 && f < function_count ? names[f] : "";
+}
+
+// 経過時間(ナノ秒)
+inline
+unsigned long long now()
+{
+#ifdef POCKET_USE_CXX11
+	return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+	return 0;
+#endif // POCKET_USE_CXX11
+}
+
+//---------------------------------------------------------------------
+// 計測から外すスレッドか
+//---------------------------------------------------------------------
+inline
+bool& ignored()
+{
+	static __POCKET_GL_TRACE_THREAD_LOCAL bool ignore = false;
+	return ignore;
+}
+// 呼び出したスレッドのGL関数を計測しない
+// 計測の状態は排他されないため, 描画スレッド以外でGL関数を呼ぶスレッドで呼ぶこと
+inline
+void ignore_this_thread(bool b = true)
+{
+	ignored() = b;
+}
+
+//---------------------------------------------------------------------
+// 呼び出し回数と時間
+//---------------------------------------------------------------------
+struct counter
+{
+	unsigned long long calls;
+	unsigned long long nanoseconds;
+};
+
+//---------------------------------------------------------------------
+// 1フレームの合計
+//---------------------------------------------------------------------
+struct frame_total
+{
+	unsigned long long begin;
+	unsigned long long calls;
+	unsigned long long nanoseconds;
+};
+
+//---------------------------------------------------------------------
+// Chrome traceに出力する区間
+//---------------------------------------------------------------------
+struct event
+{
+	const char* name;
+	unsigned long long begin;
+	unsigned long long duration;
+	bool instant; // フレームの区切り
+};
+
+//---------------------------------------------------------------------
+// 計測状態
+//---------------------------------------------------------------------
+struct state
+{
+	counter totals[function_count];
+	counter frame_counters[function_count];
+	counter frame_sum;
+	unsigned long long frame_begin;
+	std::vector<frame_total> frames;
+	std::vector<event> events;
+	size_t frame_history; // 保持するフレーム数
+	size_t event_limit; // 記録する区間の上限
+	bool timing;
+	bool recording;
+
+	state() :
+		frame_begin(now()),
+		frame_history(240),
+		event_limit(0),
+		timing(false),
+		recording(false)
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		for (int i = 0; i < function_count; ++i)
+		{
+			totals[i].calls = 0;
+			totals[i].nanoseconds = 0;
+			frame_counters[i].calls = 0;
+			frame_counters[i].nanoseconds = 0;
+		}
+		frame_sum.calls = 0;
+		frame_sum.nanoseconds = 0;
+		frames.clear();
+		events.clear();
+	}
+
+	void record(const char* n, unsigned long long begin, unsigned long long duration, bool instant)
+	{
+		if (events.size() >= event_limit)
+		{
+			recording = false;
+			return;
+		}
+		event e = { n, begin, duration, instant };
+		events.push_back(e);
+	}
+
+	static state& get()
+	{
+		static state s;
+		return s;
+	}
+};
+
+//---------------------------------------------------------------------
+// GL関数一回分の計測
+// 置き換えたマクロから一時オブジェクトとして作られ, 呼び出しの完了後に破棄される
+//---------------------------------------------------------------------
+class scope
+{
+private:
+	function_t _function;
+	unsigned long long _begin;
+	bool _measuring;
+
+public:
+	explicit scope(function_t f) :
+		_function(f),
+		_begin(0),
+		_measuring(false)
+	{
+		if (ignored())
+		{
+			return;
+		}
+		state& s = state::get();
+		++s.totals[f].calls;
+		++s.frame_counters[f].calls;
+		++s.frame_sum.calls;
+		if (s.timing || s.recording)
+		{
+			_measuring = true;
+			_begin = now();
+		}
+	}
+	~scope()
+	{
+		if (!_measuring)
+		{
+			return;
+		}
+		const unsigned long long duration = now() - _begin;
+		state& s = state::get();
+		s.totals[_function].nanoseconds += duration;
+		s.frame_counters[_function].nanoseconds += duration;
+		s.frame_sum.nanoseconds += duration;
+		if (s.recording)
+		{
+			s.record(name(_function), _begin, duration, false);
+		}
+	}
+
+private:
+	scope(const scope&);
+	scope& operator = (const scope&);
+};
+
+//---------------------------------------------------------------------
+// 任意の区間(POCKET_GL_TRACE_ZONE)
+// nameは記録を出力するまで有効な文字列であること
+//---------------------------------------------------------------------
+class zone
+{
+private:
+	const char* _name;
+	unsigned long long _begin;
+
+public:
+	explicit zone(const char* n) :
+		_name(n),
+		_begin(!ignored() && state::get().recording ? now() : 0)
+	{}
+	~zone()
+	{
+		state& s = state::get();
+		if (s.recording && _begin != 0)
+		{
+			s.record(_name, _begin, now() - _begin, false);
+		}
+	}
+
+private:
+	zone(const zone&);
+	zone& operator = (const zone&);
+};
+
+//---------------------------------------------------------------------
+// 設定
+//---------------------------------------------------------------------
+
+// 呼び出しごとに時間も計測する
+inline
+void enable_timing(bool b)
+{
+	state::get().timing = b;
+}
+inline
+bool timing()
+{
+	return state::get().timing;
+}
+
+// Chrome trace用に区間の記録を開始する
+// limitを超えると記録を止める
+inline
+void start_recording(size_t limit = 1 << 20)
+{
+	state& s = state::get();
+	s.events.clear();
+	s.events.reserve((std::min)(limit, static_cast<size_t>(1 << 16)));
+	s.event_limit = limit;
+	s.recording = true;
+}
+inline
+void stop_recording()
+{
+	state::get().recording = false;
+}
+inline
+bool recording()
+{
+	return state::get().recording;
+}
+
+// 保持するフレーム数
+inline
+void frame_history(size_t n)
+{
+	state::get().frame_history = n;
+}
+
+// すべての計測結果を破棄
+inline
+void reset()
+{
+	state& s = state::get();
+	s.clear();
+	s.frame_begin = now();
+}
+
+//---------------------------------------------------------------------
+// フレームの区切り
+//---------------------------------------------------------------------
+inline
+void frame()
+{
+	state& s = state::get();
+	const frame_total f = { s.frame_begin, s.frame_sum.calls, s.frame_sum.nanoseconds };
+	if (s.frame_history > 0)
+	{
+		if (s.frames.size() >= s.frame_history)
+		{
+			s.frames.erase(s.frames.begin());
+		}
+		s.frames.push_back(f);
+	}
+	for (int i = 0; i < function_count; ++i)
+	{
+		s.frame_counters[i].calls = 0;
+		s.frame_counters[i].nanoseconds = 0;
+	}
+	s.frame_sum.calls = 0;
+	s.frame_sum.nanoseconds = 0;
+	s.frame_begin = now();
+	if (s.recording)
+	{
+		s.record("frame", s.frame_begin, 0, true);
+	}
+}
+
+//---------------------------------------------------------------------
+// 結果の取得
+//---------------------------------------------------------------------
+
+// 計測開始からの合計
+inline
+const counter& total(function_t f)
+{
+	return state::get().totals[f];
+}
+inline
+unsigned long long total_calls()
+{
+	const state& s = state::get();
+	unsigned long long n = 0;
+	for (int i = 0; i < function_count; ++i)
+	{
+		n += s.totals[i].calls;
+	}
+	return n;
+}
+
+// 現在のフレーム
+inline
+const counter& current_frame(function_t f)
+{
+	return state::get().frame_counters[f];
+}
+inline
+const counter& current_frame()
+{
+	return state::get().frame_sum;
+}
+
+// 終了したフレームの合計(古い順)
+inline
+const std::vector<frame_total>& frames()
+{
+	return state::get().frames;
+}
+
+// 記録した区間
+inline
+const std::vector<event>& events()
+{
+	return state::get().events;
+}
+
+//---------------------------------------------------------------------
+// 出力
+//---------------------------------------------------------------------
+
+// 関数ごとの合計(呼ばれていない関数は出力しない)
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& write_csv(std::basic_ostream<CharT, CharTraits>& os)
+{
+	const state& s = state::get();
+	os << "function,calls,total_ns,average_ns" << std::endl;
+	for (int i = 0; i < function_count; ++i)
+	{
+		const counter& c = s.totals[i];
+		if (c.calls == 0)
+		{
+			continue;
+		}
+		os << name(static_cast<function_t>(i)) << ',' <<
+			c.calls << ',' <<
+			c.nanoseconds << ',' <<
+			(c.nanoseconds / c.calls) << std::endl;
+	}
+	return os;
+}
+
+// フレームごとの合計
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& write_frames_csv(std::basic_ostream<CharT, CharTraits>& os)
+{
+	const state& s = state::get();
+	os << "frame,calls,gl_ns" << std::endl;
+	for (size_t i = 0; i < s.frames.size(); ++i)
+	{
+		os << i << ',' <<
+			s.frames[i].calls << ',' <<
+			s.frames[i].nanoseconds << std::endl;
+	}
+	return os;
+}
+
+// Chrome trace(Trace Event Format)
+// 時間はマイクロ秒で記録の先頭を0とする
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& write_chrome_trace(std::basic_ostream<CharT, CharTraits>& os)
+{
+	const state& s = state::get();
+	// 区間は終了時に記録されるため先頭が最も古いとは限らない
+	unsigned long long origin = s.events.empty() ? 0 : s.events.front().begin;
+	for (size_t i = 1; i < s.events.size(); ++i)
+	{
+		origin = (std::min)(origin, s.events[i].begin);
+	}
+
+	os << "{\"traceEvents\":[" << std::endl;
+	for (size_t i = 0; i < s.events.size(); ++i)
+	{
+		const event& e = s.events[i];
+		os << "{\"name\":\"";
+		for (const char* c = e.name; *c != '\0'; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				os << '\\';
+			}
+			os << *c;
+		}
+		os << "\",\"ph\":\"" << (e.instant ? 'i' : 'X') << "\",\"pid\":0,\"tid\":0,\"ts\":" <<
+			std::fixed << std::setprecision(3) << (static_cast<double>(e.begin - origin) * 1.0e-3);
+		if (e.instant)
+		{
+			os << ",\"s\":\"g\"";
+		}
+		else
+		{
+			os << ",\"dur\":" << (static_cast<double>(e.duration) * 1.0e-3);
+		}
+		os << (i + 1 < s.events.size() ? "}," : "}") << std::endl;
+	}
+	os << "]}" << std::endl;
+	return os;
+}
+
+inline
+bool save_csv(const char* path)
+{
+	std::ofstream fs(path);
+	if (!fs)
+	{
+		return false;
+	}
+	write_csv(fs);
+	return true;
+}
+inline
+bool save_frames_csv(const char* path)
+{
+	std::ofstream fs(path);
+	if (!fs)
+	{
+		return false;
+	}
+	write_frames_csv(fs);
+	return true;
+}
+inline
+bool save_chrome_trace(const char* path)
+{
+	std::ofstream fs(path);
+	if (!fs)
+	{
+		return false;
+	}
+	write_chrome_trace(fs);
+	return true;
+}
+
+} // namespace trace
+} // namespace gl
+} // namespace pocket
+
+//---------------------------------------------------------------------
+// GL関数の置き換え
+// (scope, 関数)(引数) の形に展開され, scopeは呼び出しの完了後に破棄される
+//---------------------------------------------------------------------
+#define __POCKET_GL_TRACE_CORE(NAME) (::pocket::gl::trace::scope(::pocket::gl::trace::id_##NAME), ::gl##NAME)
+#ifdef POCKET_INTERNAL_USE_GLEW
+#	define __POCKET_GL_TRACE_EXT(NAME) (::pocket::gl::trace::scope(::pocket::gl::trace::id_##NAME), GLEW_GET_FUN(__glew##NAME))
+#else
+#	define __POCKET_GL_TRACE_EXT(NAME) __POCKET_GL_TRACE_CORE(NAME)
+#endif // POCKET_INTERNAL_USE_GLEW
+
+#undef glBindTexture
+#define glBindTexture __POCKET_GL_TRACE_CORE(BindTexture)
+#undef glClear
+#define glClear __POCKET_GL_TRACE_CORE(Clear)
+#undef glClearColor
+#define glClearColor __POCKET_GL_TRACE_CORE(ClearColor)
+#undef glDeleteTextures
+#define glDeleteTextures __POCKET_GL_TRACE_CORE(DeleteTextures)
+#undef glDepthRange
+#define glDepthRange __POCKET_GL_TRACE_CORE(DepthRange)
+#undef glDrawArrays
+#define glDrawArrays __POCKET_GL_TRACE_CORE(DrawArrays)
+#undef glDrawBuffer
+#define glDrawBuffer __POCKET_GL_TRACE_CORE(DrawBuffer)
+#undef glDrawElements
+#define glDrawElements __POCKET_GL_TRACE_CORE(DrawElements)
+#undef glFinish
+#define glFinish __POCKET_GL_TRACE_CORE(Finish)
+#undef glFlush
+#define glFlush __POCKET_GL_TRACE_CORE(Flush)
+#undef glGenTextures
+#define glGenTextures __POCKET_GL_TRACE_CORE(GenTextures)
+#undef glGetError
+#define glGetError __POCKET_GL_TRACE_CORE(GetError)
+#undef glGetFloatv
+#define glGetFloatv __POCKET_GL_TRACE_CORE(GetFloatv)
+#undef glGetIntegerv
+#define glGetIntegerv __POCKET_GL_TRACE_CORE(GetIntegerv)
+#undef glGetString
+#define glGetString __POCKET_GL_TRACE_CORE(GetString)
+#undef glIsTexture
+#define glIsTexture __POCKET_GL_TRACE_CORE(IsTexture)
+#undef glPixelStorei
+#define glPixelStorei __POCKET_GL_TRACE_CORE(PixelStorei)
+#undef glReadBuffer
+#define glReadBuffer __POCKET_GL_TRACE_CORE(ReadBuffer)
+#undef glReadPixels
+#define glReadPixels __POCKET_GL_TRACE_CORE(ReadPixels)
+#undef glTexParameteri
+#define glTexParameteri __POCKET_GL_TRACE_CORE(TexParameteri)
+#undef glTexSubImage2D
+#define glTexSubImage2D __POCKET_GL_TRACE_CORE(TexSubImage2D)
+#undef glViewport
+#define glViewport __POCKET_GL_TRACE_CORE(Viewport)
+
+#undef glActiveTexture
+#define glActiveTexture __POCKET_GL_TRACE_EXT(ActiveTexture)
+#undef glAttachShader
+#define glAttachShader __POCKET_GL_TRACE_EXT(AttachShader)
+#undef glBeginQuery
+#define glBeginQuery __POCKET_GL_TRACE_EXT(BeginQuery)
+#undef glBindBuffer
+#define glBindBuffer __POCKET_GL_TRACE_EXT(BindBuffer)
+#undef glBindBufferBase
+#define glBindBufferBase __POCKET_GL_TRACE_EXT(BindBufferBase)
+#undef glBindBufferRange
+#define glBindBufferRange __POCKET_GL_TRACE_EXT(BindBufferRange)
+#undef glBindFramebuffer
+#define glBindFramebuffer __POCKET_GL_TRACE_EXT(BindFramebuffer)
+#undef glBindRenderbuffer
+#define glBindRenderbuffer __POCKET_GL_TRACE_EXT(BindRenderbuffer)
+#undef glBindSampler
+#define glBindSampler __POCKET_GL_TRACE_EXT(BindSampler)
+#undef glBindVertexArray
+#define glBindVertexArray __POCKET_GL_TRACE_EXT(BindVertexArray)
+#undef glBindVertexBuffer
+#define glBindVertexBuffer __POCKET_GL_TRACE_EXT(BindVertexBuffer)
+#undef glBlitFramebuffer
+#define glBlitFramebuffer __POCKET_GL_TRACE_EXT(BlitFramebuffer)
+#undef glBufferData
+#define glBufferData __POCKET_GL_TRACE_EXT(BufferData)
+#undef glBufferStorage
+#define glBufferStorage __POCKET_GL_TRACE_EXT(BufferStorage)
+#undef glBufferSubData
+#define glBufferSubData __POCKET_GL_TRACE_EXT(BufferSubData)
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus __POCKET_GL_TRACE_EXT(CheckFramebufferStatus)
+#undef glClientWaitSync
+#define glClientWaitSync __POCKET_GL_TRACE_EXT(ClientWaitSync)
+#undef glCompileShader
+#define glCompileShader __POCKET_GL_TRACE_EXT(CompileShader)
+#undef glCopyBufferSubData
+#define glCopyBufferSubData __POCKET_GL_TRACE_EXT(CopyBufferSubData)
+#undef glCreateProgram
+#define glCreateProgram __POCKET_GL_TRACE_EXT(CreateProgram)
+#undef glCreateShader
+#define glCreateShader __POCKET_GL_TRACE_EXT(CreateShader)
+#undef glDeleteBuffers
+#define glDeleteBuffers __POCKET_GL_TRACE_EXT(DeleteBuffers)
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers __POCKET_GL_TRACE_EXT(DeleteFramebuffers)
+#undef glDeleteProgram
+#define glDeleteProgram __POCKET_GL_TRACE_EXT(DeleteProgram)
+#undef glDeleteQueries
+#define glDeleteQueries __POCKET_GL_TRACE_EXT(DeleteQueries)
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers __POCKET_GL_TRACE_EXT(DeleteRenderbuffers)
+#undef glDeleteSamplers
+#define glDeleteSamplers __POCKET_GL_TRACE_EXT(DeleteSamplers)
+#undef glDeleteShader
+#define glDeleteShader __POCKET_GL_TRACE_EXT(DeleteShader)
+#undef glDeleteSync
+#define glDeleteSync __POCKET_GL_TRACE_EXT(DeleteSync)
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays __POCKET_GL_TRACE_EXT(DeleteVertexArrays)
+#undef glDetachShader
+#define glDetachShader __POCKET_GL_TRACE_EXT(DetachShader)
+#undef glDispatchComputeIndirect
+#define glDispatchComputeIndirect __POCKET_GL_TRACE_EXT(DispatchComputeIndirect)
+#undef glDrawArraysIndirect
+#define glDrawArraysIndirect __POCKET_GL_TRACE_EXT(DrawArraysIndirect)
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced __POCKET_GL_TRACE_EXT(DrawArraysInstanced)
+#undef glDrawArraysInstancedBaseInstance
+#define glDrawArraysInstancedBaseInstance __POCKET_GL_TRACE_EXT(DrawArraysInstancedBaseInstance)
+#undef glDrawBuffers
+#define glDrawBuffers __POCKET_GL_TRACE_EXT(DrawBuffers)
+#undef glDrawElementsBaseVertex
+#define glDrawElementsBaseVertex __POCKET_GL_TRACE_EXT(DrawElementsBaseVertex)
+#undef glDrawElementsIndirect
+#define glDrawElementsIndirect __POCKET_GL_TRACE_EXT(DrawElementsIndirect)
+#undef glDrawElementsInstanced
+#define glDrawElementsInstanced __POCKET_GL_TRACE_EXT(DrawElementsInstanced)
+#undef glDrawElementsInstancedBaseVertexBaseInstance
+#define glDrawElementsInstancedBaseVertexBaseInstance __POCKET_GL_TRACE_EXT(DrawElementsInstancedBaseVertexBaseInstance)
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray __POCKET_GL_TRACE_EXT(EnableVertexAttribArray)
+#undef glEndQuery
+#define glEndQuery __POCKET_GL_TRACE_EXT(EndQuery)
+#undef glFenceSync
+#define glFenceSync __POCKET_GL_TRACE_EXT(FenceSync)
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer __POCKET_GL_TRACE_EXT(FramebufferRenderbuffer)
+#undef glFramebufferTexture
+#define glFramebufferTexture __POCKET_GL_TRACE_EXT(FramebufferTexture)
+#undef glFramebufferTexture2D
+#define glFramebufferTexture2D __POCKET_GL_TRACE_EXT(FramebufferTexture2D)
+#undef glFramebufferTextureLayer
+#define glFramebufferTextureLayer __POCKET_GL_TRACE_EXT(FramebufferTextureLayer)
+#undef glGenBuffers
+#define glGenBuffers __POCKET_GL_TRACE_EXT(GenBuffers)
+#undef glGenFramebuffers
+#define glGenFramebuffers __POCKET_GL_TRACE_EXT(GenFramebuffers)
+#undef glGenQueries
+#define glGenQueries __POCKET_GL_TRACE_EXT(GenQueries)
+#undef glGenRenderbuffers
+#define glGenRenderbuffers __POCKET_GL_TRACE_EXT(GenRenderbuffers)
+#undef glGenSamplers
+#define glGenSamplers __POCKET_GL_TRACE_EXT(GenSamplers)
+#undef glGenVertexArrays
+#define glGenVertexArrays __POCKET_GL_TRACE_EXT(GenVertexArrays)
+#undef glGenerateMipmap
+#define glGenerateMipmap __POCKET_GL_TRACE_EXT(GenerateMipmap)
+#undef glGetActiveSubroutineUniformiv
+#define glGetActiveSubroutineUniformiv __POCKET_GL_TRACE_EXT(GetActiveSubroutineUniformiv)
+#undef glGetActiveUniformBlockName
+#define glGetActiveUniformBlockName __POCKET_GL_TRACE_EXT(GetActiveUniformBlockName)
+#undef glGetActiveUniformBlockiv
+#define glGetActiveUniformBlockiv __POCKET_GL_TRACE_EXT(GetActiveUniformBlockiv)
+#undef glGetActiveUniformName
+#define glGetActiveUniformName __POCKET_GL_TRACE_EXT(GetActiveUniformName)
+#undef glGetActiveUniformsiv
+#define glGetActiveUniformsiv __POCKET_GL_TRACE_EXT(GetActiveUniformsiv)
+#undef glGetBufferParameteriv
+#define glGetBufferParameteriv __POCKET_GL_TRACE_EXT(GetBufferParameteriv)
+#undef glGetObjectLabel
+#define glGetObjectLabel __POCKET_GL_TRACE_EXT(GetObjectLabel)
+#undef glGetProgramBinary
+#define glGetProgramBinary __POCKET_GL_TRACE_EXT(GetProgramBinary)
+#undef glGetProgramInfoLog
+#define glGetProgramInfoLog __POCKET_GL_TRACE_EXT(GetProgramInfoLog)
+#undef glGetProgramResourceIndex
+#define glGetProgramResourceIndex __POCKET_GL_TRACE_EXT(GetProgramResourceIndex)
+#undef glGetProgramResourceiv
+#define glGetProgramResourceiv __POCKET_GL_TRACE_EXT(GetProgramResourceiv)
+#undef glGetProgramiv
+#define glGetProgramiv __POCKET_GL_TRACE_EXT(GetProgramiv)
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v __POCKET_GL_TRACE_EXT(GetQueryObjectui64v)
+#undef glGetQueryObjectuiv
+#define glGetQueryObjectuiv __POCKET_GL_TRACE_EXT(GetQueryObjectuiv)
+#undef glGetSamplerParameteriv
+#define glGetSamplerParameteriv __POCKET_GL_TRACE_EXT(GetSamplerParameteriv)
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog __POCKET_GL_TRACE_EXT(GetShaderInfoLog)
+#undef glGetShaderSource
+#define glGetShaderSource __POCKET_GL_TRACE_EXT(GetShaderSource)
+#undef glGetShaderiv
+#define glGetShaderiv __POCKET_GL_TRACE_EXT(GetShaderiv)
+#undef glGetStringi
+#define glGetStringi __POCKET_GL_TRACE_EXT(GetStringi)
+#undef glGetSubroutineIndex
+#define glGetSubroutineIndex __POCKET_GL_TRACE_EXT(GetSubroutineIndex)
+#undef glGetSynciv
+#define glGetSynciv __POCKET_GL_TRACE_EXT(GetSynciv)
+#undef glGetTextureHandleARB
+#define glGetTextureHandleARB __POCKET_GL_TRACE_EXT(GetTextureHandleARB)
+#undef glGetTextureSamplerHandleARB
+#define glGetTextureSamplerHandleARB __POCKET_GL_TRACE_EXT(GetTextureSamplerHandleARB)
+#undef glGetUniformBlockIndex
+#define glGetUniformBlockIndex __POCKET_GL_TRACE_EXT(GetUniformBlockIndex)
+#undef glGetUniformIndices
+#define glGetUniformIndices __POCKET_GL_TRACE_EXT(GetUniformIndices)
+#undef glGetUniformLocation
+#define glGetUniformLocation __POCKET_GL_TRACE_EXT(GetUniformLocation)
+#undef glGetVertexAttribiv
+#define glGetVertexAttribiv __POCKET_GL_TRACE_EXT(GetVertexAttribiv)
+#undef glInvalidateFramebuffer
+#define glInvalidateFramebuffer __POCKET_GL_TRACE_EXT(InvalidateFramebuffer)
+#undef glIsBuffer
+#define glIsBuffer __POCKET_GL_TRACE_EXT(IsBuffer)
+#undef glIsFramebuffer
+#define glIsFramebuffer __POCKET_GL_TRACE_EXT(IsFramebuffer)
+#undef glIsProgram
+#define glIsProgram __POCKET_GL_TRACE_EXT(IsProgram)
+#undef glIsRenderbuffer
+#define glIsRenderbuffer __POCKET_GL_TRACE_EXT(IsRenderbuffer)
+#undef glIsSampler
+#define glIsSampler __POCKET_GL_TRACE_EXT(IsSampler)
+#undef glIsShader
+#define glIsShader __POCKET_GL_TRACE_EXT(IsShader)
+#undef glIsSync
+#define glIsSync __POCKET_GL_TRACE_EXT(IsSync)
+#undef glIsVertexArray
+#define glIsVertexArray __POCKET_GL_TRACE_EXT(IsVertexArray)
+#undef glLinkProgram
+#define glLinkProgram __POCKET_GL_TRACE_EXT(LinkProgram)
+#undef glMakeTextureHandleNonResidentARB
+#define glMakeTextureHandleNonResidentARB __POCKET_GL_TRACE_EXT(MakeTextureHandleNonResidentARB)
+#undef glMakeTextureHandleResidentARB
+#define glMakeTextureHandleResidentARB __POCKET_GL_TRACE_EXT(MakeTextureHandleResidentARB)
+#undef glMapBuffer
+#define glMapBuffer __POCKET_GL_TRACE_EXT(MapBuffer)
+#undef glMapBufferRange
+#define glMapBufferRange __POCKET_GL_TRACE_EXT(MapBufferRange)
+#undef glMemoryBarrier
+#define glMemoryBarrier __POCKET_GL_TRACE_EXT(MemoryBarrier)
+#undef glObjectLabel
+#define glObjectLabel __POCKET_GL_TRACE_EXT(ObjectLabel)
+#undef glProgramBinary
+#define glProgramBinary __POCKET_GL_TRACE_EXT(ProgramBinary)
+#undef glProgramParameteri
+#define glProgramParameteri __POCKET_GL_TRACE_EXT(ProgramParameteri)
+#undef glQueryCounter
+#define glQueryCounter __POCKET_GL_TRACE_EXT(QueryCounter)
+#undef glRenderbufferStorageMultisample
+#define glRenderbufferStorageMultisample __POCKET_GL_TRACE_EXT(RenderbufferStorageMultisample)
+#undef glSamplerParameteri
+#define glSamplerParameteri __POCKET_GL_TRACE_EXT(SamplerParameteri)
+#undef glShaderSource
+#define glShaderSource __POCKET_GL_TRACE_EXT(ShaderSource)
+#undef glTexStorage2D
+#define glTexStorage2D __POCKET_GL_TRACE_EXT(TexStorage2D)
+#undef glTexStorage3D
+#define glTexStorage3D __POCKET_GL_TRACE_EXT(TexStorage3D)
+#undef glTexSubImage3D
+#define glTexSubImage3D __POCKET_GL_TRACE_EXT(TexSubImage3D)
+#undef glUniform1f
+#define glUniform1f __POCKET_GL_TRACE_EXT(Uniform1f)
+#undef glUniform1fv
+#define glUniform1fv __POCKET_GL_TRACE_EXT(Uniform1fv)
+#undef glUniform1i
+#define glUniform1i __POCKET_GL_TRACE_EXT(Uniform1i)
+#undef glUniform1iv
+#define glUniform1iv __POCKET_GL_TRACE_EXT(Uniform1iv)
+#undef glUniform1ui
+#define glUniform1ui __POCKET_GL_TRACE_EXT(Uniform1ui)
+#undef glUniform1uiv
+#define glUniform1uiv __POCKET_GL_TRACE_EXT(Uniform1uiv)
+#undef glUniform2f
+#define glUniform2f __POCKET_GL_TRACE_EXT(Uniform2f)
+#undef glUniform2fv
+#define glUniform2fv __POCKET_GL_TRACE_EXT(Uniform2fv)
+#undef glUniform2i
+#define glUniform2i __POCKET_GL_TRACE_EXT(Uniform2i)
+#undef glUniform2iv
+#define glUniform2iv __POCKET_GL_TRACE_EXT(Uniform2iv)
+#undef glUniform2ui
+#define glUniform2ui __POCKET_GL_TRACE_EXT(Uniform2ui)
+#undef glUniform2uiv
+#define glUniform2uiv __POCKET_GL_TRACE_EXT(Uniform2uiv)
+#undef glUniform3f
+#define glUniform3f __POCKET_GL_TRACE_EXT(Uniform3f)
+#undef glUniform3fv
+#define glUniform3fv __POCKET_GL_TRACE_EXT(Uniform3fv)
+#undef glUniform3i
+#define glUniform3i __POCKET_GL_TRACE_EXT(Uniform3i)
+#undef glUniform3iv
+#define glUniform3iv __POCKET_GL_TRACE_EXT(Uniform3iv)
+#undef glUniform3ui
+#define glUniform3ui __POCKET_GL_TRACE_EXT(Uniform3ui)
+#undef glUniform3uiv
+#define glUniform3uiv __POCKET_GL_TRACE_EXT(Uniform3uiv)
+#undef glUniform4f
+#define glUniform4f __POCKET_GL_TRACE_EXT(Uniform4f)
+#undef glUniform4fv
+#define glUniform4fv __POCKET_GL_TRACE_EXT(Uniform4fv)
+#undef glUniform4i
+#define glUniform4i __POCKET_GL_TRACE_EXT(Uniform4i)
+#undef glUniform4iv
+#define glUniform4iv __POCKET_GL_TRACE_EXT(Uniform4iv)
+#undef glUniform4ui
+#define glUniform4ui __POCKET_GL_TRACE_EXT(Uniform4ui)
+#undef glUniform4uiv
+#define glUniform4uiv __POCKET_GL_TRACE_EXT(Uniform4uiv)
+#undef glUniformBlockBinding
+#define glUniformBlockBinding __POCKET_GL_TRACE_EXT(UniformBlockBinding)
+#undef glUniformMatrix3fv
+#define glUniformMatrix3fv __POCKET_GL_TRACE_EXT(UniformMatrix3fv)
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv __POCKET_GL_TRACE_EXT(UniformMatrix4fv)
+#undef glUniformSubroutinesuiv
+#define glUniformSubroutinesuiv __POCKET_GL_TRACE_EXT(UniformSubroutinesuiv)
+#undef glUnmapBuffer
+#define glUnmapBuffer __POCKET_GL_TRACE_EXT(UnmapBuffer)
+#undef glUseProgram
+#define glUseProgram __POCKET_GL_TRACE_EXT(UseProgram)
+#undef glValidateProgram
+#define glValidateProgram __POCKET_GL_TRACE_EXT(ValidateProgram)
+#undef glVertexAttribBinding
+#define glVertexAttribBinding __POCKET_GL_TRACE_EXT(VertexAttribBinding)
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor __POCKET_GL_TRACE_EXT(VertexAttribDivisor)
+#undef glVertexAttribFormat
+#define glVertexAttribFormat __POCKET_GL_TRACE_EXT(VertexAttribFormat)
+#undef glVertexAttribPointer
+#define glVertexAttribPointer __POCKET_GL_TRACE_EXT(VertexAttribPointer)
+#undef glVertexBindingDivisor
+#define glVertexBindingDivisor __POCKET_GL_TRACE_EXT(VertexBindingDivisor)
+#undef glWaitSync
+#define glWaitSync __POCKET_GL_TRACE_EXT(WaitSync)
+
+#define __POCKET_GL_TRACE_CAT_I(A, B) A##B
+#define __POCKET_GL_TRACE_CAT(A, B) __POCKET_GL_TRACE_CAT_I(A, B)
+#ifndef POCKET_GL_TRACE_ZONE
+#	define POCKET_GL_TRACE_ZONE(NAME) ::pocket::gl::trace::zone __POCKET_GL_TRACE_CAT(__pocket_gl_trace_zone, __LINE__)(NAME)
+#endif // POCKET_GL_TRACE_ZONE
+
+#else // POCKET_USE_GL_TRACE
+
+#ifndef POCKET_GL_TRACE_ZONE
+#	define POCKET_GL_TRACE_ZONE(NAME)
+#endif // POCKET_GL_TRACE_ZONE
+
+#endif // POCKET_USE_GL_TRACE
+
+#endif // __POCKET_GL_TRACE_H__
@@ -0,0 +1,401 @@
+﻿#ifndef __POCKET_GL_UNIFORM_ARENA_H__
+#define __POCKET_GL_UNIFORM_ARENA_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "common_type.h"
+#include "buffer.h"
+#include "../io.h"
+#include <vector>
+#include <cstring> // for std::memcpy
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class uniform_arena;
+
+//---------------------------------------------------------------------------------------
+// 描画ごとのユニフォームブロックを一つのバッファにまとめる
+// 1フレーム分をCPU側に詰めてuploadで一度に書き込み, 描画ごとにglBindBufferRangeで範囲を切り替える
+// バッファはframes個の領域に分け, GPUが読み終わっていない領域はフェンスで待ってから使う
+//
+// gl::uniform_arena arena(64 * 1024, 3);
+// prog.uniform_block_bind(prog.uniform_block_index("ublock"), 0);
+// do
+// {
+//     arena.begin();
+//     for (...)
+//     {
+//         data.world = ...;
+//         ranges[i] = arena.push(data);
+//     }
+//     arena.upload();
+//     for (...)
+//     {
+//         arena.bind(0, ranges[i]);
+//         vao.draw(...);
+//     }
+// } while (...);
+//---------------------------------------------------------------------------------------
+class uniform_arena
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// 確保した範囲
+	struct range
+	{
+		GLintptr offset; // バッファ先頭からのバイト数
+		GLsizeiptr size; // 確保できなかった場合は0
+
+		range() :
+			offset(0),
+			size(0)
+		{}
+
+		bool valid() const
+		{
+			return size > 0;
+		}
+	};
+
+private:
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	gl::buffer _buffer;
+	std::vector<char> _staging; // 1フレーム分
+	std::vector<GLsync> _fences; // 領域ごと
+	int _alignment;
+	int _size; // 1フレームの大きさ
+	int _current;
+	int _cursor;
+	int _uploaded;
+	int _overflow;
+	int _stalled;
+	bool _began;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	uniform_arena() :
+		_buffer(),
+		_alignment(0),
+		_size(0),
+		_current(0),
+		_cursor(0),
+		_uploaded(0),
+		_overflow(0),
+		_stalled(0),
+		_began(false),
+		_error_bitfield(0)
+	{}
+	// size: 1フレームの大きさ, frames: GPUが読み終わるのを待たずに使える領域の数
+	explicit uniform_arena(int size, int frames = 3) :
+		_buffer(),
+		_alignment(0),
+		_size(0),
+		_current(0),
+		_cursor(0),
+		_uploaded(0),
+		_overflow(0),
+		_stalled(0),
+		_began(false),
+		_error_bitfield(0)
+	{
+		initialize(size, frames);
+	}
+	~uniform_arena()
+	{
+		finalize();
+	}
+
+private:
+	// フェンスを共有しないように複製は禁止
+	uniform_arena(const uniform_arena&);
+	uniform_arena& operator = (const uniform_arena&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 初期化
+	// sizeはGL_UNIFORM_BUFFER_OFFSET_ALIGNMENTの倍数に切り上げる
+	bool initialize(int size, int frames = 3)
+	{
+		finalize();
+
+		if (size < 1 || frames < 1)
+		{
+			_error_bitfield |= error_insufficient_count;
+			return false;
+		}
+
+		GLint alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		_alignment = alignment > 0 ? static_cast<int>(alignment) : 256;
+		_size = round_up(size, _alignment);
+
+		if (!_buffer.initialize_storage(buffer_type::uniform, _size * frames, NULL, GL_DYNAMIC_STORAGE_BIT))
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+		_staging.resize(_size);
+		_fences.resize(frames, NULL);
+		return true;
+	}
+
+	// 終了処理
+	void finalize()
+	{
+		for (size_t i = 0; i < _fences.size(); ++i)
+		{
+			if (_fences[i] != NULL)
+			{
+				glDeleteSync(_fences[i]);
+			}
+		}
+		_fences.clear();
+		_staging.clear();
+		_buffer.finalize();
+		_alignment = 0;
+		_size = 0;
+		_current = 0;
+		_cursor = 0;
+		_uploaded = 0;
+		_overflow = 0;
+		_stalled = 0;
+		_began = false;
+		_error_bitfield = 0;
+	}
+
+	// フレームの開始
+	// 前のフレームの描画の後ろにフェンスを置き, 次の領域をGPUが読み終わるまで待つ
+	void begin()
+	{
+		if (_fences.empty())
+		{
+			return;
+		}
+		if (_began)
+		{
+			_fences[_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			_current = (_current + 1) % static_cast<int>(_fences.size());
+		}
+		_began = true;
+
+		GLsync& fence = _fences[_current];
+		if (fence != NULL)
+		{
+			if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			{
+				++_stalled;
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			}
+			glDeleteSync(fence);
+			fence = NULL;
+		}
+		_cursor = 0;
+		_uploaded = 0;
+	}
+
+	// 領域の確保
+	// 書き込み先はuploadまで有効
+	void* allocate(int size, range& r)
+	{
+		r = range();
+		if (!_began || size <= 0)
+		{
+			return NULL;
+		}
+		const int offset = round_up(_cursor, _alignment);
+		if (offset + size > _size)
+		{
+			++_overflow;
+			return NULL;
+		}
+		_cursor = offset + size;
+		r.offset = static_cast<GLintptr>(_current * _size + offset);
+		r.size = static_cast<GLsizeiptr>(size);
+		return &_staging[offset];
+	}
+	template <typename T>
+	T* allocate(range& r)
+	{
+		return static_cast<T*>(allocate(static_cast<int>(sizeof(T)), r));
+	}
+
+	// 値を詰める
+	range push(const void* data, int size)
+	{
+		range r;
+		void* address = allocate(size, r);
+		if (address != NULL)
+		{
+			std::memcpy(address, data, size);
+		}
+		return r;
+	}
+	template <typename T>
+	range push(const T& v)
+	{
+		return push(static_cast<const void*>(&v), static_cast<int>(sizeof(T)));
+	}
+
+	// 詰めた値をまとめて書き込む
+	// 同じフレームで続けて詰めた場合は追加分だけを書き込む
+	void upload()
+	{
+		if (!_began || _cursor <= _uploaded)
+		{
+			return;
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer.get());
+		glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(_current * _size + _uploaded),
+			static_cast<GLsizeiptr>(_cursor - _uploaded), &_staging[_uploaded]);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		_uploaded = _cursor;
+	}
+
+	// 範囲をバインディングポイントに設定
+	void bind(GLuint point, const range& r) const
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, point, _buffer.get(), r.offset, r.size);
+	}
+	void unbind(GLuint point) const
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, point, 0);
+	}
+
+	// 全体のバッファ
+	const gl::buffer& buffer() const
+	{
+		return _buffer;
+	}
+
+	// 範囲の先頭の揃え(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+	int alignment() const
+	{
+		return _alignment;
+	}
+	// 1フレームの大きさ
+	int capacity() const
+	{
+		return _size;
+	}
+	// 現在のフレームで使用した大きさ
+	int used() const
+	{
+		return _cursor;
+	}
+	// 領域の数
+	int frames() const
+	{
+		return static_cast<int>(_fences.size());
+	}
+	// 容量が足りずに確保できなかった数
+	int overflow() const
+	{
+		return _overflow;
+	}
+	// GPUが読み終わるのを待った回数
+	int stalled() const
+	{
+		return _stalled;
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "size or frames is less than 1.";
+		}
+		if (error_status(error_creating))
+		{
+			return _buffer.error();
+		}
+		if (_fences.empty())
+		{
+			return "not created. or already destroyed.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return !_fences.empty() && _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+private:
+	static int round_up(int v, int alignment)
+	{
+		return (v + alignment - 1) / alignment * alignment;
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const uniform_arena& v)
+{
+	os << io::widen("uniform_arena: {") << std::endl <<
+		io::tab << io::widen("id: ") << v.buffer().get() << std::endl <<
+		io::tab << io::widen("alignment: ") << v.alignment() << std::endl <<
+		io::tab << io::widen("capacity: ") << v.capacity() << std::endl <<
+		io::tab << io::widen("used: ") << v.used() << std::endl <<
+		io::tab << io::widen("frames: ") << v.frames() << std::endl <<
+		io::tab << io::widen("overflow: ") << v.overflow() << std::endl <<
+		io::tab << io::widen("stalled: ") << v.stalled() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_UNIFORM_ARENA_H__
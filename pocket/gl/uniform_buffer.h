@@ -140,7 +140,7 @@ private:
 	// Members
 	//------------------------------------------------------------------------------------------
 
-	buffer _buffer;
+	gl::buffer _buffer;
 	GLuint _index;
 	GLuint _binding_point;
 	int _size;
@@ -482,7 +482,7 @@ public:
 		return typename rebinder_map<T>::type(*this, U);
 	}
 
-	const buffer& buffer() const
+	const gl::buffer& buffer() const
 	{
 		return _buffer;
 	}
@@ -13,6 +13,7 @@
 #include "buffer.h"
 #include "vertex_buffer.h"
 #include "common_type.h"
+#include "../math/matrix4x4.h"
 
 namespace pocket
 {
@@ -31,6 +32,7 @@ struct vertex_layout
 	int count; // 要素数
 	int normalized; // 正規化するか
 	int offset; // 構造体のオフセット
+	GLuint divisor; // 何インスタンスごとに次の値へ進めるか(0で頂点ごと)
 };
 
 #ifndef POCKET_LAYOUT
@@ -38,7 +40,8 @@ struct vertex_layout
 	pocket::gl::gl_type<TYPE>::value,\
 	(COUNT),\
 	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
-	(OFFSET)\
+	(OFFSET),\
+	0u\
 	}
 #endif // POCKET_LAYOUT
 #ifndef POCKET_LAYOUT_OFFSETOF
@@ -46,9 +49,29 @@ struct vertex_layout
 	pocket::gl::gl_type<TYPE>::value,\
 	(COUNT),\
 	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
-	static_cast<int>(POCKET_OFFSETOF(VERTEX_TYPE, MEM))\
+	static_cast<int>(POCKET_OFFSETOF(VERTEX_TYPE, MEM)),\
+	0u\
 	}
 #endif // POCKET_LAYOUT_OFFSETOF
+// インスタンスごとに進める属性
+#ifndef POCKET_LAYOUT_INSTANCE
+#	define POCKET_LAYOUT_INSTANCE(TYPE, COUNT, NORMALIZED, OFFSET, DIVISOR) {\
+	pocket::gl::gl_type<TYPE>::value,\
+	(COUNT),\
+	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
+	(OFFSET),\
+	static_cast<GLuint>(DIVISOR)\
+	}
+#endif // POCKET_LAYOUT_INSTANCE
+#ifndef POCKET_LAYOUT_INSTANCE_OFFSETOF
+#	define POCKET_LAYOUT_INSTANCE_OFFSETOF(TYPE, COUNT, NORMALIZED, VERTEX_TYPE, MEM, DIVISOR) {\
+	pocket::gl::gl_type<TYPE>::value,\
+	(COUNT),\
+	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
+	static_cast<int>(POCKET_OFFSETOF(VERTEX_TYPE, MEM)),\
+	static_cast<GLuint>(DIVISOR)\
+	}
+#endif // POCKET_LAYOUT_INSTANCE_OFFSETOF
 
 //------------------------------
 // レイアウト指定用構造体（インデックス指定）
@@ -60,6 +83,7 @@ struct vertex_layout_index
 	int count;
 	int normalized;
 	int offset;
+	GLuint divisor;
 };
 
 #ifndef POCKET_LAYOUT_INDEX
@@ -68,7 +92,8 @@ struct vertex_layout_index
 	pocket::gl::gl_type<TYPE>::value,\
 	(COUNT),\
 	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
-	(OFFSET)\
+	(OFFSET),\
+	0u\
 	}
 #endif // POCKET_LAYOUT_INDEX
 #ifndef POCKET_LAYOUT_INDEX_OFFSETOF
@@ -77,9 +102,30 @@ struct vertex_layout_index
 	pocket::gl::gl_type<TYPE>::value,\
 	(COUNT),\
 	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
-	static_cast<int>(POCKET_OFFSETOF(VERTEX_TYPE, MEM))\
+	static_cast<int>(POCKET_OFFSETOF(VERTEX_TYPE, MEM)),\
+	0u\
 	}
 #endif // POCKET_LAYOUT_INDEX_OFFSETOF
+#ifndef POCKET_LAYOUT_INDEX_INSTANCE
+#	define POCKET_LAYOUT_INDEX_INSTANCE(INDEX, TYPE, COUNT, NORMALIZED, OFFSET, DIVISOR) {\
+	(INDEX),\
+	pocket::gl::gl_type<TYPE>::value,\
+	(COUNT),\
+	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
+	(OFFSET),\
+	static_cast<GLuint>(DIVISOR)\
+	}
+#endif // POCKET_LAYOUT_INDEX_INSTANCE
+#ifndef POCKET_LAYOUT_INDEX_INSTANCE_OFFSETOF
+#	define POCKET_LAYOUT_INDEX_INSTANCE_OFFSETOF(INDEX, TYPE, COUNT, NORMALIZED, VERTEX_TYPE, MEM, DIVISOR) {\
+	(INDEX),\
+	pocket::gl::gl_type<TYPE>::value,\
+	(COUNT),\
+	static_cast<int>(pocket::gl::gl_bool<NORMALIZED>::value),\
+	static_cast<int>(POCKET_OFFSETOF(VERTEX_TYPE, MEM)),\
+	static_cast<GLuint>(DIVISOR)\
+	}
+#endif // POCKET_LAYOUT_INDEX_INSTANCE_OFFSETOF
 
 class vertex_array
 {
@@ -290,6 +336,10 @@ public:
 			glEnableVertexAttribArray(i);
 			glVertexAttribPointer(i, layout.count, layout.type, static_cast<GLboolean>(layout.normalized),
 				stride, POCKET_BUFFER_OFFSET(layout.offset));
+			if (layout.divisor != 0)
+			{
+				glVertexAttribDivisor(i, layout.divisor);
+			}
 		}
 
 		glBindVertexArray(0);
@@ -365,6 +415,10 @@ public:
 			glEnableVertexAttribArray(i);
 			glVertexAttribPointer(i, layout.count, layout.type, static_cast<GLboolean>(layout.normalized),
 				stride, POCKET_BUFFER_OFFSET(layout.offset));
+			if (layout.divisor != 0)
+			{
+				glVertexAttribDivisor(i, layout.divisor);
+			}
 		}
 
 		glBindVertexArray(0);
@@ -434,6 +488,10 @@ public:
 			glEnableVertexAttribArray(i);
 			glVertexAttribPointer(i, layout.count, layout.type, static_cast<GLboolean>(layout.normalized),
 				sizeof(T), POCKET_BUFFER_OFFSET(layout.offset));
+			if (layout.divisor != 0)
+			{
+				glVertexAttribDivisor(i, layout.divisor);
+			}
 		}
 
 		glBindVertexArray(0);
@@ -487,6 +545,10 @@ public:
 			glEnableVertexAttribArray(layout.index);
 			glVertexAttribPointer(layout.index, layout.count, layout.type, static_cast<GLboolean>(layout.normalized),
 				stride, POCKET_BUFFER_OFFSET(layout.offset));
+			if (layout.divisor != 0)
+			{
+				glVertexAttribDivisor(layout.index, layout.divisor);
+			}
 		}
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -557,6 +619,10 @@ public:
 			glEnableVertexAttribArray(layout.index);
 			glVertexAttribPointer(layout.index, layout.count, layout.type, static_cast<GLboolean>(layout.normalized),
 				stride, POCKET_BUFFER_OFFSET(layout.offset));
+			if (layout.divisor != 0)
+			{
+				glVertexAttribDivisor(layout.index, layout.divisor);
+			}
 		}
 
 		glBindVertexArray(0);
@@ -625,6 +691,10 @@ public:
 			glEnableVertexAttribArray(layout.index);
 			glVertexAttribPointer(layout.index, layout.count, layout.type, static_cast<GLboolean>(layout.normalized),
 				sizeof(T), POCKET_BUFFER_OFFSET(layout.offset));
+			if (layout.divisor != 0)
+			{
+				glVertexAttribDivisor(layout.index, layout.divisor);
+			}
 		}
 
 		glBindVertexArray(0);
@@ -689,6 +759,190 @@ public:
 		return binder_type(*this);
 	}
 
+	// インデックスバッファをVAOに登録
+	// buffer_heapのように複数のメッシュで共有するバッファを設定しておく
+	void attach_index(GLuint ibo) const
+	{
+		glBindVertexArray(_id);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	void attach_index(const buffer& ibo) const
+	{
+		attach_index(ibo.get());
+	}
+
+	// インスタンスごとの頂点属性を別のバッファから追加
+	// divisorが0のレイアウトは1として扱う(1インスタンスごとに次の値へ進める)
+	bool attach_instance(GLuint vbo, GLuint stride, const vertex_layout_index* layouts, int count) const
+	{
+		if (_id == 0 || glIsBuffer(vbo) != GL_TRUE)
+		{
+			return false;
+		}
+		glBindVertexArray(_id);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		for (int i = 0; i < count; ++i)
+		{
+			const vertex_layout_index& layout = layouts[i];
+			glEnableVertexAttribArray(layout.index);
+			glVertexAttribPointer(layout.index, layout.count, layout.type, static_cast<GLboolean>(layout.normalized),
+				stride, POCKET_BUFFER_OFFSET(layout.offset));
+			glVertexAttribDivisor(layout.index, layout.divisor != 0 ? layout.divisor : 1);
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return true;
+	}
+	template <int N>
+	bool attach_instance(GLuint vbo, GLuint stride, POCKET_CREF_ARRAY_ARG(vertex_layout_index, layouts, N)) const
+	{
+		return attach_instance(vbo, stride, &layouts[0], N);
+	}
+	bool attach_instance(const buffer& vbo, GLuint stride, const vertex_layout_index* layouts, int count) const
+	{
+		if (!vbo.kind_of(buffer_type::array))
+		{
+			return false;
+		}
+		return attach_instance(vbo.get(), stride, layouts, count);
+	}
+	template <int N>
+	bool attach_instance(const buffer& vbo, GLuint stride, POCKET_CREF_ARRAY_ARG(vertex_layout_index, layouts, N)) const
+	{
+		return attach_instance(vbo, stride, &layouts[0], N);
+	}
+	template <typename T>
+	bool attach_instance(const vertex_buffer<T>& vbo, const vertex_layout_index* layouts, int count) const
+	{
+		return attach_instance(vbo.get(), sizeof(T), layouts, count);
+	}
+	template <typename T, int N>
+	bool attach_instance(const vertex_buffer<T>& vbo, POCKET_CREF_ARRAY_ARG(vertex_layout_index, layouts, N)) const
+	{
+		return attach_instance(vbo.get(), sizeof(T), &layouts[0], N);
+	}
+	// インスタンスごとの行列
+	// indexから4つの属性を使う(シェーダー側は layout(location = index) in mat4)
+	// 各行はprogram::uniformで転置せずに渡した場合と同じ並びになる
+	template <typename T>
+	bool attach_instance(const vertex_buffer<math::matrix4x4<T> >& vbo, GLuint index, GLuint divisor = 1) const
+	{
+		typedef math::matrix4x4<T> matrix_type;
+		vertex_layout_index layouts[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			layouts[i].index = static_cast<int>(index) + i;
+			layouts[i].type = gl_type<T>::value;
+			layouts[i].count = 4;
+			layouts[i].normalized = GL_FALSE;
+			layouts[i].offset = static_cast<int>(sizeof(T) * 4 * i);
+			layouts[i].divisor = divisor;
+		}
+		return attach_instance(vbo.get(), sizeof(matrix_type), layouts, 4);
+	}
+
+	// 頂点フォーマットだけを持つVAOの作成(GL4.3, ARB_vertex_attrib_binding)
+	// 頂点バッファはbind_vertex_bufferで差し替えるため, 同じフォーマットのメッシュで一つのVAOを共有できる
+	// レイアウトは全てbindingのバインディングポイントから読み込む
+	// divisorはバインディングポイント単位のため, divisorが異なるレイアウトは失敗する(attach_formatで別のバインディングポイントに分ける)
+	bool initialize_format(const vertex_layout* layouts, int count, GLuint binding = 0)
+	{
+		if (!same_divisor(layouts, count))
+		{
+			_error_bitfield |= error_invalid_data;
+			return false;
+		}
+		if (!create())
+		{
+			return false;
+		}
+		for (int i = 0; i < count; ++i)
+		{
+			const vertex_layout& layout = layouts[i];
+			attrib_format(i, layout.type, layout.count, layout.normalized, layout.offset, binding);
+			if (layout.divisor != 0)
+			{
+				glVertexBindingDivisor(binding, layout.divisor);
+			}
+		}
+		glBindVertexArray(0);
+		return true;
+	}
+	template <int N>
+	bool initialize_format(POCKET_CREF_ARRAY_ARG(vertex_layout, layouts, N), GLuint binding = 0)
+	{
+		return initialize_format(&layouts[0], N, binding);
+	}
+	bool initialize_format(const vertex_layout_index* layouts, int count, GLuint binding = 0)
+	{
+		if (!same_divisor(layouts, count))
+		{
+			_error_bitfield |= error_invalid_data;
+			return false;
+		}
+		if (!create())
+		{
+			return false;
+		}
+		glBindVertexArray(0);
+		return attach_format(layouts, count, binding);
+	}
+	template <int N>
+	bool initialize_format(POCKET_CREF_ARRAY_ARG(vertex_layout_index, layouts, N), GLuint binding = 0)
+	{
+		return initialize_format(&layouts[0], N, binding);
+	}
+
+	// 別のバインディングポイントから読み込む属性を追加(インスタンスごとの属性など)
+	// divisorはバインディングポイント単位で設定されるため, divisorが異なるレイアウトは失敗する
+	bool attach_format(const vertex_layout_index* layouts, int count, GLuint binding) const
+	{
+		if (_id == 0 || !same_divisor(layouts, count))
+		{
+			return false;
+		}
+		glBindVertexArray(_id);
+		for (int i = 0; i < count; ++i)
+		{
+			const vertex_layout_index& layout = layouts[i];
+			attrib_format(layout.index, layout.type, layout.count, layout.normalized, layout.offset, binding);
+			if (layout.divisor != 0)
+			{
+				glVertexBindingDivisor(binding, layout.divisor);
+			}
+		}
+		glBindVertexArray(0);
+		return true;
+	}
+	template <int N>
+	bool attach_format(POCKET_CREF_ARRAY_ARG(vertex_layout_index, layouts, N), GLuint binding) const
+	{
+		return attach_format(&layouts[0], N, binding);
+	}
+
+	// バインディングポイントに頂点バッファを設定
+	// バインドしているVAOに対して設定されるため, 先にbindしておくこと
+	void bind_vertex_buffer(GLuint binding, GLuint vbo, GLintptr offset, GLsizei stride) const
+	{
+		glBindVertexBuffer(binding, vbo, offset, stride);
+	}
+	void bind_vertex_buffer(GLuint binding, const buffer& vbo, GLintptr offset, GLsizei stride) const
+	{
+		glBindVertexBuffer(binding, vbo.get(), offset, stride);
+	}
+	// first番目の頂点から読み込む
+	template <typename T>
+	void bind_vertex_buffer(GLuint binding, const vertex_buffer<T>& vbo, int first = 0) const
+	{
+		glBindVertexBuffer(binding, vbo.get(), static_cast<GLintptr>(sizeof(T) * first), sizeof(T));
+	}
+	void unbind_vertex_buffer(GLuint binding) const
+	{
+		glBindVertexBuffer(binding, 0, 0, 0);
+	}
+
 	// インデックスが有効になっているか
 	bool enabled(int i) const
 	{
@@ -750,6 +1004,11 @@ public:
 		{
 			return "not vertex buffer object.";
 		}
+		// 同じバインディングポイントにdivisorが異なるレイアウトを渡された
+		if (error_status(error_invalid_data))
+		{
+			return "different divisors in one binding.";
+		}
 		// 作成されていない またはすでに破棄済み
 		if (_id == 0)
 		{
@@ -830,6 +1089,47 @@ public:
 		return *this;
 	}
 #endif // POCKET_USE_CXX11
+
+private:
+	// VAOを作成してバインドする
+	bool create()
+	{
+		finalize();
+
+		glGenVertexArrays(1, &_id);
+		if (_id == 0)
+		{
+			_error_bitfield |= error_creating;
+			return false;
+		}
+		glBindVertexArray(_id);
+		if (glIsVertexArray(_id) == GL_FALSE)
+		{
+			_error_bitfield |= error_binding;
+			return false;
+		}
+		return true;
+	}
+
+	static void attrib_format(GLuint index, GLenum type, int count, int normalized, int offset, GLuint binding)
+	{
+		glEnableVertexAttribArray(index);
+		glVertexAttribFormat(index, count, type, static_cast<GLboolean>(normalized), static_cast<GLuint>(offset));
+		glVertexAttribBinding(index, binding);
+	}
+	// 全てのレイアウトのdivisorが同じか
+	template <typename Layout>
+	static bool same_divisor(const Layout* layouts, int count)
+	{
+		for (int i = 1; i < count; ++i)
+		{
+			if (layouts[i].divisor != layouts[0].divisor)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
 };
 
 inline
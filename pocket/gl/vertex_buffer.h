@@ -369,6 +369,24 @@ public:
 	{
 		glDrawArraysIndirect(type, NULL);
 	}
+	// インスタンス描画
+	// base_instanceはdivisorを設定した属性の読み始める位置
+	void draw_instanced(draw_type_t type, GLsizei instances, GLuint base_instance = 0) const
+	{
+		draw_instanced(type, 0, _count, instances, base_instance);
+	}
+	void draw_instanced(draw_type_t type, GLint first, GLsizei n, GLsizei instances, GLuint base_instance = 0) const
+	{
+		n = std::min(n, _count - first);
+		if (base_instance == 0)
+		{
+			glDrawArraysInstanced(type, first, n, instances);
+		}
+		else
+		{
+			glDrawArraysInstancedBaseInstance(type, first, n, instances, base_instance);
+		}
+	}
 
 	// バッファを展開して先頭アドレスを取得
 	vertex_type* map(buffer_map_type_t type) const
@@ -0,0 +1,410 @@
+﻿#ifndef __POCKET_GL_VERTEX_FORMAT_REGISTRY_H__
+#define __POCKET_GL_VERTEX_FORMAT_REGISTRY_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "gl.h"
+#include "buffer.h"
+#include "vertex_buffer.h"
+#include "index_buffer.h"
+#include "vertex_array.h"
+#include "../io.h"
+#include <vector>
+#include <map>
+#include <algorithm> // for std::sort
+
+namespace pocket
+{
+namespace gl
+{
+
+// forward
+class vertex_format_registry;
+
+//---------------------------------------------------------------------------------------
+// 頂点フォーマットの登録
+// レイアウトの配列と頂点の大きさからフォーマットIDを作り, フォーマットだけのVAO(initialize_format)を共有する
+// 同じレイアウトを渡したメッシュは同じIDとVAOになるため, 描画をIDで並べるとVAOの切り替えが減る
+// IDは登録順に0から振られる
+//
+// gl::vertex_format_registry formats;
+// const gl::vertex_layout layouts[] =
+// {
+//     POCKET_LAYOUT_OFFSETOF(float, 3, false, vertex, position),
+//     POCKET_LAYOUT_OFFSETOF(float, 2, false, vertex, uv)
+// };
+// mesh.format = formats.find_or_create<vertex>(layouts);
+// ...
+// formats.bind(mesh.format);
+// formats.bind_vertex_buffer(mesh.format, mesh.vbo);
+// formats.bind_index_buffer(mesh.format, mesh.ibo);
+// mesh.ibo.draw(...);
+//---------------------------------------------------------------------------------------
+class vertex_format_registry
+{
+public:
+	//------------------------------------------------------------------------------------------
+	// Types
+	//------------------------------------------------------------------------------------------
+
+	// フォーマットID(-1は無効)
+	typedef int format_id;
+
+	typedef unsigned int hash_type;
+
+private:
+	// 登録済みのフォーマット
+	struct format
+	{
+		hash_type hash;
+		GLsizei stride;
+		std::vector<vertex_layout_index> layouts; // インデックス順
+		vertex_array* vao;
+	};
+
+	//------------------------------------------------------------------------------------------
+	// Members
+	//------------------------------------------------------------------------------------------
+
+	std::vector<format> _formats;
+	std::multimap<hash_type, format_id> _table;
+	int _hits;
+	int _error_bitfield;
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Constants
+	//------------------------------------------------------------------------------------------
+
+	// none
+
+	//------------------------------------------------------------------------------------------
+	// Constructors
+	//------------------------------------------------------------------------------------------
+
+	vertex_format_registry() :
+		_hits(0),
+		_error_bitfield(0)
+	{}
+	~vertex_format_registry()
+	{
+		finalize();
+	}
+
+private:
+	// VAOを共有しないように複製は禁止
+	vertex_format_registry(const vertex_format_registry&);
+	vertex_format_registry& operator = (const vertex_format_registry&);
+
+public:
+	//------------------------------------------------------------------------------------------
+	// Functions
+	//------------------------------------------------------------------------------------------
+
+	// 終了処理
+	// 作成したVAOを全て削除する
+	void finalize()
+	{
+		for (size_t i = 0; i < _formats.size(); ++i)
+		{
+			delete _formats[i].vao;
+		}
+		_formats.clear();
+		_table.clear();
+		_hits = 0;
+		_error_bitfield = 0;
+	}
+
+	// フォーマットIDの取得
+	// 登録されていなければVAOを作成して登録する
+	format_id find_or_create(const vertex_layout* layouts, int count, GLsizei stride)
+	{
+		std::vector<vertex_layout_index> canonical(count);
+		for (int i = 0; i < count; ++i)
+		{
+			const vertex_layout& layout = layouts[i];
+			vertex_layout_index& c = canonical[i];
+			c.index = i;
+			c.type = layout.type;
+			c.count = layout.count;
+			c.normalized = layout.normalized;
+			c.offset = layout.offset;
+			c.divisor = layout.divisor;
+		}
+		return find_or_create(canonical, stride);
+	}
+	template <int N>
+	format_id find_or_create(POCKET_CREF_ARRAY_ARG(vertex_layout, layouts, N), GLsizei stride)
+	{
+		return find_or_create(&layouts[0], N, stride);
+	}
+	template <typename VERTEX>
+	format_id find_or_create(const vertex_layout* layouts, int count)
+	{
+		return find_or_create(layouts, count, sizeof(VERTEX));
+	}
+	template <typename VERTEX, int N>
+	format_id find_or_create(POCKET_CREF_ARRAY_ARG(vertex_layout, layouts, N))
+	{
+		return find_or_create(&layouts[0], N, sizeof(VERTEX));
+	}
+	format_id find_or_create(const vertex_layout_index* layouts, int count, GLsizei stride)
+	{
+		std::vector<vertex_layout_index> canonical(layouts, layouts + count);
+		return find_or_create(canonical, stride);
+	}
+	template <int N>
+	format_id find_or_create(POCKET_CREF_ARRAY_ARG(vertex_layout_index, layouts, N), GLsizei stride)
+	{
+		return find_or_create(&layouts[0], N, stride);
+	}
+	template <typename VERTEX>
+	format_id find_or_create(const vertex_layout_index* layouts, int count)
+	{
+		return find_or_create(layouts, count, sizeof(VERTEX));
+	}
+	template <typename VERTEX, int N>
+	format_id find_or_create(POCKET_CREF_ARRAY_ARG(vertex_layout_index, layouts, N))
+	{
+		return find_or_create(&layouts[0], N, sizeof(VERTEX));
+	}
+
+	// フォーマットのVAO
+	const vertex_array& get(format_id id) const
+	{
+		return *_formats[id].vao;
+	}
+	// フォーマットの頂点の大きさ
+	GLsizei stride(format_id id) const
+	{
+		return _formats[id].stride;
+	}
+	// フォーマットのハッシュ値
+	hash_type hash(format_id id) const
+	{
+		return _formats[id].hash;
+	}
+
+	// フォーマットのVAOをバインド
+	void bind(format_id id) const
+	{
+		_formats[id].vao->bind();
+	}
+	void unbind() const
+	{
+		glBindVertexArray(0);
+	}
+
+	// バインドしているフォーマットのVAOに頂点バッファを設定
+	// first番目の頂点から読み込む
+	void bind_vertex_buffer(format_id id, GLuint vbo, int first = 0) const
+	{
+		const GLsizei s = _formats[id].stride;
+		glBindVertexBuffer(0, vbo, static_cast<GLintptr>(s * first), s);
+	}
+	void bind_vertex_buffer(format_id id, const buffer& vbo, int first = 0) const
+	{
+		bind_vertex_buffer(id, vbo.get(), first);
+	}
+	template <typename T>
+	void bind_vertex_buffer(format_id id, const vertex_buffer<T>& vbo, int first = 0) const
+	{
+		bind_vertex_buffer(id, vbo.get(), first);
+	}
+
+	// バインドしているフォーマットのVAOにインデックスバッファを設定
+	// VAOは同じフォーマットのメッシュで共有されるため, 頂点バッファと同様に描画ごとに設定する
+	void bind_index_buffer(format_id, GLuint ibo) const
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	}
+	void bind_index_buffer(format_id id, const buffer& ibo) const
+	{
+		bind_index_buffer(id, ibo.get());
+	}
+	template <typename T>
+	void bind_index_buffer(format_id id, const index_buffer<T>& ibo) const
+	{
+		bind_index_buffer(id, ibo.get());
+	}
+
+	// 登録されているフォーマットの数
+	int count() const
+	{
+		return static_cast<int>(_formats.size());
+	}
+	// 登録済みのフォーマットが見つかった回数
+	int hits() const
+	{
+		return _hits;
+	}
+
+	// レイアウトと頂点の大きさのハッシュ値(FNV-1a)
+	// 同じ属性であればレイアウトの並びに関係なく同じ値になる
+	static hash_type hash(const vertex_layout_index* layouts, int count, GLsizei stride)
+	{
+		std::vector<vertex_layout_index> canonical(layouts, layouts + count);
+		std::sort(canonical.begin(), canonical.end(), less_index);
+		return hash(canonical, stride);
+	}
+
+	// エラー文
+	std::string error() const
+	{
+		if (error_status(error_insufficient_count))
+		{
+			return "layout count is less than 1.";
+		}
+		if (error_status(error_creating))
+		{
+			return "can not create vertex array.";
+		}
+		return "";
+	}
+
+	// エラーのステータス確認
+	bool error_status(error_bitfield bit) const
+	{
+		return (_error_bitfield & bit) != 0;
+	}
+
+	// 有効な状態か
+	bool valid() const
+	{
+		return _error_bitfield == 0;
+	}
+
+	//------------------------------------------------------------------------------------------
+	// Operators
+	//------------------------------------------------------------------------------------------
+
+	POCKET_CXX11_EXPLICIT operator bool () const
+	{
+		return valid();
+	}
+	bool operator ! () const
+	{
+		return !valid();
+	}
+
+	const vertex_array& operator [] (format_id id) const
+	{
+		return get(id);
+	}
+
+private:
+	format_id find_or_create(std::vector<vertex_layout_index>& canonical, GLsizei stride)
+	{
+		if (canonical.empty())
+		{
+			_error_bitfield |= error_insufficient_count;
+			return -1;
+		}
+		std::sort(canonical.begin(), canonical.end(), less_index);
+		const hash_type h = hash(canonical, stride);
+
+		// ハッシュ値が同じでもレイアウトが一致するものだけを同じフォーマットとする
+		typedef std::multimap<hash_type, format_id>::const_iterator iterator;
+		std::pair<iterator, iterator> range = _table.equal_range(h);
+		for (iterator i = range.first; i != range.second; ++i)
+		{
+			const format& f = _formats[i->second];
+			if (f.stride == stride && equal(f.layouts, canonical))
+			{
+				++_hits;
+				return i->second;
+			}
+		}
+
+		vertex_array* vao = new vertex_array();
+		if (!vao->initialize_format(&canonical[0], static_cast<int>(canonical.size())))
+		{
+			delete vao;
+			_error_bitfield |= error_creating;
+			return -1;
+		}
+		const format_id id = static_cast<format_id>(_formats.size());
+		_formats.push_back(format());
+		format& f = _formats.back();
+		f.hash = h;
+		f.stride = stride;
+		f.layouts.swap(canonical);
+		f.vao = vao;
+		_table.insert(std::make_pair(h, id));
+		return id;
+	}
+
+	static hash_type hash(const std::vector<vertex_layout_index>& canonical, GLsizei stride)
+	{
+		hash_type h = 2166136261U;
+		h = combine(h, static_cast<hash_type>(stride));
+		for (size_t i = 0; i < canonical.size(); ++i)
+		{
+			const vertex_layout_index& layout = canonical[i];
+			h = combine(h, static_cast<hash_type>(layout.index));
+			h = combine(h, static_cast<hash_type>(layout.type));
+			h = combine(h, static_cast<hash_type>(layout.count));
+			h = combine(h, static_cast<hash_type>(layout.normalized != 0));
+			h = combine(h, static_cast<hash_type>(layout.offset));
+			h = combine(h, static_cast<hash_type>(layout.divisor));
+		}
+		return h;
+	}
+	static hash_type combine(hash_type h, hash_type v)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			h ^= (v >> (i * 8)) & 0xFFU;
+			h *= 16777619U;
+		}
+		return h;
+	}
+
+	static bool less_index(const vertex_layout_index& a, const vertex_layout_index& b)
+	{
+		return a.index < b.index;
+	}
+	static bool equal(const std::vector<vertex_layout_index>& a, const std::vector<vertex_layout_index>& b)
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (a[i].index != b[i].index ||
+				a[i].type != b[i].type ||
+				a[i].count != b[i].count ||
+				(a[i].normalized != 0) != (b[i].normalized != 0) ||
+				a[i].offset != b[i].offset ||
+				a[i].divisor != b[i].divisor)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+template <typename CharT, typename CharTraits> inline
+std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const vertex_format_registry& v)
+{
+	os << io::widen("vertex_format_registry: {") << std::endl <<
+		io::tab << io::widen("count: ") << v.count() << std::endl <<
+		io::tab << io::widen("hits: ") << v.hits() << std::endl;
+	if (!v.valid())
+	{
+		std::string error = v.error();
+		os << io::tab << io::widen("error: ") << io::widen(error.c_str()) << std::endl;
+	}
+	os << io::braces_right;
+	return os;
+}
+
+} // namespace gl
+} // namespace pocket
+
+#endif // __POCKET_GL_VERTEX_FORMAT_REGISTRY_H__
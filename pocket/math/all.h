@@ -12,6 +12,7 @@
 #include "vector2.h"
 #include "vector3.h"
 #include "vector4.h"
+#include "expression.h"
 #include "matrix3x3.h"
 #include "matrix4x4.h"
 #include "plane.h"
@@ -21,5 +22,6 @@
 #include "ray.h"
 #include "color.h"
 #include "rectangle.h"
+#include "batch.h"
 
 #endif // __POCKET_MATH_ALL_H__
@@ -0,0 +1,918 @@
+﻿#ifndef __POCKET_MATH_BATCH_H__
+#define __POCKET_MATH_BATCH_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "../cpu_feature.h"
+#include "math_traits.h"
+#include "simd_traits.h"
+#include "vector4.h"
+#include "matrix3x3.h"
+#include "matrix4x4.h"
+#include "plane.h"
+#include "frustum.h"
+#include <cstddef>
+#include <cmath>
+
+//---------------------------------------------------------------------------------------
+// AVX2+FMAのカーネルを生成するか. 実行時判定が使用できない場合はコンパイル時の設定に従う
+//---------------------------------------------------------------------------------------
+#ifndef __POCKET_MATH_BATCH_AVX2
+#	if defined(POCKET_USE_SIMD_DISPATCH) || (defined(POCKET_USE_SIMD_FMA) && (POCKET_USE_SIMD_TYPE >= POCKET_SIMD_TYPE_AVX2))
+#		define __POCKET_MATH_BATCH_AVX2
+#	endif
+#endif // __POCKET_MATH_BATCH_AVX2
+
+//---------------------------------------------------------------------------------------
+// AVX-512のカーネルを生成するか(GCCはAVX512VLの組み込み関数が5.0から)
+// clangはGCC 4.2として判定されるため__clang__で除く
+//---------------------------------------------------------------------------------------
+#ifndef __POCKET_MATH_BATCH_AVX512
+#	if (defined(POCKET_USE_SIMD_DISPATCH) && !(POCKET_COMPILER_IF(GCC) && !defined(__clang__) && !POCKET_GCC_HAS_VERSION(5, 0))) || (POCKET_USE_SIMD_TYPE >= POCKET_SIMD_TYPE_AVX512)
+#		define __POCKET_MATH_BATCH_AVX512
+#	endif
+#endif // __POCKET_MATH_BATCH_AVX512
+
+namespace pocket
+{
+namespace math
+{
+
+//---------------------------------------------------------------------------------------
+// 配列に対する一括処理
+// floatはCPUIDで判定した命令セットのカーネルを初回呼び出し時に選択して使用する
+// dot, length, normalize, cull_spheresは成分ごとの配列(SoA)を受け取る
+//
+// batch_traitsf::transform(m, src, dst, n); // dst[i] = m.transform(src[i])
+// batch_traitsf::cull_spheres(f, x, y, z, r, visible, n); // visible[i] = f.inside_sphere(...)
+// batch_traitsf::normal_matrix(worlds, normals, n); // normals[i * 3 + 0～2] = matrix3x3().normal_matrix_from(worlds[i])
+//---------------------------------------------------------------------------------------
+
+namespace detail
+{
+//---------------------------------------------------------------------
+// カーネルの関数ポインタ
+// 行列は行優先16要素, 平面は(a, b, c, d)x6の24要素のfloat配列を受け取る
+//---------------------------------------------------------------------
+struct batch_kernel_f
+{
+	void (*transform)(const float*, const float*, float*, size_t);
+	void (*mad)(const float*, const float*, const float*, float*, size_t);
+	void (*dot)(const float*, const float*, const float*, const float*, const float*, const float*, float*, size_t);
+	void (*length)(const float*, const float*, const float*, float*, size_t);
+	void (*normalize)(float*, float*, float*, size_t);
+	size_t (*cull_spheres)(const float*, const float*, const float*, const float*, const float*, unsigned char*, size_t);
+	void (*normal_matrix)(const float*, float*, size_t, int);
+	// 選択されたカーネルのPOCKET_SIMD_TYPE_XXX, SIMDを使用しない場合は-1
+	int simd_type;
+};
+
+//---------------------------------------------------------------------
+// 汎用. SIMDカーネルの端数処理にも使用する
+//---------------------------------------------------------------------
+inline void batch_transform_scalar(const float* m, const float* src, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; ++i, src += 4, dst += 4)
+	{
+		const float x = src[0], y = src[1], z = src[2], w = src[3];
+		dst[0] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+		dst[1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+		dst[2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+		dst[3] = m[3] * x + m[7] * y + m[11] * z + m[15] * w;
+	}
+}
+inline void batch_mad_scalar(const float* a, const float* b, const float* c, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		dst[i] = a[i] * b[i] + c[i];
+	}
+}
+inline void batch_dot_scalar(const float* ax, const float* ay, const float* az, const float* bx, const float* by, const float* bz, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		dst[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+	}
+}
+inline void batch_length_scalar(const float* x, const float* y, const float* z, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		dst[i] = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+	}
+}
+inline void batch_normalize_scalar(float* x, float* y, float* z, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		const float len = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+		// 長さが0の場合はvector3::normalizeと同じくそのまま
+		if (len > 0.0f)
+		{
+			const float r = 1.0f / std::sqrt(len);
+			x[i] *= r;
+			y[i] *= r;
+			z[i] *= r;
+		}
+	}
+}
+inline size_t batch_cull_spheres_scalar(const float* p, const float* x, const float* y, const float* z, const float* r, unsigned char* visible, size_t n)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		// frustum::inside_sphereと同じく, いずれかの平面の背面(距離が-半径未満)にあれば外
+		const float nr = -r[i];
+		bool inside = true;
+		for (int j = 0; j < 24; j += 4)
+		{
+			inside = inside && (p[j] * x[i] + p[j + 1] * y[i] + p[j + 2] * z[i] + p[j + 3] >= nr);
+		}
+		visible[i] = inside ? 1 : 0;
+		count += inside ? 1 : 0;
+	}
+	return count;
+}
+inline void batch_normal_matrix_scalar(const float* src, float* dst, size_t n, int exact)
+{
+	for (size_t i = 0; i < n; ++i, src += 16, dst += 12)
+	{
+		// 左上3x3の余因子行列, 各行はvector4(w = 0)に詰める
+		const float* r0 = src;
+		const float* r1 = src + 4;
+		const float* r2 = src + 8;
+		dst[0] = r1[1] * r2[2] - r1[2] * r2[1];
+		dst[1] = r1[2] * r2[0] - r1[0] * r2[2];
+		dst[2] = r1[0] * r2[1] - r1[1] * r2[0];
+		dst[4] = r2[1] * r0[2] - r2[2] * r0[1];
+		dst[5] = r2[2] * r0[0] - r2[0] * r0[2];
+		dst[6] = r2[0] * r0[1] - r2[1] * r0[0];
+		dst[8] = r0[1] * r1[2] - r0[2] * r1[1];
+		dst[9] = r0[2] * r1[0] - r0[0] * r1[2];
+		dst[10] = r0[0] * r1[1] - r0[1] * r1[0];
+		dst[3] = dst[7] = dst[11] = 0.0f;
+
+		// matrix3x3::normal_matrix_fromと同じく, exactの場合のみ行列式で割る
+		const float det = r0[0] * dst[0] + r0[1] * dst[1] + r0[2] * dst[2];
+		float s = det < 0.0f ? -1.0f : 1.0f;
+		if (exact != 0)
+		{
+			const float bound = math_traits<float>::sqrt(r0[0] * r0[0] + r0[1] * r0[1] + r0[2] * r0[2]) *
+				math_traits<float>::sqrt(r1[0] * r1[0] + r1[1] * r1[1] + r1[2] * r1[2]) *
+				math_traits<float>::sqrt(r2[0] * r2[0] + r2[1] * r2[1] + r2[2] * r2[2]);
+			if (math_traits<float>::abs(det) > math_traits<float>::epsilon * bound)
+			{
+				s = 1.0f / det;
+			}
+		}
+		if (s != 1.0f)
+		{
+			for (int j = 0; j < 12; ++j)
+			{
+				dst[j] *= s;
+			}
+		}
+	}
+}
+
+#ifdef POCKET_USE_SIMD_128
+//---------------------------------------------------------------------
+// SSE2
+//---------------------------------------------------------------------
+inline void batch_transform_sse2(const float* m, const float* src, float* dst, size_t n)
+{
+	const __m128 r0 = _mm_loadu_ps(m);
+	const __m128 r1 = _mm_loadu_ps(m + 4);
+	const __m128 r2 = _mm_loadu_ps(m + 8);
+	const __m128 r3 = _mm_loadu_ps(m + 12);
+	for (size_t i = 0; i < n; ++i, src += 4, dst += 4)
+	{
+		const __m128 v = _mm_loadu_ps(src);
+		__m128 r = _mm_mul_ps(r0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm_add_ps(r, _mm_mul_ps(r1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+		r = _mm_add_ps(r, _mm_mul_ps(r2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+		r = _mm_add_ps(r, _mm_mul_ps(r3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+		_mm_storeu_ps(dst, r);
+	}
+}
+inline void batch_mad_sse2(const float* a, const float* b, const float* c, float* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)), _mm_loadu_ps(c + i)));
+	}
+	batch_mad_scalar(a + i, b + i, c + i, dst + i, n - i);
+}
+inline void batch_dot_sse2(const float* ax, const float* ay, const float* az, const float* bx, const float* by, const float* bz, float* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 r = _mm_mul_ps(_mm_loadu_ps(ax + i), _mm_loadu_ps(bx + i));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(ay + i), _mm_loadu_ps(by + i)));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(az + i), _mm_loadu_ps(bz + i)));
+		_mm_storeu_ps(dst + i, r);
+	}
+	batch_dot_scalar(ax + i, ay + i, az + i, bx + i, by + i, bz + i, dst + i, n - i);
+}
+inline void batch_length_sse2(const float* x, const float* y, const float* z, float* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+		const __m128 len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		_mm_storeu_ps(dst + i, _mm_sqrt_ps(len));
+	}
+	batch_length_scalar(x + i, y + i, z + i, dst + i, n - i);
+}
+inline void batch_normalize_sse2(float* x, float* y, float* z, size_t n)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+		const __m128 len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		// 長さが0の要素は1を掛ける
+		const __m128 valid = _mm_cmpgt_ps(len, _mm_setzero_ps());
+		__m128 r = _mm_div_ps(one, _mm_sqrt_ps(len));
+		r = _mm_or_ps(_mm_and_ps(valid, r), _mm_andnot_ps(valid, one));
+		_mm_storeu_ps(x + i, _mm_mul_ps(vx, r));
+		_mm_storeu_ps(y + i, _mm_mul_ps(vy, r));
+		_mm_storeu_ps(z + i, _mm_mul_ps(vz, r));
+	}
+	batch_normalize_scalar(x + i, y + i, z + i, n - i);
+}
+inline size_t batch_cull_spheres_sse2(const float* p, const float* x, const float* y, const float* z, const float* r, unsigned char* visible, size_t n)
+{
+	__m128 pl[24];
+	for (int j = 0; j < 24; ++j)
+	{
+		pl[j] = _mm_set1_ps(p[j]);
+	}
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	size_t count = 0;
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+		const __m128 nr = _mm_xor_ps(_mm_loadu_ps(r + i), sign);
+		__m128 inside = _mm_cmpeq_ps(vx, vx);
+		for (int j = 0; j < 24; j += 4)
+		{
+			__m128 d = _mm_add_ps(_mm_mul_ps(pl[j], vx), pl[j + 3]);
+			d = _mm_add_ps(d, _mm_mul_ps(pl[j + 1], vy));
+			d = _mm_add_ps(d, _mm_mul_ps(pl[j + 2], vz));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, nr));
+		}
+		const int bits = _mm_movemask_ps(inside);
+		for (int k = 0; k < 4; ++k)
+		{
+			visible[i + k] = static_cast<unsigned char>((bits >> k) & 1);
+			count += (bits >> k) & 1;
+		}
+	}
+	return count + batch_cull_spheres_scalar(p, x + i, y + i, z + i, r + i, visible + i, n - i);
+}
+inline __m128 batch_cross_sse2(__m128 a, __m128 b)
+{
+	// w = a.w * b.w - a.w * b.w
+	const __m128 a0 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 b0 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+	const __m128 a1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+	const __m128 b1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	return _mm_sub_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1));
+}
+// 長さを全要素に
+inline __m128 batch_length_sse2(__m128 v)
+{
+	v = _mm_mul_ps(v, v);
+	v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_sqrt_ps(v);
+}
+inline void batch_normal_matrix_sse2(const float* src, float* dst, size_t n, int exact)
+{
+	// wを0にするマスク(平行移動や射影の列を除く)
+	const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 eps = _mm_set1_ps(math_traits<float>::epsilon);
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (size_t i = 0; i < n; ++i, src += 16, dst += 12)
+	{
+		const __m128 r0 = _mm_and_ps(_mm_loadu_ps(src), xyz);
+		const __m128 r1 = _mm_and_ps(_mm_loadu_ps(src + 4), xyz);
+		const __m128 r2 = _mm_and_ps(_mm_loadu_ps(src + 8), xyz);
+		__m128 c0 = batch_cross_sse2(r1, r2);
+		__m128 c1 = batch_cross_sse2(r2, r0);
+		__m128 c2 = batch_cross_sse2(r0, r1);
+
+		// 行列式を全要素に
+		__m128 det = _mm_mul_ps(r0, c0);
+		det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+		det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		__m128 s;
+		if (exact != 0)
+		{
+			// 行列式が各行の長さの積に対して0に近い場合は符号のみ
+			const __m128 bound = _mm_mul_ps(_mm_mul_ps(batch_length_sse2(r0), batch_length_sse2(r1)), batch_length_sse2(r2));
+			const __m128 valid = _mm_cmpgt_ps(_mm_andnot_ps(sign, det), _mm_mul_ps(eps, bound));
+			s = _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(one, det)), _mm_andnot_ps(valid, _mm_or_ps(one, _mm_and_ps(det, sign))));
+		}
+		else
+		{
+			s = _mm_or_ps(one, _mm_and_ps(det, sign));
+		}
+		_mm_storeu_ps(dst, _mm_mul_ps(c0, s));
+		_mm_storeu_ps(dst + 4, _mm_mul_ps(c1, s));
+		_mm_storeu_ps(dst + 8, _mm_mul_ps(c2, s));
+	}
+}
+#endif // POCKET_USE_SIMD_128
+
+#ifdef __POCKET_MATH_BATCH_AVX2
+//---------------------------------------------------------------------
+// AVX2+FMA. 行列変換は256bitに2つのベクトルを並べて計算する
+//---------------------------------------------------------------------
+POCKET_SIMD_TARGET("avx2,fma")
+inline void batch_transform_avx2(const float* m, const float* src, float* dst, size_t n)
+{
+	const __m128 r0 = _mm_loadu_ps(m);
+	const __m128 r1 = _mm_loadu_ps(m + 4);
+	const __m128 r2 = _mm_loadu_ps(m + 8);
+	const __m128 r3 = _mm_loadu_ps(m + 12);
+	const __m256 rr0 = _mm256_insertf128_ps(_mm256_castps128_ps256(r0), r0, 1);
+	const __m256 rr1 = _mm256_insertf128_ps(_mm256_castps128_ps256(r1), r1, 1);
+	const __m256 rr2 = _mm256_insertf128_ps(_mm256_castps128_ps256(r2), r2, 1);
+	const __m256 rr3 = _mm256_insertf128_ps(_mm256_castps128_ps256(r3), r3, 1);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2, src += 8, dst += 8)
+	{
+		const __m256 v = _mm256_loadu_ps(src);
+		__m256 r = _mm256_mul_ps(rr0, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm256_fmadd_ps(rr1, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1)), r);
+		r = _mm256_fmadd_ps(rr2, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)), r);
+		r = _mm256_fmadd_ps(rr3, _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)), r);
+		_mm256_storeu_ps(dst, r);
+	}
+	if (i < n)
+	{
+		const __m128 v = _mm_loadu_ps(src);
+		__m128 r = _mm_mul_ps(r0, _mm_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm_fmadd_ps(r1, _mm_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1)), r);
+		r = _mm_fmadd_ps(r2, _mm_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)), r);
+		r = _mm_fmadd_ps(r3, _mm_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)), r);
+		_mm_storeu_ps(dst, r);
+	}
+}
+POCKET_SIMD_TARGET("avx2,fma")
+inline void batch_mad_avx2(const float* a, const float* b, const float* c, float* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), _mm256_loadu_ps(c + i)));
+	}
+	batch_mad_scalar(a + i, b + i, c + i, dst + i, n - i);
+}
+POCKET_SIMD_TARGET("avx2,fma")
+inline void batch_dot_avx2(const float* ax, const float* ay, const float* az, const float* bx, const float* by, const float* bz, float* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 r = _mm256_mul_ps(_mm256_loadu_ps(ax + i), _mm256_loadu_ps(bx + i));
+		r = _mm256_fmadd_ps(_mm256_loadu_ps(ay + i), _mm256_loadu_ps(by + i), r);
+		r = _mm256_fmadd_ps(_mm256_loadu_ps(az + i), _mm256_loadu_ps(bz + i), r);
+		_mm256_storeu_ps(dst + i, r);
+	}
+	batch_dot_scalar(ax + i, ay + i, az + i, bx + i, by + i, bz + i, dst + i, n - i);
+}
+POCKET_SIMD_TARGET("avx2,fma")
+inline void batch_length_avx2(const float* x, const float* y, const float* z, float* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+		const __m256 len = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+		_mm256_storeu_ps(dst + i, _mm256_sqrt_ps(len));
+	}
+	batch_length_scalar(x + i, y + i, z + i, dst + i, n - i);
+}
+POCKET_SIMD_TARGET("avx2,fma")
+inline void batch_normalize_avx2(float* x, float* y, float* z, size_t n)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+		const __m256 len = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+		const __m256 valid = _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ);
+		const __m256 r = _mm256_blendv_ps(one, _mm256_div_ps(one, _mm256_sqrt_ps(len)), valid);
+		_mm256_storeu_ps(x + i, _mm256_mul_ps(vx, r));
+		_mm256_storeu_ps(y + i, _mm256_mul_ps(vy, r));
+		_mm256_storeu_ps(z + i, _mm256_mul_ps(vz, r));
+	}
+	batch_normalize_scalar(x + i, y + i, z + i, n - i);
+}
+POCKET_SIMD_TARGET("avx2,fma")
+inline size_t batch_cull_spheres_avx2(const float* p, const float* x, const float* y, const float* z, const float* r, unsigned char* visible, size_t n)
+{
+	__m256 pl[24];
+	for (int j = 0; j < 24; ++j)
+	{
+		pl[j] = _mm256_set1_ps(p[j]);
+	}
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	size_t count = 0;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+		const __m256 nr = _mm256_xor_ps(_mm256_loadu_ps(r + i), sign);
+		__m256 inside = _mm256_cmp_ps(vx, vx, _CMP_EQ_OQ);
+		for (int j = 0; j < 24; j += 4)
+		{
+			__m256 d = _mm256_fmadd_ps(pl[j], vx, pl[j + 3]);
+			d = _mm256_fmadd_ps(pl[j + 1], vy, d);
+			d = _mm256_fmadd_ps(pl[j + 2], vz, d);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, nr, _CMP_GE_OQ));
+		}
+		const int bits = _mm256_movemask_ps(inside);
+		for (int k = 0; k < 8; ++k)
+		{
+			visible[i + k] = static_cast<unsigned char>((bits >> k) & 1);
+			count += (bits >> k) & 1;
+		}
+	}
+	return count + batch_cull_spheres_scalar(p, x + i, y + i, z + i, r + i, visible + i, n - i);
+}
+#endif // __POCKET_MATH_BATCH_AVX2
+
+#ifdef __POCKET_MATH_BATCH_AVX512
+//---------------------------------------------------------------------
+// AVX-512. 端数はマスク付きの読み書きで処理する
+// 行列変換は512bitに4つのベクトルを並べて計算する
+// マスクなしの組み込み関数は未初期化のレジスタを元にするためGCCが警告を出すので,
+// maskz_で全要素のマスクを指定する(マスクがすべて1なら同じ命令になる)
+//---------------------------------------------------------------------
+POCKET_SIMD_TARGET("avx512f,avx512dq,avx512vl,avx2,fma")
+inline __mmask16 batch_tail_mask_avx512(size_t n)
+{
+	return static_cast<__mmask16>((1u << n) - 1u);
+}
+POCKET_SIMD_TARGET("avx512f,avx512dq,avx512vl,avx2,fma")
+inline void batch_transform_avx512(const float* m, const float* src, float* dst, size_t n)
+{
+	const __mmask16 all = static_cast<__mmask16>(0xFFFF);
+	const __m512 r0 = _mm512_maskz_broadcast_f32x4(all, _mm_loadu_ps(m));
+	const __m512 r1 = _mm512_maskz_broadcast_f32x4(all, _mm_loadu_ps(m + 4));
+	const __m512 r2 = _mm512_maskz_broadcast_f32x4(all, _mm_loadu_ps(m + 8));
+	const __m512 r3 = _mm512_maskz_broadcast_f32x4(all, _mm_loadu_ps(m + 12));
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4, src += 16, dst += 16)
+	{
+		const __m512 v = _mm512_loadu_ps(src);
+		__m512 r = _mm512_mul_ps(r0, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm512_fmadd_ps(r1, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(1, 1, 1, 1)), r);
+		r = _mm512_fmadd_ps(r2, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(2, 2, 2, 2)), r);
+		r = _mm512_fmadd_ps(r3, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(3, 3, 3, 3)), r);
+		_mm512_storeu_ps(dst, r);
+	}
+	if (i < n)
+	{
+		const __mmask16 k = batch_tail_mask_avx512((n - i) * 4);
+		const __m512 v = _mm512_maskz_loadu_ps(k, src);
+		__m512 r = _mm512_mul_ps(r0, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm512_fmadd_ps(r1, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(1, 1, 1, 1)), r);
+		r = _mm512_fmadd_ps(r2, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(2, 2, 2, 2)), r);
+		r = _mm512_fmadd_ps(r3, _mm512_maskz_permute_ps(all, v, _MM_SHUFFLE(3, 3, 3, 3)), r);
+		_mm512_mask_storeu_ps(dst, k, r);
+	}
+}
+POCKET_SIMD_TARGET("avx512f,avx512dq,avx512vl,avx2,fma")
+inline void batch_mad_avx512(const float* a, const float* b, const float* c, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; i += 16)
+	{
+		const __mmask16 k = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : batch_tail_mask_avx512(n - i);
+		const __m512 r = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(k, a + i), _mm512_maskz_loadu_ps(k, b + i), _mm512_maskz_loadu_ps(k, c + i));
+		_mm512_mask_storeu_ps(dst + i, k, r);
+	}
+}
+POCKET_SIMD_TARGET("avx512f,avx512dq,avx512vl,avx2,fma")
+inline void batch_dot_avx512(const float* ax, const float* ay, const float* az, const float* bx, const float* by, const float* bz, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; i += 16)
+	{
+		const __mmask16 k = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : batch_tail_mask_avx512(n - i);
+		__m512 r = _mm512_mul_ps(_mm512_maskz_loadu_ps(k, ax + i), _mm512_maskz_loadu_ps(k, bx + i));
+		r = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(k, ay + i), _mm512_maskz_loadu_ps(k, by + i), r);
+		r = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(k, az + i), _mm512_maskz_loadu_ps(k, bz + i), r);
+		_mm512_mask_storeu_ps(dst + i, k, r);
+	}
+}
+POCKET_SIMD_TARGET("avx512f,avx512dq,avx512vl,avx2,fma")
+inline void batch_length_avx512(const float* x, const float* y, const float* z, float* dst, size_t n)
+{
+	for (size_t i = 0; i < n; i += 16)
+	{
+		const __mmask16 k = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : batch_tail_mask_avx512(n - i);
+		const __m512 vx = _mm512_maskz_loadu_ps(k, x + i);
+		const __m512 vy = _mm512_maskz_loadu_ps(k, y + i);
+		const __m512 vz = _mm512_maskz_loadu_ps(k, z + i);
+		const __m512 len = _mm512_fmadd_ps(vz, vz, _mm512_fmadd_ps(vy, vy, _mm512_mul_ps(vx, vx)));
+		_mm512_mask_storeu_ps(dst + i, k, _mm512_maskz_sqrt_ps(k, len));
+	}
+}
+POCKET_SIMD_TARGET("avx512f,avx512dq,avx512vl,avx2,fma")
+inline void batch_normalize_avx512(float* x, float* y, float* z, size_t n)
+{
+	const __m512 one = _mm512_set1_ps(1.0f);
+	for (size_t i = 0; i < n; i += 16)
+	{
+		const __mmask16 k = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : batch_tail_mask_avx512(n - i);
+		const __m512 vx = _mm512_maskz_loadu_ps(k, x + i);
+		const __m512 vy = _mm512_maskz_loadu_ps(k, y + i);
+		const __m512 vz = _mm512_maskz_loadu_ps(k, z + i);
+		const __m512 len = _mm512_fmadd_ps(vz, vz, _mm512_fmadd_ps(vy, vy, _mm512_mul_ps(vx, vx)));
+		// 長さが0の要素は書き込まない
+		const __mmask16 valid = _mm512_mask_cmp_ps_mask(k, len, _mm512_setzero_ps(), _CMP_GT_OQ);
+		const __m512 r = _mm512_div_ps(one, _mm512_maskz_sqrt_ps(valid, len));
+		_mm512_mask_storeu_ps(x + i, valid, _mm512_mul_ps(vx, r));
+		_mm512_mask_storeu_ps(y + i, valid, _mm512_mul_ps(vy, r));
+		_mm512_mask_storeu_ps(z + i, valid, _mm512_mul_ps(vz, r));
+	}
+}
+POCKET_SIMD_TARGET("avx512f,avx512dq,avx512vl,avx2,fma")
+inline size_t batch_cull_spheres_avx512(const float* p, const float* x, const float* y, const float* z, const float* r, unsigned char* visible, size_t n)
+{
+	__m512 pl[24];
+	for (int j = 0; j < 24; ++j)
+	{
+		pl[j] = _mm512_set1_ps(p[j]);
+	}
+	const __m512i on = _mm512_set1_epi32(1);
+	size_t count = 0;
+	for (size_t i = 0; i < n; i += 16)
+	{
+		const __mmask16 k = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : batch_tail_mask_avx512(n - i);
+		const __m512 vx = _mm512_maskz_loadu_ps(k, x + i);
+		const __m512 vy = _mm512_maskz_loadu_ps(k, y + i);
+		const __m512 vz = _mm512_maskz_loadu_ps(k, z + i);
+		const __m512 nr = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_maskz_loadu_ps(k, r + i));
+		__mmask16 inside = k;
+		for (int j = 0; j < 24; j += 4)
+		{
+			__m512 d = _mm512_fmadd_ps(pl[j], vx, pl[j + 3]);
+			d = _mm512_fmadd_ps(pl[j + 1], vy, d);
+			d = _mm512_fmadd_ps(pl[j + 2], vz, d);
+			inside = _mm512_mask_cmp_ps_mask(inside, d, nr, _CMP_GE_OQ);
+		}
+		_mm512_mask_cvtepi32_storeu_epi8(visible + i, k, _mm512_maskz_mov_epi32(inside, on));
+		for (unsigned int bits = inside; bits != 0; bits &= bits - 1)
+		{
+			++count;
+		}
+	}
+	return count;
+}
+#endif // __POCKET_MATH_BATCH_AVX512
+
+//---------------------------------------------------------------------
+// 指定の命令セット以下で使用できるカーネルを選択する
+//---------------------------------------------------------------------
+inline batch_kernel_f make_batch_kernel_f(int type)
+{
+	batch_kernel_f k;
+	k.transform = &batch_transform_scalar;
+	k.mad = &batch_mad_scalar;
+	k.dot = &batch_dot_scalar;
+	k.length = &batch_length_scalar;
+	k.normalize = &batch_normalize_scalar;
+	k.cull_spheres = &batch_cull_spheres_scalar;
+	k.normal_matrix = &batch_normal_matrix_scalar;
+	k.simd_type = -1;
+#ifdef POCKET_USE_SIMD_128
+	// SSE3, SSE4はこれらの処理で有効な命令がないためSSE2と共通
+	if (type >= POCKET_SIMD_TYPE_SSE2)
+	{
+		k.transform = &batch_transform_sse2;
+		k.mad = &batch_mad_sse2;
+		k.dot = &batch_dot_sse2;
+		k.length = &batch_length_sse2;
+		k.normalize = &batch_normalize_sse2;
+		k.cull_spheres = &batch_cull_spheres_sse2;
+		k.normal_matrix = &batch_normal_matrix_sse2;
+		k.simd_type = POCKET_SIMD_TYPE_SSE2;
+	}
+#endif // POCKET_USE_SIMD_128
+#ifdef __POCKET_MATH_BATCH_AVX2
+	if (type >= POCKET_SIMD_TYPE_AVX2 && cpu_feature::get().fma)
+	{
+		k.transform = &batch_transform_avx2;
+		k.mad = &batch_mad_avx2;
+		k.dot = &batch_dot_avx2;
+		k.length = &batch_length_avx2;
+		k.normalize = &batch_normalize_avx2;
+		k.cull_spheres = &batch_cull_spheres_avx2;
+		k.simd_type = POCKET_SIMD_TYPE_AVX2;
+	}
+#endif // __POCKET_MATH_BATCH_AVX2
+#ifdef __POCKET_MATH_BATCH_AVX512
+	if (type >= POCKET_SIMD_TYPE_AVX512)
+	{
+		k.transform = &batch_transform_avx512;
+		k.mad = &batch_mad_avx512;
+		k.dot = &batch_dot_avx512;
+		k.length = &batch_length_avx512;
+		k.normalize = &batch_normalize_avx512;
+		k.cull_spheres = &batch_cull_spheres_avx512;
+		k.simd_type = POCKET_SIMD_TYPE_AVX512;
+	}
+#endif // __POCKET_MATH_BATCH_AVX512
+	(void)type;
+	return k;
+}
+
+//---------------------------------------------------------------------
+// 使用中のカーネル. 初回呼び出し時にCPUIDから選択する
+// 実行時判定が使用できない場合はPOCKET_USE_SIMD_TYPEを上限とする
+//---------------------------------------------------------------------
+inline int batch_kernel_limit_f()
+{
+	const int support = cpu_feature::get().simd_type;
+#if defined(POCKET_USE_SIMD) && !defined(POCKET_USE_SIMD_DISPATCH)
+	return support < POCKET_USE_SIMD_TYPE ? support : POCKET_USE_SIMD_TYPE;
+#else
+	return support;
+#endif
+}
+inline batch_kernel_f& batch_kernel()
+{
+	static batch_kernel_f kernel = make_batch_kernel_f(batch_kernel_limit_f());
+	return kernel;
+}
+}
+
+//---------------------------------------------------------------------
+// 汎用
+//---------------------------------------------------------------------
+template <typename T>
+struct batch_traits
+{
+	//---------------------------------------------------------------------------------------
+	// Types
+	//---------------------------------------------------------------------------------------
+
+	typedef T value_type;
+	typedef math_traits<T> math_type;
+
+	//---------------------------------------------------------------------------------------
+	// Functions
+	//---------------------------------------------------------------------------------------
+
+	//---------------------------------------------------------------------
+	// dst[i] = m.transform(src[i]), srcとdstは同じでもよい
+	//---------------------------------------------------------------------
+	static void transform(const matrix4x4<T>& m, const vector4<T>* src, vector4<T>* dst, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			const vector4<T> v = src[i];
+			m.transform(v, dst[i]);
+		}
+	}
+	//---------------------------------------------------------------------
+	// dst[i] = a[i] * b[i] + c[i]
+	//---------------------------------------------------------------------
+	static void mad(const T* a, const T* b, const T* c, T* dst, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			dst[i] = a[i] * b[i] + c[i];
+		}
+	}
+	//---------------------------------------------------------------------
+	// dst[i] = (ax, ay, az)[i].dot((bx, by, bz)[i])
+	//---------------------------------------------------------------------
+	static void dot(const T* ax, const T* ay, const T* az, const T* bx, const T* by, const T* bz, T* dst, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			dst[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+		}
+	}
+	//---------------------------------------------------------------------
+	// dst[i] = (x, y, z)[i].length()
+	//---------------------------------------------------------------------
+	static void length(const T* x, const T* y, const T* z, T* dst, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			dst[i] = math_type::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+		}
+	}
+	//---------------------------------------------------------------------
+	// (x, y, z)[i].normalize(), 長さが0の要素はそのまま
+	//---------------------------------------------------------------------
+	static void normalize(T* x, T* y, T* z, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			const T len = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+			if (len > math_type::zero)
+			{
+				const T r = math_type::one / math_type::sqrt(len);
+				x[i] *= r;
+				y[i] *= r;
+				z[i] *= r;
+			}
+		}
+	}
+	//---------------------------------------------------------------------
+	// visible[i] = f.inside_sphere((x, y, z)[i], r[i]), 中にある数を返す
+	//---------------------------------------------------------------------
+	static size_t cull_spheres(const frustum<T>& f, const T* x, const T* y, const T* z, const T* r, unsigned char* visible, size_t n)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			const bool inside = f.inside_sphere(vector3<T>(x[i], y[i], z[i]), r[i]);
+			visible[i] = inside ? 1 : 0;
+			count += inside ? 1 : 0;
+		}
+		return count;
+	}
+	//---------------------------------------------------------------------
+	// dst[i * 3 + 0～2] = matrix3x3().normal_matrix_from(src[i], exact)の各行(w = 0)
+	// 3つのvector4に詰めるためGLSLのstd140/std430のmat3と同じ配置になる
+	//---------------------------------------------------------------------
+	static void normal_matrix(const matrix4x4<T>* src, vector4<T>* dst, size_t n, bool exact = false)
+	{
+		matrix3x3<T> r(call::noinitialize);
+		for (size_t i = 0; i < n; ++i, dst += 3)
+		{
+			r.normal_matrix_from(src[i], exact);
+			dst[0] = vector4<T>(r.M[0], math_type::zero);
+			dst[1] = vector4<T>(r.M[1], math_type::zero);
+			dst[2] = vector4<T>(r.M[2], math_type::zero);
+		}
+	}
+
+	//---------------------------------------------------------------------
+	// 使用しているPOCKET_SIMD_TYPE_XXX
+	//---------------------------------------------------------------------
+	static int dispatch_type()
+	{
+		return -1;
+	}
+	static int select(int)
+	{
+		return -1;
+	}
+};
+
+//---------------------------------------------------------------------
+// float
+//---------------------------------------------------------------------
+template <>
+struct batch_traits<float>
+{
+	//---------------------------------------------------------------------------------------
+	// Types
+	//---------------------------------------------------------------------------------------
+
+	typedef float value_type;
+	typedef math_traits<float> math_type;
+
+	//---------------------------------------------------------------------------------------
+	// Functions
+	//---------------------------------------------------------------------------------------
+
+	//---------------------------------------------------------------------
+	// dst[i] = m.transform(src[i]), srcとdstは同じでもよい
+	//---------------------------------------------------------------------
+	static void transform(const matrix4x4<float>& m, const vector4<float>* src, vector4<float>* dst, size_t n)
+	{
+		POCKET_STATICAL_ASSERT(sizeof(vector4<float>) == sizeof(float) * 4, vector4_must_be_packed);
+
+		POCKET_ALIGNED(16) float rows[16];
+		for (int r = 0; r < 4; ++r)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				rows[r * 4 + c] = m.M[r][c];
+			}
+		}
+		if (n > 0)
+		{
+			detail::batch_kernel().transform(rows, &src[0].x, &dst[0].x, n);
+		}
+	}
+	//---------------------------------------------------------------------
+	// dst[i] = a[i] * b[i] + c[i]
+	// FMAが使用される場合は丸めが一度になる
+	//---------------------------------------------------------------------
+	static void mad(const float* a, const float* b, const float* c, float* dst, size_t n)
+	{
+		detail::batch_kernel().mad(a, b, c, dst, n);
+	}
+	//---------------------------------------------------------------------
+	// dst[i] = (ax, ay, az)[i].dot((bx, by, bz)[i])
+	//---------------------------------------------------------------------
+	static void dot(const float* ax, const float* ay, const float* az, const float* bx, const float* by, const float* bz, float* dst, size_t n)
+	{
+		detail::batch_kernel().dot(ax, ay, az, bx, by, bz, dst, n);
+	}
+	//---------------------------------------------------------------------
+	// dst[i] = (x, y, z)[i].length()
+	//---------------------------------------------------------------------
+	static void length(const float* x, const float* y, const float* z, float* dst, size_t n)
+	{
+		detail::batch_kernel().length(x, y, z, dst, n);
+	}
+	//---------------------------------------------------------------------
+	// (x, y, z)[i].normalize(), 長さが0の要素はそのまま
+	//---------------------------------------------------------------------
+	static void normalize(float* x, float* y, float* z, size_t n)
+	{
+		detail::batch_kernel().normalize(x, y, z, n);
+	}
+	//---------------------------------------------------------------------
+	// visible[i] = f.inside_sphere((x, y, z)[i], r[i]), 中にある数を返す
+	//---------------------------------------------------------------------
+	static size_t cull_spheres(const frustum<float>& f, const float* x, const float* y, const float* z, const float* r, unsigned char* visible, size_t n)
+	{
+		float p[24];
+		for (int i = 0; i < 6; ++i)
+		{
+			const plane<float>& pl = f.planes[i];
+			p[i * 4 + 0] = pl.a;
+			p[i * 4 + 1] = pl.b;
+			p[i * 4 + 2] = pl.c;
+			p[i * 4 + 3] = pl.d;
+		}
+		return detail::batch_kernel().cull_spheres(p, x, y, z, r, visible, n);
+	}
+	//---------------------------------------------------------------------
+	// dst[i * 3 + 0～2] = matrix3x3().normal_matrix_from(src[i], exact)の各行(w = 0)
+	// 3つのvector4に詰めるためGLSLのstd140/std430のmat3と同じ配置になる
+	// srcとdstは重ならないこと
+	//---------------------------------------------------------------------
+	static void normal_matrix(const matrix4x4<float>* src, vector4<float>* dst, size_t n, bool exact = false)
+	{
+		POCKET_STATICAL_ASSERT(sizeof(matrix4x4<float>) == sizeof(float) * 16, matrix4x4_must_be_packed);
+		POCKET_STATICAL_ASSERT(sizeof(vector4<float>) == sizeof(float) * 4, vector4_must_be_packed);
+
+		if (n > 0)
+		{
+			detail::batch_kernel().normal_matrix(&src[0].M[0].x, &dst[0].x, n, exact ? 1 : 0);
+		}
+	}
+
+	//---------------------------------------------------------------------
+	// 使用しているPOCKET_SIMD_TYPE_XXX, SIMDを使用していない場合は-1
+	//---------------------------------------------------------------------
+	static int dispatch_type()
+	{
+		return detail::batch_kernel().simd_type;
+	}
+	//---------------------------------------------------------------------
+	// 使用する命令セットの上限を指定する(計測用)
+	// CPUが対応している範囲に制限され, 実際に選択されたPOCKET_SIMD_TYPE_XXXを返す
+	// 他のスレッドで処理中に呼び出さないこと
+	//---------------------------------------------------------------------
+	static int select(int type)
+	{
+		const int limit = detail::batch_kernel_limit_f();
+		detail::batch_kernel() = detail::make_batch_kernel_f(type < limit ? type : limit);
+		return dispatch_type();
+	}
+};
+
+} // namespace math
+} // namespace pocket
+
+#endif // __POCKET_MATH_BATCH_H__
@@ -0,0 +1,521 @@
+﻿#ifndef __POCKET_MATH_EXPRESSION_H__
+#define __POCKET_MATH_EXPRESSION_H__
+
+#include "../config.h"
+#ifdef POCKET_USE_PRAGMA_ONCE
+#pragma once
+#endif // POCKET_USE_PRAGMA_ONCE
+
+#include "../call.h"
+#include "../type_traits.h"
+#include "math_traits.h"
+#include "simd_traits.h"
+#include "vector4.h"
+#include "matrix4x4.h"
+
+namespace pocket
+{
+namespace math
+{
+
+//---------------------------------------------------------------------------------------
+// vector4の式テンプレート
+// lazy()で包んだ値から始まる式は代入されるまで評価されず, 一度の走査で計算される
+// 乗算と加減算の組み合わせはsimd_traits::madにまとめられる
+//
+// vector4f r = lazy(a) * s + lazy(b) * t - c;
+//
+// 式は参照を保持するので式のまま変数に保存しないこと
+//---------------------------------------------------------------------------------------
+
+template <typename> struct vector4_expression;
+template <typename> struct vector4_term;
+template <typename> struct vector4_scalar;
+template <typename, typename, typename> struct vector4_binary;
+template <typename> struct matrix4x4_expression;
+template <typename> struct matrix4x4_term;
+template <typename> struct matrix4x4_scalar;
+template <typename, typename, typename> struct matrix4x4_binary;
+
+namespace detail
+{
+//---------------------------------------------------------------------
+// SIMDで評価できる型か
+//---------------------------------------------------------------------
+template <typename T>
+struct vector4_expression_vectorize : type_traits::false_type
+{};
+#ifdef POCKET_USE_SIMD_ANONYMOUS
+template <>
+struct vector4_expression_vectorize<float> : type_traits::true_type
+{};
+#endif // POCKET_USE_SIMD_ANONYMOUS
+
+//---------------------------------------------------------------------
+// 要素ごとの演算
+//---------------------------------------------------------------------
+template <typename OP>
+struct vector4_operate;
+
+template <>
+struct vector4_operate<call::add_t>
+{
+	template <typename T>
+	static POCKET_INLINE_FORCE T apply(T a, T b)
+	{
+		return a + b;
+	}
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type apply_simd(typename S::type a, typename S::type b)
+	{
+		return S::add(a, b);
+	}
+};
+template <>
+struct vector4_operate<call::sub_t>
+{
+	template <typename T>
+	static POCKET_INLINE_FORCE T apply(T a, T b)
+	{
+		return a - b;
+	}
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type apply_simd(typename S::type a, typename S::type b)
+	{
+		return S::sub(a, b);
+	}
+};
+template <>
+struct vector4_operate<call::mul_t>
+{
+	template <typename T>
+	static POCKET_INLINE_FORCE T apply(T a, T b)
+	{
+		return a * b;
+	}
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type apply_simd(typename S::type a, typename S::type b)
+	{
+		return S::mul(a, b);
+	}
+};
+template <>
+struct vector4_operate<call::div_t>
+{
+	template <typename T>
+	static POCKET_INLINE_FORCE T apply(T a, T b)
+	{
+		return a / b;
+	}
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type apply_simd(typename S::type a, typename S::type b)
+	{
+		return S::div(a, b);
+	}
+};
+
+//---------------------------------------------------------------------
+// SIMDでの評価. 乗算を含む加減算はmadにまとめる
+//---------------------------------------------------------------------
+template <typename OP, typename L, typename R>
+struct vector4_evaluate
+{
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type eval(const L& l, const R& r)
+	{
+		return vector4_operate<OP>::template apply_simd<S>(l.template eval<S>(), r.template eval<S>());
+	}
+};
+// (a * b) + c
+template <typename A, typename B, typename R>
+struct vector4_evaluate<call::add_t, vector4_binary<call::mul_t, A, B>, R>
+{
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type eval(const vector4_binary<call::mul_t, A, B>& l, const R& r)
+	{
+		return S::mad(l.l.template eval<S>(), l.r.template eval<S>(), r.template eval<S>());
+	}
+};
+// c + (a * b)
+template <typename L, typename A, typename B>
+struct vector4_evaluate<call::add_t, L, vector4_binary<call::mul_t, A, B> >
+{
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type eval(const L& l, const vector4_binary<call::mul_t, A, B>& r)
+	{
+		return S::mad(r.l.template eval<S>(), r.r.template eval<S>(), l.template eval<S>());
+	}
+};
+// (a * b) + (c * d)
+template <typename A, typename B, typename C, typename D>
+struct vector4_evaluate<call::add_t, vector4_binary<call::mul_t, A, B>, vector4_binary<call::mul_t, C, D> >
+{
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type eval(const vector4_binary<call::mul_t, A, B>& l, const vector4_binary<call::mul_t, C, D>& r)
+	{
+		return S::mad(l.l.template eval<S>(), l.r.template eval<S>(), S::mul(r.l.template eval<S>(), r.r.template eval<S>()));
+	}
+};
+// (a * b) - c
+template <typename A, typename B, typename R>
+struct vector4_evaluate<call::sub_t, vector4_binary<call::mul_t, A, B>, R>
+{
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type eval(const vector4_binary<call::mul_t, A, B>& l, const R& r)
+	{
+		return S::mad(l.l.template eval<S>(), l.r.template eval<S>(), S::negate(r.template eval<S>()));
+	}
+};
+// c - (a * b)
+template <typename L, typename A, typename B>
+struct vector4_evaluate<call::sub_t, L, vector4_binary<call::mul_t, A, B> >
+{
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type eval(const L& l, const vector4_binary<call::mul_t, A, B>& r)
+	{
+		return S::mad(S::negate(r.l.template eval<S>()), r.r.template eval<S>(), l.template eval<S>());
+	}
+};
+// (a * b) - (c * d)
+template <typename A, typename B, typename C, typename D>
+struct vector4_evaluate<call::sub_t, vector4_binary<call::mul_t, A, B>, vector4_binary<call::mul_t, C, D> >
+{
+	template <typename S>
+	static POCKET_INLINE_FORCE typename S::type eval(const vector4_binary<call::mul_t, A, B>& l, const vector4_binary<call::mul_t, C, D>& r)
+	{
+		return S::mad(l.l.template eval<S>(), l.r.template eval<S>(), S::negate(S::mul(r.l.template eval<S>(), r.r.template eval<S>())));
+	}
+};
+}
+
+//---------------------------------------------------------------------
+// 式の基底. vector4へ変換する際に評価される
+//---------------------------------------------------------------------
+template <typename E>
+struct vector4_expression
+{
+	//-----------------------------------------------------------------------------------------
+	// Functions
+	//-----------------------------------------------------------------------------------------
+
+	POCKET_INLINE_FORCE const E& derived() const
+	{
+		return static_cast<const E&>(*this);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Operators
+	//-----------------------------------------------------------------------------------------
+
+	template <typename T>
+	operator vector4<T> () const
+	{
+		return evaluate<T>(detail::vector4_expression_vectorize<T>());
+	}
+
+private:
+#ifdef POCKET_USE_SIMD_ANONYMOUS
+	template <typename T>
+	vector4<T> evaluate(const type_traits::true_type&) const
+	{
+		return vector4<T>(derived().template eval<simd_traits<T> >());
+	}
+#endif // POCKET_USE_SIMD_ANONYMOUS
+	template <typename T>
+	vector4<T> evaluate(const type_traits::false_type&) const
+	{
+		const E& e = derived();
+		return vector4<T>(e.at(0), e.at(1), e.at(2), e.at(3));
+	}
+};
+
+//---------------------------------------------------------------------
+// 葉(vector4の参照)
+//---------------------------------------------------------------------
+template <typename T>
+struct vector4_term : vector4_expression<vector4_term<T> >
+{
+	typedef T value_type;
+
+	const vector4<T>& v;
+
+	explicit vector4_term(const vector4<T>& v) :
+		v(v)
+	{}
+
+	POCKET_INLINE_FORCE T at(int i) const
+	{
+		return v[i];
+	}
+#ifdef POCKET_USE_SIMD_ANONYMOUS
+	template <typename S>
+	POCKET_INLINE_FORCE typename S::type eval() const
+	{
+		return v.mm;
+	}
+#endif // POCKET_USE_SIMD_ANONYMOUS
+};
+
+//---------------------------------------------------------------------
+// 葉(スカラー)
+//---------------------------------------------------------------------
+template <typename T>
+struct vector4_scalar : vector4_expression<vector4_scalar<T> >
+{
+	typedef T value_type;
+
+	T f;
+
+	explicit vector4_scalar(T f) :
+		f(f)
+	{}
+
+	POCKET_INLINE_FORCE T at(int) const
+	{
+		return f;
+	}
+	template <typename S>
+	POCKET_INLINE_FORCE typename S::type eval() const
+	{
+		return S::set(f);
+	}
+};
+
+//---------------------------------------------------------------------
+// 二項演算
+//---------------------------------------------------------------------
+template <typename OP, typename L, typename R>
+struct vector4_binary : vector4_expression<vector4_binary<OP, L, R> >
+{
+	typedef typename L::value_type value_type;
+
+	L l;
+	R r;
+
+	vector4_binary(const L& l, const R& r) :
+		l(l), r(r)
+	{}
+
+	POCKET_INLINE_FORCE value_type at(int i) const
+	{
+		return detail::vector4_operate<OP>::apply(l.at(i), r.at(i));
+	}
+	template <typename S>
+	POCKET_INLINE_FORCE typename S::type eval() const
+	{
+		return detail::vector4_evaluate<OP, L, R>::template eval<S>(l, r);
+	}
+};
+
+//---------------------------------------------------------------------
+// 式を開始する
+//---------------------------------------------------------------------
+template <typename T> inline
+vector4_term<T> lazy(const vector4<T>& v)
+{
+	return vector4_term<T>(v);
+}
+
+// 式同士, 式とvector4, 式とスカラーの演算子
+
+#ifndef __POCKET_MATH_EXPRESSION_OPERATOR
+#	define __POCKET_MATH_EXPRESSION_OPERATOR(OP, TAG) \
+	template <typename L, typename R> inline \
+	vector4_binary<TAG, L, R> operator OP (const vector4_expression<L>& l, const vector4_expression<R>& r) \
+	{ \
+		return vector4_binary<TAG, L, R>(l.derived(), r.derived()); \
+	} \
+	template <typename L> inline \
+	vector4_binary<TAG, L, vector4_term<typename L::value_type> > operator OP (const vector4_expression<L>& l, const vector4<typename L::value_type>& r) \
+	{ \
+		return vector4_binary<TAG, L, vector4_term<typename L::value_type> >(l.derived(), vector4_term<typename L::value_type>(r)); \
+	} \
+	template <typename R> inline \
+	vector4_binary<TAG, vector4_term<typename R::value_type>, R> operator OP (const vector4<typename R::value_type>& l, const vector4_expression<R>& r) \
+	{ \
+		return vector4_binary<TAG, vector4_term<typename R::value_type>, R>(vector4_term<typename R::value_type>(l), r.derived()); \
+	}
+#endif // __POCKET_MATH_EXPRESSION_OPERATOR
+
+__POCKET_MATH_EXPRESSION_OPERATOR(+, call::add_t)
+__POCKET_MATH_EXPRESSION_OPERATOR(-, call::sub_t)
+__POCKET_MATH_EXPRESSION_OPERATOR(*, call::mul_t)
+__POCKET_MATH_EXPRESSION_OPERATOR(/, call::div_t)
+
+#undef __POCKET_MATH_EXPRESSION_OPERATOR
+
+template <typename L> inline
+vector4_binary<call::mul_t, L, vector4_scalar<typename L::value_type> > operator * (const vector4_expression<L>& l, typename L::value_type f)
+{
+	return vector4_binary<call::mul_t, L, vector4_scalar<typename L::value_type> >(l.derived(), vector4_scalar<typename L::value_type>(f));
+}
+template <typename R> inline
+vector4_binary<call::mul_t, vector4_scalar<typename R::value_type>, R> operator * (typename R::value_type f, const vector4_expression<R>& r)
+{
+	return vector4_binary<call::mul_t, vector4_scalar<typename R::value_type>, R>(vector4_scalar<typename R::value_type>(f), r.derived());
+}
+template <typename L> inline
+vector4_binary<call::div_t, L, vector4_scalar<typename L::value_type> > operator / (const vector4_expression<L>& l, typename L::value_type f)
+{
+	return vector4_binary<call::div_t, L, vector4_scalar<typename L::value_type> >(l.derived(), vector4_scalar<typename L::value_type>(f));
+}
+
+//---------------------------------------------------------------------------------------
+// matrix4x4の式テンプレート
+// 各行をvector4の式として評価するため, 行ごとにvector4と同じくmadにまとめられる
+// 行列同士の加減算とスカラーの乗除算のみ(行列の積は要素ごとの演算ではないため対象外)
+//
+// matrix4x4f r = lazy(a) * s + lazy(b) * t - c;
+//
+// 式は参照を保持するので式のまま変数に保存しないこと
+//---------------------------------------------------------------------------------------
+
+//---------------------------------------------------------------------
+// 式の基底. matrix4x4へ変換する際に行ごとに評価される
+//---------------------------------------------------------------------
+template <typename E>
+struct matrix4x4_expression
+{
+	//-----------------------------------------------------------------------------------------
+	// Functions
+	//-----------------------------------------------------------------------------------------
+
+	POCKET_INLINE_FORCE const E& derived() const
+	{
+		return static_cast<const E&>(*this);
+	}
+
+	//-----------------------------------------------------------------------------------------
+	// Operators
+	//-----------------------------------------------------------------------------------------
+
+	template <typename T>
+	operator matrix4x4<T> () const
+	{
+		const E& e = derived();
+		return matrix4x4<T>(static_cast<vector4<T> >(e.row(0)),
+			static_cast<vector4<T> >(e.row(1)),
+			static_cast<vector4<T> >(e.row(2)),
+			static_cast<vector4<T> >(e.row(3)));
+	}
+};
+
+//---------------------------------------------------------------------
+// 葉(matrix4x4の参照)
+//---------------------------------------------------------------------
+template <typename T>
+struct matrix4x4_term : matrix4x4_expression<matrix4x4_term<T> >
+{
+	typedef T value_type;
+	typedef vector4_term<T> row_type;
+
+	const matrix4x4<T>& m;
+
+	explicit matrix4x4_term(const matrix4x4<T>& m) :
+		m(m)
+	{}
+
+	POCKET_INLINE_FORCE row_type row(int i) const
+	{
+		return row_type(m.M[i]);
+	}
+};
+
+//---------------------------------------------------------------------
+// 葉(スカラー)
+//---------------------------------------------------------------------
+template <typename T>
+struct matrix4x4_scalar : matrix4x4_expression<matrix4x4_scalar<T> >
+{
+	typedef T value_type;
+	typedef vector4_scalar<T> row_type;
+
+	T f;
+
+	explicit matrix4x4_scalar(T f) :
+		f(f)
+	{}
+
+	POCKET_INLINE_FORCE row_type row(int) const
+	{
+		return row_type(f);
+	}
+};
+
+//---------------------------------------------------------------------
+// 二項演算. 行はvector4の二項演算になる
+//---------------------------------------------------------------------
+template <typename OP, typename L, typename R>
+struct matrix4x4_binary : matrix4x4_expression<matrix4x4_binary<OP, L, R> >
+{
+	typedef typename L::value_type value_type;
+	typedef vector4_binary<OP, typename L::row_type, typename R::row_type> row_type;
+
+	L l;
+	R r;
+
+	matrix4x4_binary(const L& l, const R& r) :
+		l(l), r(r)
+	{}
+
+	POCKET_INLINE_FORCE row_type row(int i) const
+	{
+		return row_type(l.row(i), r.row(i));
+	}
+};
+
+//---------------------------------------------------------------------
+// 式を開始する
+//---------------------------------------------------------------------
+template <typename T> inline
+matrix4x4_term<T> lazy(const matrix4x4<T>& m)
+{
+	return matrix4x4_term<T>(m);
+}
+
+// 式同士, 式とmatrix4x4の加減算
+
+#ifndef __POCKET_MATH_EXPRESSION_OPERATOR
+#	define __POCKET_MATH_EXPRESSION_OPERATOR(OP, TAG) \
+	template <typename L, typename R> inline \
+	matrix4x4_binary<TAG, L, R> operator OP (const matrix4x4_expression<L>& l, const matrix4x4_expression<R>& r) \
+	{ \
+		return matrix4x4_binary<TAG, L, R>(l.derived(), r.derived()); \
+	} \
+	template <typename L> inline \
+	matrix4x4_binary<TAG, L, matrix4x4_term<typename L::value_type> > operator OP (const matrix4x4_expression<L>& l, const matrix4x4<typename L::value_type>& r) \
+	{ \
+		return matrix4x4_binary<TAG, L, matrix4x4_term<typename L::value_type> >(l.derived(), matrix4x4_term<typename L::value_type>(r)); \
+	} \
+	template <typename R> inline \
+	matrix4x4_binary<TAG, matrix4x4_term<typename R::value_type>, R> operator OP (const matrix4x4<typename R::value_type>& l, const matrix4x4_expression<R>& r) \
+	{ \
+		return matrix4x4_binary<TAG, matrix4x4_term<typename R::value_type>, R>(matrix4x4_term<typename R::value_type>(l), r.derived()); \
+	}
+#endif // __POCKET_MATH_EXPRESSION_OPERATOR
+
+__POCKET_MATH_EXPRESSION_OPERATOR(+, call::add_t)
+__POCKET_MATH_EXPRESSION_OPERATOR(-, call::sub_t)
+
+#undef __POCKET_MATH_EXPRESSION_OPERATOR
+
+template <typename L> inline
+matrix4x4_binary<call::mul_t, L, matrix4x4_scalar<typename L::value_type> > operator * (const matrix4x4_expression<L>& l, typename L::value_type f)
+{
+	return matrix4x4_binary<call::mul_t, L, matrix4x4_scalar<typename L::value_type> >(l.derived(), matrix4x4_scalar<typename L::value_type>(f));
+}
+template <typename R> inline
+matrix4x4_binary<call::mul_t, matrix4x4_scalar<typename R::value_type>, R> operator * (typename R::value_type f, const matrix4x4_expression<R>& r)
+{
+	return matrix4x4_binary<call::mul_t, matrix4x4_scalar<typename R::value_type>, R>(matrix4x4_scalar<typename R::value_type>(f), r.derived());
+}
+template <typename L> inline
+matrix4x4_binary<call::div_t, L, matrix4x4_scalar<typename L::value_type> > operator / (const matrix4x4_expression<L>& l, typename L::value_type f)
+{
+	return matrix4x4_binary<call::div_t, L, matrix4x4_scalar<typename L::value_type> >(l.derived(), matrix4x4_scalar<typename L::value_type>(f));
+}
+
+} // namespace math
+} // namespace pocket
+
+#endif // __POCKET_MATH_EXPRESSION_H__
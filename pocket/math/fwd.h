@@ -190,6 +190,20 @@ typedef ray<long double, vector3> ray3ld;
 typedef ray<long double, vector4> ray4ld;
 #endif // POCKET_USING_MATH_LONG_DOUBLE
 
+//------------------------------------------------------------------------------------------
+// batch_traits
+//------------------------------------------------------------------------------------------
+template <typename> struct batch_traits;
+#ifndef POCKET_NO_USING_MATH_INT_FLOAT
+typedef batch_traits<float> batch_traitsf;
+#endif // POCKET_NO_USING_MATH_INT_FLOAT
+#ifdef POCKET_USING_MATH_DOUBLE
+typedef batch_traits<double> batch_traitsd;
+#endif // POCKET_USING_MATH_DOUBLE
+#ifdef POCKET_USING_MATH_LONG_DOUBLE
+typedef batch_traits<long double> batch_traitsld;
+#endif // POCKET_USING_MATH_LONG_DOUBLE
+
 } // namespace math
 } // namespace pocket
 
@@ -15,6 +15,10 @@
 #include <cmath>
 #include <cfloat>
 #include <climits>
+#include <limits>
+#ifdef POCKET_USE_SIMD
+#include <xmmintrin.h>
+#endif // POCKET_USE_SIMD
 
 namespace pocket
 {
@@ -122,6 +126,30 @@ struct math_traits
 	// Constants
 	//-----------------------------------------------------------------------------------------
 
+#ifdef POCKET_USE_MATH_CONSTEXPR
+	static constexpr T zero = static_cast<T>(0.0L); // 0.0
+	static constexpr T half = static_cast<T>(0.5L); // 0.5
+	static constexpr T half_of_half = static_cast<T>(0.25L); // 0.25
+	static constexpr T one = static_cast<T>(1.0L); // 1.0
+	static constexpr T two = static_cast<T>(2.0L); // 2.0
+	static constexpr T three = static_cast<T>(3.0L); // 3.0
+	static constexpr T four = static_cast<T>(4.0L); // 4.0
+	static constexpr T half_angle = static_cast<T>(180.0L); // 180.0
+	static constexpr T infinity = std::numeric_limits<T>::infinity(); // #.INF
+	static constexpr T epsilon = std::numeric_limits<T>::epsilon(); // 1.0 + epsilon > 1.0 となる値
+	static constexpr T maximum = (std::numeric_limits<T>::max)(); // 最大値
+	static constexpr T minimum = (std::numeric_limits<T>::min)(); // 最小値
+
+	static constexpr T pi = static_cast<T>(3.141592654L); // 3.141592654
+	static constexpr T pi_x_two = pi * two; // pi * 2.0
+	static constexpr T one_div_pi = one / pi; // 1.0 / pi
+	static constexpr T one_div_pi_x_two = one / (pi * two); // 1.0 / (pi * 2.0)
+	static constexpr T pi_div_two = pi / two; // pi / 2.0
+	static constexpr T pi_div_four = pi / four; // pi / 4.0
+
+	static constexpr T rad2deg = half_angle / pi; // Radian -> Degree
+	static constexpr T deg2rad = pi / half_angle; // Degree -> Radian
+#else
 	static const T zero; // 0.0
 	static const T half; // 0.5
 	static const T half_of_half; // 0.25
@@ -144,6 +172,7 @@ struct math_traits
 	static const T one_div_pi_x_two; // 1.0 / (pi * 2.0)
 	static const T pi_div_two; // pi / 2.0
 	static const T pi_div_four; // pi / 4.0
+#endif // POCKET_USE_MATH_CONSTEXPR
 
 	//-----------------------------------------------------------------------------------------
 	// Constructors
@@ -237,12 +266,13 @@ struct math_traits
 	}
 	static inline void sin_cos(T deg, sin_cos_type& sc)
 	{
-		sc.sin = math_traits::sin(deg);
-		sc.cos = math_traits::cos(deg);
+		math_traits::sin_cos(deg, sc.sin, sc.cos);
 	}
 	static inline sin_cos_type sin_cos(T deg)
 	{
-		return sin_cos_type(math_traits::sin(deg), math_traits::cos(deg));
+		sin_cos_type sc(call::noinitialize);
+		math_traits::sin_cos(deg, sc.sin, sc.cos);
+		return sc;
 	}
 
 	//---------------------------------------------------------------------
@@ -281,6 +311,207 @@ struct math_traits
 		return (std::atan2(y, x) * math_traits::rad2deg);
 	}
 
+	//---------------------------------------------------------------------
+	// 近似計算
+	// 多項式近似で<cmath>より高速に求める
+	// 係数はfloatの精度に合わせているため, doubleで使用しても精度はfloatと同程度
+	// POCKET_USE_FAST_MATHを定義するとfloatのacos, atan2のみが置き換わる
+	// スカラーのsin_cosは範囲の切り詰めの分岐で<cmath>と同程度の速さにしかならないため置き換えない
+	// rsqrtは1.0/sqrtがsqrtss+divssで済むため, fast_rsqrtの方が遅くなるので置き換えない
+	// (bench/fast_math.cpp. 一括で求める場合はsimd_traits<float>::sin_cosが4～8倍速い)
+	//---------------------------------------------------------------------
+
+	//---------------------------------------------------------------------
+	// 角度からサイン、コサインを近似で求める
+	// 11次(sin), 10次(cos)のミニマックス多項式
+	// 最大誤差: 約1.0e-6 (|deg| <= 720, float)
+	// 角度が大きくなるほど範囲の切り詰めで精度が落ちる
+	// 周期数がintに収まらない角度(非数を含む)は<cmath>で求める
+	//---------------------------------------------------------------------
+	static inline void fast_sin_cos(T deg, T& s, T& c)
+	{
+		// -π ~ π の範囲へ切り詰め
+		T x = deg * math_traits::deg2rad;
+		T q = x * math_traits::one_div_pi_x_two;
+		if (!(q < static_cast<T>(1 << 30) && q > -static_cast<T>(1 << 30)))
+		{
+			s = std::sin(x);
+			c = std::cos(x);
+			return;
+		}
+		q = static_cast<T>(static_cast<int>(q + (q >= math_traits::zero ? math_traits::half : -math_traits::half)));
+		x -= math_traits::pi_x_two * q;
+
+		// -π/2 ~ π/2 の範囲へ折り返してコサインの符号を保持
+		T sign = math_traits::one;
+		if (x > math_traits::pi_div_two)
+		{
+			x = math_traits::pi - x;
+			sign = -math_traits::one;
+		}
+		else if (x < -math_traits::pi_div_two)
+		{
+			x = -math_traits::pi - x;
+			sign = -math_traits::one;
+		}
+
+		const T x2 = x * x;
+		s = (((((static_cast<T>(-2.3889859e-08) * x2 + static_cast<T>(2.7525562e-06)) * x2 +
+			static_cast<T>(-0.00019840874)) * x2 + static_cast<T>(0.0083333310)) * x2 +
+			static_cast<T>(-0.16666667)) * x2 + math_traits::one) * x;
+		c = (((((static_cast<T>(-2.6051615e-07) * x2 + static_cast<T>(2.4760495e-05)) * x2 +
+			static_cast<T>(-0.0013888378)) * x2 + static_cast<T>(0.041666638)) * x2 +
+			-math_traits::half) * x2 + math_traits::one) * sign;
+	}
+	static inline void fast_sin_cos(T deg, sin_cos_type& sc)
+	{
+		math_traits::fast_sin_cos(deg, sc.sin, sc.cos);
+	}
+	static inline sin_cos_type fast_sin_cos(T deg)
+	{
+		sin_cos_type sc(call::noinitialize);
+		math_traits::fast_sin_cos(deg, sc.sin, sc.cos);
+		return sc;
+	}
+	static inline T fast_sin(T deg)
+	{
+		T s, c;
+		math_traits::fast_sin_cos(deg, s, c);
+		return s;
+	}
+	static inline T fast_cos(T deg)
+	{
+		T s, c;
+		math_traits::fast_sin_cos(deg, s, c);
+		return c;
+	}
+
+	//---------------------------------------------------------------------
+	// 逆コサイン（角度）を近似で求める
+	// Abramowitz and Stegun 4.4.46
+	// 最大誤差: 2.0e-8ラジアン. floatでは丸めを含めて約2.0e-5度
+	//---------------------------------------------------------------------
+	static inline T fast_acos(T x)
+	{
+		const T ax = math_traits::min(math_traits::abs(x), math_traits::one);
+		T r = ((((((static_cast<T>(-0.0012624911) * ax + static_cast<T>(0.0066700901)) * ax +
+			static_cast<T>(-0.0170881256)) * ax + static_cast<T>(0.0308918810)) * ax +
+			static_cast<T>(-0.0501743046)) * ax + static_cast<T>(0.0889789874)) * ax +
+			static_cast<T>(-0.2145988016)) * ax + static_cast<T>(1.5707963050);
+		r *= math_traits::sqrt(math_traits::one - ax);
+		if (x < math_traits::zero)
+		{
+			r = math_traits::pi - r;
+		}
+		return (r * math_traits::rad2deg);
+	}
+
+	//---------------------------------------------------------------------
+	// 逆タンジェント（角度）を近似で求める
+	// 0 ~ 1 の範囲へ切り詰めて11次の多項式
+	// 最大誤差: 約2.0e-6ラジアン (約1.2e-4度)
+	//---------------------------------------------------------------------
+	static inline T fast_atan2(T y, T x)
+	{
+		const T ax = math_traits::abs(x);
+		const T ay = math_traits::abs(y);
+		const T mx = math_traits::max(ax, ay);
+		if (mx == math_traits::zero)
+		{
+			return math_traits::zero;
+		}
+		const T a = math_traits::min(ax, ay) / mx;
+		const T a2 = a * a;
+		T r = (((((static_cast<T>(-0.01172120) * a2 + static_cast<T>(0.05265332)) * a2 +
+			static_cast<T>(-0.11643287)) * a2 + static_cast<T>(0.19354346)) * a2 +
+			static_cast<T>(-0.33262347)) * a2 + static_cast<T>(0.99997726)) * a;
+		// 象限の補正
+		if (ay > ax)
+		{
+			r = math_traits::pi_div_two - r;
+		}
+		if (x < math_traits::zero)
+		{
+			r = math_traits::pi - r;
+		}
+		if (y < math_traits::zero)
+		{
+			r = -r;
+		}
+		return (r * math_traits::rad2deg);
+	}
+
+	//---------------------------------------------------------------------
+	// 逆平方根を近似で求める
+	// floatでSIMDが使用できる場合は_mm_rsqrt_ss + ニュートン法1回
+	// 最大相対誤差: 約2.5e-7
+	//---------------------------------------------------------------------
+	static inline T fast_rsqrt(T x)
+	{
+		return math_traits::one / math_traits::sqrt(x);
+	}
+
+	//---------------------------------------------------------------------
+	// コンパイル時に平方根を求める(ニュートン法)
+	// C++14ではconstexpr, それ以外では通常の関数として動作する
+	//---------------------------------------------------------------------
+	static POCKET_CXX14_CONSTEXPR T const_sqrt(T x)
+	{
+		if (x <= math_traits::zero)
+		{
+			return math_traits::zero;
+		}
+		// 上から単調に収束するので値が減らなくなったところで打ち切る
+		T y = x > math_traits::one ? x : math_traits::one;
+		for (;;)
+		{
+			const T n = (y + x / y) / math_traits::two;
+			if (n >= y)
+			{
+				break;
+			}
+			y = n;
+		}
+		return y;
+	}
+
+	//---------------------------------------------------------------------
+	// コンパイル時にsin, cos, tanを求める(テイラー展開, 度数法)
+	//---------------------------------------------------------------------
+	static POCKET_CXX14_CONSTEXPR T const_sin(T deg)
+	{
+		// 内部はlong doubleで計算して[-pi, pi]へ範囲を縮めてから展開する
+		const long double pi = 3.14159265358979323846L;
+		long double x = static_cast<long double>(deg) * (pi / 180.0L);
+		const long double n = static_cast<long double>(static_cast<long long>(x / (pi * 2.0L)));
+		x -= n * (pi * 2.0L);
+		if (x > pi)
+		{
+			x -= pi * 2.0L;
+		}
+		else if (x < -pi)
+		{
+			x += pi * 2.0L;
+		}
+		const long double x2 = x * x;
+		long double term = x;
+		long double r = x;
+		for (int i = 1; i <= 12; ++i)
+		{
+			term *= -x2 / static_cast<long double>((2 * i) * (2 * i + 1));
+			r += term;
+		}
+		return static_cast<T>(r);
+	}
+	static POCKET_CXX14_CONSTEXPR T const_cos(T deg)
+	{
+		return math_traits::const_sin(deg + static_cast<T>(90));
+	}
+	static POCKET_CXX14_CONSTEXPR T const_tan(T deg)
+	{
+		return math_traits::const_sin(deg) / math_traits::const_cos(deg);
+	}
+
 	//---------------------------------------------------------------------
 	// 値の四捨五入を求める
 	//---------------------------------------------------------------------
@@ -869,8 +1100,81 @@ int& math_traits<int>::remainder_assign(int& x, int y)
 	x %= y;
 	return x;
 }
+
+#ifdef POCKET_USE_SIMD
+//---------------------------------------------------------------------
+// float特有の挙動
+//---------------------------------------------------------------------
+template <> inline
+float math_traits<float>::fast_rsqrt(float x)
+{
+	// 近似値(相対誤差 1.5*2^-12)からニュートン法で精度を上げる
+	// y * 0.5 * (3.0 - x * y * y)
+	const float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	return (y * math_traits<float>::half) * (math_traits<float>::three - x * y * y);
+}
+#endif // POCKET_USE_SIMD
+
+#ifdef POCKET_USE_FAST_MATH
+//---------------------------------------------------------------------
+// floatは近似計算に置き換える
+// doubleなどは精度が落ちるため置き換えない
+//---------------------------------------------------------------------
+template <> inline
+float math_traits<float>::acos(float x)
+{
+	return math_traits<float>::fast_acos(x);
+}
+template <> inline
+float math_traits<float>::atan2(float y, float x)
+{
+	return math_traits<float>::fast_atan2(y, x);
+}
+#endif // POCKET_USE_FAST_MATH
 #endif // POCKET_NO_USING_MATH_INT_FLOAT
 
+#ifdef POCKET_USE_MATH_CONSTEXPR
+template <typename T>
+constexpr T math_traits<T>::zero;
+template <typename T>
+constexpr T math_traits<T>::half;
+template <typename T>
+constexpr T math_traits<T>::half_of_half;
+template <typename T>
+constexpr T math_traits<T>::one;
+template <typename T>
+constexpr T math_traits<T>::two;
+template <typename T>
+constexpr T math_traits<T>::three;
+template <typename T>
+constexpr T math_traits<T>::four;
+template <typename T>
+constexpr T math_traits<T>::half_angle;
+template <typename T>
+constexpr T math_traits<T>::infinity;
+template <typename T>
+constexpr T math_traits<T>::epsilon;
+template <typename T>
+constexpr T math_traits<T>::maximum;
+template <typename T>
+constexpr T math_traits<T>::minimum;
+template <typename T>
+constexpr T math_traits<T>::rad2deg;
+template <typename T>
+constexpr T math_traits<T>::deg2rad;
+template <typename T>
+constexpr T math_traits<T>::pi;
+template <typename T>
+constexpr T math_traits<T>::pi_x_two;
+template <typename T>
+constexpr T math_traits<T>::one_div_pi;
+template <typename T>
+constexpr T math_traits<T>::one_div_pi_x_two;
+template <typename T>
+constexpr T math_traits<T>::pi_div_two;
+template <typename T>
+constexpr T math_traits<T>::pi_div_four;
+#else
 #ifndef POCKET_NO_USING_MATH_INT_FLOAT
 template <> const int math_traits<int>::zero = 0;
 template <> const int math_traits<int>::half = 0;
@@ -944,6 +1248,7 @@ template <typename T>
 const T math_traits<T>::rad2deg = math_traits<T>::half_angle / math_traits<T>::pi;
 template <typename T>
 const T math_traits<T>::deg2rad = math_traits<T>::pi / math_traits<T>::half_angle;
+#endif // POCKET_USE_MATH_CONSTEXPR
 
 namespace detail
 {
@@ -168,24 +168,47 @@ struct matrix3x3
 	POCKET_DEFAULT_CONSTRUCTOR(matrix3x3);
 	explicit matrix3x3(const call::noinitialize_t&)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit matrix3x3(const call::zero_t&)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(call::zero), mv1(call::zero), mv2(call::zero)
+#endif // POCKET_USE_MATH_CONSTEXPR
 	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
 		M[0] = row_type::zero;
 		M[1] = row_type::zero;
 		M[2] = row_type::zero;
+#endif // POCKET_USE_MATH_CONSTEXPR
 	}
+	POCKET_MATH_CONSTEXPR
 	explicit matrix3x3(const call::identity_t&)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(math_type::one, math_type::zero, math_type::zero),
+		mv1(math_type::zero, math_type::one, math_type::zero),
+		mv2(math_type::zero, math_type::zero, math_type::one)
+#endif // POCKET_USE_MATH_CONSTEXPR
 	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
 		M[0] = row_type::unit_x;
 		M[1] = row_type::unit_y;
 		M[2] = row_type::unit_z;
+#endif // POCKET_USE_MATH_CONSTEXPR
 	}
+	POCKET_MATH_CONSTEXPR
 	explicit matrix3x3(T t)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(t, math_type::zero, math_type::zero),
+		mv1(math_type::zero, t, math_type::zero),
+		mv2(math_type::zero, math_type::zero, t)
+#endif // POCKET_USE_MATH_CONSTEXPR
 	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
 		M[0] = row_type(t, math_type::zero, math_type::zero);
 		M[1] = row_type(math_type::zero, t, math_type::zero);
 		M[2] = row_type(math_type::zero, math_type::zero, t);
+#endif // POCKET_USE_MATH_CONSTEXPR
 	}
+	POCKET_MATH_CONSTEXPR
 	matrix3x3(T M11, T M12, T M13,
 		T M21, T M22, T M23,
 		T M31, T M32, T M33)
@@ -199,6 +222,7 @@ struct matrix3x3
 		M[2] = vector3<T>(M31, M32, M33);
 #endif // POCKET_USE_ANONYMOUS_NON_POD
 	}
+	POCKET_MATH_CONSTEXPR
 	matrix3x3(const vector3<T>& M1, const vector3<T>& M2, const vector3<T>& M3)
 #ifdef POCKET_USE_ANONYMOUS_NON_POD
 		: mv0(M1), mv1(M2), mv2(M3)
@@ -774,6 +798,21 @@ struct matrix3x3
 			v0.z, v1.z, v2.z);
 	}
 
+	//---------------------------------------------------------------------
+	// 4x4行列から法線変換行列を求める
+	// 左上3x3の余因子行列(逆転置行列 * 行列式)を外積で求め, 割り算を行わない
+	// 行列式が負の場合は向きを保つため符号を反転する
+	// exactがtrueの場合のみ行列式で割り, 正確な逆転置行列にする(行列式が各行の長さの積に対して0に近い場合は割らない)
+	// シェーダーで正規化する場合はexactは不要
+	//---------------------------------------------------------------------
+	matrix3x3& normal_matrix_from(const matrix4x4<T>& m, bool exact = false); // matrix4x4.h
+	//---------------------------------------------------------------------
+	// 回転と拡大縮小(非一様も可)のみの4x4行列から法線変換行列を求める
+	// 各行を長さの2乗で割るため, 余因子行列より少ない計算で正確な逆転置行列になる
+	// 回転と一様な拡大縮小のみで正規化を行う場合はmatrix3x3(m)をそのまま使用できる
+	//---------------------------------------------------------------------
+	matrix3x3& normal_matrix_from_orthogonal(const matrix4x4<T>& m); // matrix4x4.h
+
 	//---------------------------------------------------------------------
 	// ベクトル座標変換
 	//---------------------------------------------------------------------
@@ -1042,9 +1081,9 @@ struct matrix3x3
 };
 
 template <typename T>
-const matrix3x3<T> matrix3x3<T>::zero(math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR matrix3x3<T> matrix3x3<T>::zero(math_type::zero);
 template <typename T>
-const matrix3x3<T> matrix3x3<T>::identity(math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR matrix3x3<T> matrix3x3<T>::identity(math_type::one);
 
 //---------------------------------------------------------------------
 // vector2.transform
@@ -138,37 +138,71 @@ struct matrix4x4
 	POCKET_DEFAULT_CONSTRUCTOR(matrix4x4);
 	explicit matrix4x4(const call::noinitialize_t&)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit matrix4x4(const call::zero_t&)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(call::zero), mv1(call::zero), mv2(call::zero), mv3(call::zero)
+#endif // POCKET_USE_MATH_CONSTEXPR
 	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
 		M[0] = row_type::zero;
 		M[1] = row_type::zero;
 		M[2] = row_type::zero;
 		M[3] = row_type::zero;
+#endif // POCKET_USE_MATH_CONSTEXPR
 	}
+	POCKET_MATH_CONSTEXPR
 	explicit matrix4x4(const call::identity_t&)
-	{
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(math_type::one, math_type::zero, math_type::zero, math_type::zero),
+		mv1(math_type::zero, math_type::one, math_type::zero, math_type::zero),
+		mv2(math_type::zero, math_type::zero, math_type::one, math_type::zero),
+		mv3(math_type::zero, math_type::zero, math_type::zero, math_type::one)
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
 		M[0] = row_type::unit_x;
 		M[1] = row_type::unit_y;
 		M[2] = row_type::unit_z;
 		M[3] = row_type::unit_w;
+#endif // POCKET_USE_MATH_CONSTEXPR
 	}
+	POCKET_MATH_CONSTEXPR
 	explicit matrix4x4(T t)
-	{
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(t, math_type::zero, math_type::zero, math_type::zero),
+		mv1(math_type::zero, t, math_type::zero, math_type::zero),
+		mv2(math_type::zero, math_type::zero, t, math_type::zero),
+		mv3(math_type::zero, math_type::zero, math_type::zero, t)
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
 		M[0] = row_type(t, math_type::zero, math_type::zero, math_type::zero);
 		M[1] = row_type(math_type::zero, t, math_type::zero, math_type::zero);
 		M[2] = row_type(math_type::zero, math_type::zero, t, math_type::zero);
 		M[3] = row_type(math_type::zero, math_type::zero, math_type::zero, t);
+#endif // POCKET_USE_MATH_CONSTEXPR
 	}
+	POCKET_MATH_CONSTEXPR
 	matrix4x4(T M11, T M12, T M13, T M14,
 		T M21, T M22, T M23, T M24,
 		T M31, T M32, T M33, T M34,
 		T M41, T M42, T M43, T M44)
-	{
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(M11, M12, M13, M14),
+		mv1(M21, M22, M23, M24),
+		mv2(M31, M32, M33, M34),
+		mv3(M41, M42, M43, M44)
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
 		M[0] = row_type(M11, M12, M13, M14);
 		M[1] = row_type(M21, M22, M23, M24);
 		M[2] = row_type(M31, M32, M33, M34);
 		M[3] = row_type(M41, M42, M43, M44);
+#endif // POCKET_USE_MATH_CONSTEXPR
 	}
+	POCKET_MATH_CONSTEXPR
 	matrix4x4(const vector4<T>& M1, const vector4<T>& M2, const vector4<T>& M3, const vector4<T>& M4)
 #ifdef POCKET_USE_ANONYMOUS_NON_POD
 		: mv0(M1), mv1(M2), mv2(M3), mv3(M4)
@@ -181,6 +215,7 @@ struct matrix4x4
 		M[3] = M4;
 #endif // POCKET_USE_ANONYMOUS_NON_POD
 	}
+	POCKET_MATH_CONSTEXPR
 	explicit matrix4x4(const vector3<T>& M1, T M1W,
 		const vector3<T>& M2, T M2W,
 		const vector3<T>& M3, T M3W,
@@ -211,11 +246,96 @@ struct matrix4x4
 		M[3] = row_type::unit_w;
 #endif // POCKET_USE_ANONYMOUS_NON_POD
 	}
+	// POCKET_USE_MATH_CONSTEXPRが有効であればリテラルからコンパイル時に構築できる
+	// constexpr matrix4x4f proj(call::perspective_field_of_view, 60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+	POCKET_MATH_CONSTEXPR
+	matrix4x4(const call::perspective_field_of_view_t&, T fovy, T aspect, T n, T f)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(math_type::one / math_type::const_tan(fovy * math_type::half) / aspect, math_type::zero, math_type::zero, math_type::zero),
+		mv1(math_type::zero, math_type::one / math_type::const_tan(fovy * math_type::half), math_type::zero, math_type::zero),
+		mv2(math_type::zero, math_type::zero, (f + n) * (math_type::one / (f - n)), -math_type::one),
+		mv3(math_type::zero, math_type::zero, (math_type::two * f * n) * (math_type::one / (f - n)), math_type::zero)
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
+		load_perspective_field_of_view(fovy, aspect, n, f);
+#endif // POCKET_USE_MATH_CONSTEXPR
+	}
+	POCKET_MATH_CONSTEXPR
+	matrix4x4(const call::orthographics_t&, T left, T right, T top, T bottom, T n, T f)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: mv0(math_type::two * (math_type::one / (right - left)), math_type::zero, math_type::zero, math_type::zero),
+		mv1(math_type::zero, math_type::two * (math_type::one / (top - bottom)), math_type::zero, math_type::zero),
+		mv2(math_type::zero, math_type::zero, -math_type::two * (math_type::one / (f - n)), math_type::zero), // 右手特有
+		mv3(-(right + left) * (math_type::one / (right - left)),
+			-(bottom + top) * (math_type::one / (top - bottom)),
+			-(f + n) * (math_type::one / (f - n)),
+			math_type::one)
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
+		load_orthographics(left, right, top, bottom, n, f);
+#endif // POCKET_USE_MATH_CONSTEXPR
+	}
+	POCKET_MATH_CONSTEXPR
+	matrix4x4(const call::orthographics_t&, T width, T height, T n, T f)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: matrix4x4(call::orthographics, math_type::zero, width, math_type::zero, height, n, f)
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
+		load_orthographics(width, height, n, f);
+#endif // POCKET_USE_MATH_CONSTEXPR
+	}
+	POCKET_MATH_CONSTEXPR
+	matrix4x4(const call::look_to_t&, const vector3<T>& eye, const vector3<T>& direction, const vector3<T>& up)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: matrix4x4(make_lookto(eye, direction, up))
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
+		load_lookto(eye, direction, up);
+#endif // POCKET_USE_MATH_CONSTEXPR
+	}
+	POCKET_MATH_CONSTEXPR
+	matrix4x4(const call::look_at_t&, const vector3<T>& eye, const vector3<T>& center, const vector3<T>& up)
+#ifdef POCKET_USE_MATH_CONSTEXPR
+		: matrix4x4(make_lookat(eye, center, up))
+#endif // POCKET_USE_MATH_CONSTEXPR
+	{
+#ifndef POCKET_USE_MATH_CONSTEXPR
+		load_lookat(eye, center, up);
+#endif // POCKET_USE_MATH_CONSTEXPR
+	}
 
 	//-----------------------------------------------------------------------------------------
 	// Functions
 	//-----------------------------------------------------------------------------------------
 
+#ifdef POCKET_USE_MATH_CONSTEXPR
+	//---------------------------------------------------------------------
+	// コンパイル時に視野変換行列を求める(load_lookto, load_lookat参照)
+	//---------------------------------------------------------------------
+	static constexpr matrix4x4 make_lookto(const vector3<T>& eye, const vector3<T>& direction, const vector3<T>& up)
+	{
+		const vector3<T> c = up.cross(direction);
+		const T cl = math_type::one / math_type::const_sqrt(c.dot(c));
+		const vector3<T> x(c.x * cl, c.y * cl, c.z * cl);
+		const vector3<T> y = direction.cross(x);
+		return matrix4x4(row_type(x.x, y.x, direction.x, math_type::zero),
+			row_type(x.y, y.y, direction.y, math_type::zero),
+			row_type(x.z, y.z, direction.z, math_type::zero),
+			row_type(-eye.dot(x), -eye.dot(y), -eye.dot(direction), math_type::one));
+	}
+	static constexpr matrix4x4 make_lookat(const vector3<T>& eye, const vector3<T>& center, const vector3<T>& up)
+	{
+		// 注視点から視点への向き
+		const vector3<T> d(eye.x - center.x, eye.y - center.y, eye.z - center.z);
+		const T dl = math_type::one / math_type::const_sqrt(d.dot(d));
+		return make_lookto(eye, vector3<T>(d.x * dl, d.y * dl, d.z * dl), up);
+	}
+#endif // POCKET_USE_MATH_CONSTEXPR
+
 	template <typename FUNC>
 	matrix4x4& each_calc_line(const matrix4x4& m, matrix4x4& result, FUNC func) const
 	{
@@ -1738,9 +1858,9 @@ struct matrix4x4
 };
 
 template <typename T>
-const matrix4x4<T> matrix4x4<T>::zero(math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR matrix4x4<T> matrix4x4<T>::zero(math_type::zero);
 template <typename T>
-const matrix4x4<T> matrix4x4<T>::identity(math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR matrix4x4<T> matrix4x4<T>::identity(math_type::one);
 
 //---------------------------------------------------------------------
 // vector3.transform
@@ -1903,6 +2023,50 @@ matrix3x3<T>::matrix3x3(const matrix4x4<T>& m)
 	M[1] = m[1];
 	M[2] = m[2];
 }
+// 4x4行列から法線変換行列を求める
+template <typename T> inline
+matrix3x3<T>& matrix3x3<T>::normal_matrix_from(const matrix4x4<T>& m, bool exact)
+{
+	const vector3<T> r0(m.M[0].x, m.M[0].y, m.M[0].z);
+	const vector3<T> r1(m.M[1].x, m.M[1].y, m.M[1].z);
+	const vector3<T> r2(m.M[2].x, m.M[2].y, m.M[2].z);
+
+	// 余因子行列の各行
+	r1.cross(r2, M[0]);
+	r2.cross(r0, M[1]);
+	r0.cross(r1, M[2]);
+
+	const T det = r0.dot(M[0]);
+	// 行列式の大きさは各行の長さの積以下(アダマールの不等式)なので, その積との比で0に近いかを判定する
+	// 一様に小さく拡大縮小した行列でも割ることができる
+	if (exact && math_type::abs(det) > math_type::epsilon * r0.length() * r1.length() * r2.length())
+	{
+		const T r = math_type::reciprocal(det);
+		M[0] *= r;
+		M[1] *= r;
+		M[2] *= r;
+	}
+	else if (det < math_type::zero)
+	{
+		M[0] = -M[0];
+		M[1] = -M[1];
+		M[2] = -M[2];
+	}
+	return *this;
+}
+// 回転と拡大縮小のみの4x4行列から法線変換行列を求める
+template <typename T> inline
+matrix3x3<T>& matrix3x3<T>::normal_matrix_from_orthogonal(const matrix4x4<T>& m)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		const row_type r(m.M[i].x, m.M[i].y, m.M[i].z);
+		const T len = r.length_sq();
+		// 長さが0の行はそのまま
+		M[i] = len > math_type::zero ? r * math_type::reciprocal(len) : r;
+	}
+	return *this;
+}
 
 template <typename CharT, typename CharTraits, typename T> inline
 std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, CharTraits>& os, const matrix4x4<T>& v)
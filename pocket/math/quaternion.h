@@ -92,17 +92,21 @@ struct quaternion
 	POCKET_DEFAULT_CONSTRUCTOR(quaternion);
 	explicit quaternion(const call::noinitialize_t&)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit quaternion(const call::zero_t&) :
 		x(math_type::zero), y(math_type::zero), z(math_type::zero),
 		w(math_type::zero)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit quaternion(const call::identity_t&) :
 		x(math_type::zero), y(math_type::zero), z(math_type::zero),
 		w(math_type::one)
 	{}
+	POCKET_MATH_CONSTEXPR
 	quaternion(T x, T y, T z, T w) :
 		x(x), y(y), z(z), w(w)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit quaternion(T f) :
 		x(f), y(f), z(f), w(f)
 	{}
@@ -868,9 +872,9 @@ struct quaternion
 };
 
 template <typename T>
-const quaternion<T> quaternion<T>::zero(math_type::zero, math_type::zero, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR quaternion<T> quaternion<T>::zero(math_type::zero, math_type::zero, math_type::zero, math_type::zero);
 template <typename T>
-const quaternion<T> quaternion<T>::identity(math_type::zero, math_type::zero, math_type::zero, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR quaternion<T> quaternion<T>::identity(math_type::zero, math_type::zero, math_type::zero, math_type::one);
 #ifndef POCKET_NO_USING_MATH_INT_FLOAT
 template <> const float quaternion<float>::error_slerp_value = 0.001f;
 #endif // POCKET_NO_USING_MATH_INT_FLOAT
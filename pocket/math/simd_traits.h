@@ -381,6 +381,16 @@ struct simd_traits
 		};
 		return result;
 	}
+	static POCKET_INLINE_FORCE type rsqrt_newton(type_const_reference mm)
+	{
+		type result = {
+			math_type::fast_rsqrt(mm.mm[0]),
+			math_type::fast_rsqrt(mm.mm[1]),
+			math_type::fast_rsqrt(mm.mm[2]),
+			math_type::fast_rsqrt(mm.mm[3])
+		};
+		return result;
+	}
 
 	//---------------------------------------------------------------------
 	// 指定の部分を取得
@@ -757,6 +767,18 @@ struct simd_traits
 		return result;
 	}
 
+	//---------------------------------------------------------------------
+	// 角度からサイン、コサインを求める
+	// 要素ごとの計算では近似の方が速くならないため<cmath>を使用する
+	//---------------------------------------------------------------------
+	static POCKET_INLINE_FORCE void sin_cos(type_const_reference deg, type_reference s, type_reference c)
+	{
+		math_type::sin_cos(deg.mm[0], s.mm[0], c.mm[0]);
+		math_type::sin_cos(deg.mm[1], s.mm[1], c.mm[1]);
+		math_type::sin_cos(deg.mm[2], s.mm[2], c.mm[2]);
+		math_type::sin_cos(deg.mm[3], s.mm[3], c.mm[3]);
+	}
+
 	//---------------------------------------------------------------------------------------
 	// Operators
 	//---------------------------------------------------------------------------------------
@@ -807,7 +829,7 @@ std::basic_ostream<CharT, CharTraits>& operator << (std::basic_ostream<CharT, Ch
 
 #ifdef POCKET_USE_SIMD // ファイル終端まで
 
-#if (POCKET_USE_SIMD_TYPE == POCKET_SIMD_TYPE_AVX2) || (POCKET_USE_SIMD_TYPE == POCKET_SIMD_TYPE_AVX)
+#if (POCKET_USE_SIMD_TYPE >= POCKET_SIMD_TYPE_AVX) || defined(POCKET_USE_SIMD_DISPATCH)
 #include <immintrin.h>
 #elif POCKET_USE_SIMD_TYPE == POCKET_SIMD_TYPE_SSE4_2
 #include <nmmintrin.h>
@@ -978,7 +1000,12 @@ struct simd_traits<float>
 	}
 	static POCKET_INLINE_FORCE type mad(type mm1, type mm2, type mm3)
 	{
+#ifdef POCKET_USE_SIMD_FMA
+		// 丸めが一度になるので分けて計算した場合と結果が僅かに異なる
+		return _mm_fmadd_ps(mm1, mm2, mm3);
+#else
 		return _mm_add_ps(_mm_mul_ps(mm1, mm2), mm3);
+#endif // POCKET_USE_SIMD_FMA
 	}
 	static POCKET_INLINE_FORCE type div(type mm1, type mm2)
 	{
@@ -1037,6 +1064,26 @@ struct simd_traits<float>
 	{
 		return _mm_rcp_ps(mm);
 	}
+	static POCKET_INLINE_FORCE type rsqrt_newton(type mm)
+	{
+		// _mm_rsqrt_psの近似値(相対誤差 1.5*2^-12)からニュートン法1回で精度を上げる
+		// y * 0.5 * (3.0 - x * y * y)
+		const type h = _mm_set_ps1(math_type::half);
+		const type t = _mm_set_ps1(math_type::three);
+		type y = _mm_rsqrt_ps(mm);
+		type xyy = _mm_mul_ps(_mm_mul_ps(mm, y), y);
+		return _mm_mul_ps(_mm_mul_ps(h, y), _mm_sub_ps(t, xyy));
+	}
+#ifdef POCKET_USE_SIMD_256
+	static POCKET_INLINE_FORCE type_up rsqrt_newton(type_up mm)
+	{
+		const type_up h = _mm256_set1_ps(math_type::half);
+		const type_up t = _mm256_set1_ps(math_type::three);
+		type_up y = _mm256_rsqrt_ps(mm);
+		type_up xyy = _mm256_mul_ps(_mm256_mul_ps(mm, y), y);
+		return _mm256_mul_ps(_mm256_mul_ps(h, y), _mm256_sub_ps(t, xyy));
+	}
+#endif // POCKET_USE_SIMD_256
 
 	//---------------------------------------------------------------------
 	// 指定要素を取得
@@ -1316,7 +1363,7 @@ struct simd_traits<float>
 	static POCKET_INLINE_FORCE type dot3(type mm1, type mm2)
 	{
 #if POCKET_USE_SIMD_TYPE >= POCKET_SIMD_TYPE_SSE4_1
-		return _mm_dp_ps(mm1, mm2, 0x3F);
+		return _mm_dp_ps(mm1, mm2, 0x7F);
 #else
 		// X*X, Y*Y, Z*Z, W*W
 		type r = _mm_mul_ps(mm1, mm2);
@@ -1354,6 +1401,73 @@ struct simd_traits<float>
 		return _mm_add_ps(_mm_mul_ps(from, ft), _mm_mul_ps(to, f));
 	}
 
+	//---------------------------------------------------------------------
+	// 角度からサイン、コサインを近似で求める
+	// math_traits::fast_sin_cosと同じ多項式を4要素(256bitが使用できる場合は8要素)同時に計算
+	//---------------------------------------------------------------------
+	static POCKET_INLINE_FORCE void sin_cos(type deg, type& s, type& c)
+	{
+		const type sign_mask = _mm_set_ps1(-0.0f);
+
+		// -π ~ π の範囲へ切り詰め
+		// 既定の丸めモード(最近接偶数)で整数へ変換
+		type x = _mm_mul_ps(deg, _mm_set_ps1(math_type::deg2rad));
+		type q = to_f(to_i(_mm_mul_ps(x, _mm_set_ps1(math_type::one_div_pi_x_two))));
+		x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set_ps1(math_type::pi_x_two)));
+
+		// -π/2 ~ π/2 の範囲へ折り返し(±π - x)
+		type pi = _mm_or_ps(_mm_set_ps1(math_type::pi), _mm_and_ps(x, sign_mask));
+		type over = _mm_cmpgt_ps(_mm_andnot_ps(sign_mask, x), _mm_set_ps1(math_type::pi_div_two));
+		x = select(x, _mm_sub_ps(pi, x), over);
+		// 折り返した要素はコサインの符号を反転
+		type sign = _mm_or_ps(_mm_set_ps1(math_type::one), _mm_and_ps(over, sign_mask));
+
+		const type x2 = _mm_mul_ps(x, x);
+		type p = mad(_mm_set_ps1(-2.3889859e-08f), x2, _mm_set_ps1(2.7525562e-06f));
+		p = mad(p, x2, _mm_set_ps1(-0.00019840874f));
+		p = mad(p, x2, _mm_set_ps1(0.0083333310f));
+		p = mad(p, x2, _mm_set_ps1(-0.16666667f));
+		p = mad(p, x2, _mm_set_ps1(math_type::one));
+		s = _mm_mul_ps(p, x);
+
+		p = mad(_mm_set_ps1(-2.6051615e-07f), x2, _mm_set_ps1(2.4760495e-05f));
+		p = mad(p, x2, _mm_set_ps1(-0.0013888378f));
+		p = mad(p, x2, _mm_set_ps1(0.041666638f));
+		p = mad(p, x2, _mm_set_ps1(-math_type::half));
+		p = mad(p, x2, _mm_set_ps1(math_type::one));
+		c = _mm_mul_ps(p, sign);
+	}
+#ifdef POCKET_USE_SIMD_256
+	static POCKET_INLINE_FORCE void sin_cos(type_up deg, type_up& s, type_up& c)
+	{
+		const type_up sign_mask = _mm256_set1_ps(-0.0f);
+
+		type_up x = _mm256_mul_ps(deg, _mm256_set1_ps(math_type::deg2rad));
+		type_up q = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(math_type::one_div_pi_x_two)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		x = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(math_type::pi_x_two)));
+
+		type_up pi = _mm256_or_ps(_mm256_set1_ps(math_type::pi), _mm256_and_ps(x, sign_mask));
+		type_up over = _mm256_cmp_ps(_mm256_andnot_ps(sign_mask, x), _mm256_set1_ps(math_type::pi_div_two), _CMP_GT_OQ);
+		x = _mm256_blendv_ps(x, _mm256_sub_ps(pi, x), over);
+		type_up sign = _mm256_or_ps(_mm256_set1_ps(math_type::one), _mm256_and_ps(over, sign_mask));
+
+		const type_up x2 = _mm256_mul_ps(x, x);
+		type_up p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-2.3889859e-08f), x2), _mm256_set1_ps(2.7525562e-06f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(-0.00019840874f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(0.0083333310f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(-0.16666667f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(math_type::one));
+		s = _mm256_mul_ps(p, x);
+
+		p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-2.6051615e-07f), x2), _mm256_set1_ps(2.4760495e-05f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(-0.0013888378f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(0.041666638f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(-math_type::half));
+		p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(math_type::one));
+		c = _mm256_mul_ps(p, sign);
+	}
+#endif // POCKET_USE_SIMD_256
+
 	//---------------------------------------------------------------------------------------
 	// Operators
 	//---------------------------------------------------------------------------------------
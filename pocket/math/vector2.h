@@ -100,18 +100,23 @@ struct vector2
 	POCKET_DEFAULT_CONSTRUCTOR(vector2);
 	explicit vector2(const call::noinitialize_t&)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector2(const call::zero_t&) :
 		x(math_type::zero), y(math_type::zero)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector2(const call::one_t&) :
 		x(math_type::one), y(math_type::one)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector2(const call::half_t&) :
 		x(math_type::half), y(math_type::half)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector2(const call::half_of_half_t&) :
 		x(math_type::half_of_half), y(math_type::half_of_half)
 	{}
+	POCKET_MATH_CONSTEXPR
 	vector2(T x, T y) :
 		x(x), y(y)
 	{}
@@ -119,17 +124,21 @@ struct vector2
 		POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U),
 		POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U1)
 	>
+	POCKET_MATH_CONSTEXPR
 	vector2(U x, U1 y) :
 		x(static_cast<T>(x)), y(static_cast<T>(y))
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector2(T f) :
 		x(f), y(f)
 	{}
 	template <typename U, POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U)>
+	POCKET_MATH_CONSTEXPR
 	explicit vector2(U f) :
 		x(static_cast<T>(f)), y(static_cast<T>(f))
 	{}
 	template <typename U>
+	POCKET_MATH_CONSTEXPR
 	vector2(const vector2<U>& v) :
 		x(static_cast<T>(v.x)), y(static_cast<T>(v.y))
 	{}
@@ -962,26 +971,26 @@ struct vector2
 };
 
 template <typename T>
-const vector2<T> vector2<T>::zero(math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::zero(math_type::zero, math_type::zero);
 template <typename T>
-const vector2<T> vector2<T>::one(math_type::one, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::one(math_type::one, math_type::one);
 template <typename T>
-const vector2<T> vector2<T>::unit_x(math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::unit_x(math_type::one, math_type::zero);
 template <typename T>
-const vector2<T> vector2<T>::unit_y(math_type::zero, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::unit_y(math_type::zero, math_type::one);
 template <typename T>
-const vector2<T> vector2<T>::up(math_type::zero, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::up(math_type::zero, math_type::one);
 template <typename T>
-const vector2<T> vector2<T>::down(math_type::zero, -math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::down(math_type::zero, -math_type::one);
 template <typename T>
-const vector2<T> vector2<T>::right(math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::right(math_type::one, math_type::zero);
 template <typename T>
-const vector2<T> vector2<T>::left(-math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::left(-math_type::one, math_type::zero);
 #if 0
 template <typename T>
-const vector2<T> vector2<T>::forward(math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::forward(math_type::zero, math_type::zero);
 template <typename T>
-const vector2<T> vector2<T>::backward(math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector2<T> vector2<T>::backward(math_type::zero, math_type::zero);
 #endif
 
 // 左辺が数値の場合の演算子
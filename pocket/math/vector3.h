@@ -109,6 +109,7 @@ struct vector3
 	POCKET_DEFAULT_CONSTRUCTOR(vector3);
 	explicit vector3(const call::noinitialize_t&)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector3(const call::zero_t&) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(math_type::zero), y(math_type::zero),
@@ -117,6 +118,7 @@ struct vector3
 #endif
 		z(math_type::zero)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector3(const call::one_t&) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(math_type::one), y(math_type::one),
@@ -125,6 +127,7 @@ struct vector3
 #endif
 		z(math_type::one)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector3(const call::half_t&) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(math_type::half), y(math_type::half),
@@ -133,6 +136,7 @@ struct vector3
 #endif
 		z(math_type::half)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector3(const call::half_of_half_t&) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(math_type::half_of_half), y(math_type::half_of_half),
@@ -142,6 +146,7 @@ struct vector3
 		z(math_type::half_of_half)
 	{}
 
+	POCKET_MATH_CONSTEXPR
 	vector3(T x, T y, T z) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(x), y(y),
@@ -155,6 +160,7 @@ struct vector3
 		POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U1),
 		POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U2)
 	>
+	POCKET_MATH_CONSTEXPR
 	vector3(U x, U1 y, U2 z) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(static_cast<T>(x)), y(static_cast<T>(y)),
@@ -163,6 +169,7 @@ struct vector3
 #endif
 		z(static_cast<T>(z))
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector3(T f) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(f), y(f),
@@ -172,6 +179,7 @@ struct vector3
 		z(f)
 	{}
 	template <typename U, POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U)>
+	POCKET_MATH_CONSTEXPR
 	explicit vector3(U f) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(static_cast<T>(f)), y(static_cast<T>(f)),
@@ -180,6 +188,7 @@ struct vector3
 #endif
 		z(static_cast<T>(f))
 	{}
+	POCKET_MATH_CONSTEXPR
 	vector3(const vector2<T>& v, T z) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(v.x), y(v.y),
@@ -189,6 +198,7 @@ struct vector3
 		z(z)
 	{}
 	template <typename U>
+	POCKET_MATH_CONSTEXPR
 	vector3(const vector2<U>& v, U z) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(static_cast<T>(v.x)), y(static_cast<T>(v.y)),
@@ -198,6 +208,7 @@ struct vector3
 		z(static_cast<T>(z))
 	{}
 	template <typename U>
+	POCKET_MATH_CONSTEXPR
 	vector3(const vector3<U>& v) :
 #ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
 		x(static_cast<T>(v.x)), y(static_cast<T>(v.y)),
@@ -381,6 +392,7 @@ struct vector3
 	//---------------------------------------------------------------------
 	// 内積を求める
 	//---------------------------------------------------------------------
+	POCKET_MATH_CONSTEXPR
 	T dot(const vector3& v) const
 	{
 		// |v1||v2|cos(θ)と同じになる
@@ -390,6 +402,7 @@ struct vector3
 	//---------------------------------------------------------------------
 	// 外積を求める
 	//---------------------------------------------------------------------
+	POCKET_MATH_CONSTEXPR
 	vector3 cross(const vector3& v) const
 	{
 		// 二つのベクトルに垂直なベクトルを求める
@@ -1180,27 +1193,27 @@ struct vector3
 };
 
 template <typename T>
-const vector3<T> vector3<T>::zero(math_type::zero, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::zero(math_type::zero, math_type::zero, math_type::zero);
 template <typename T>
-const vector3<T> vector3<T>::one(math_type::one, math_type::one, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::one(math_type::one, math_type::one, math_type::one);
 template <typename T>
-const vector3<T> vector3<T>::unit_x(math_type::one, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::unit_x(math_type::one, math_type::zero, math_type::zero);
 template <typename T>
-const vector3<T> vector3<T>::unit_y(math_type::zero, math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::unit_y(math_type::zero, math_type::one, math_type::zero);
 template <typename T>
-const vector3<T> vector3<T>::unit_z(math_type::zero, math_type::zero, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::unit_z(math_type::zero, math_type::zero, math_type::one);
 template <typename T>
-const vector3<T> vector3<T>::up(math_type::zero, math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::up(math_type::zero, math_type::one, math_type::zero);
 template <typename T>
-const vector3<T> vector3<T>::down(math_type::zero, -math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::down(math_type::zero, -math_type::one, math_type::zero);
 template <typename T>
-const vector3<T> vector3<T>::right(math_type::one, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::right(math_type::one, math_type::zero, math_type::zero);
 template <typename T>
-const vector3<T> vector3<T>::left(-math_type::one, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::left(-math_type::one, math_type::zero, math_type::zero);
 template <typename T>
-const vector3<T> vector3<T>::forward(math_type::zero, math_type::zero, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::forward(math_type::zero, math_type::zero, math_type::one);
 template <typename T>
-const vector3<T> vector3<T>::backward(math_type::zero, math_type::zero, -math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector3<T> vector3<T>::backward(math_type::zero, math_type::zero, -math_type::one);
 
 // 左辺が数値の場合の乗算演算子
 
@@ -128,8 +128,9 @@ struct vector4
 	POCKET_DEFAULT_CONSTRUCTOR(vector4);
 	explicit vector4(const call::noinitialize_t&)
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector4(const call::zero_t&) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::zero())
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -140,8 +141,9 @@ struct vector4
 		w(math_type::zero)
 #endif
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector4(const call::zero_t&, const call::direction_t&) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::zero())
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -168,8 +170,9 @@ struct vector4
 		w1();
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	}
+	POCKET_MATH_CONSTEXPR
 	explicit vector4(const call::one_t&) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::one())
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -196,8 +199,9 @@ struct vector4
 		w0();
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	}
+	POCKET_MATH_CONSTEXPR
 	explicit vector4(const call::one_t&, const call::position_t&) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::one())
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -273,8 +277,9 @@ struct vector4
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	}
 
+	POCKET_MATH_CONSTEXPR
 	vector4(T x, T y, T z, T w) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(x, y, z, w))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -291,8 +296,9 @@ struct vector4
 		POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U2),
 		POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U3)
 	>
+	POCKET_MATH_CONSTEXPR
 	vector4(U x, U1 y, U2 z, U3 w) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(static_cast<T>(x), static_cast<T>(y), static_cast<T>(z), static_cast<T>(w)))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -303,8 +309,9 @@ struct vector4
 		w(static_cast<T>(w))
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector4(T f, T w = math_type::one) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(f, f, f, w))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -316,8 +323,9 @@ struct vector4
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	{}
 	template <typename U, POCKET_TEMPLATE_TYPE_VALIDATE_ARITHMETIC(U)>
+	POCKET_MATH_CONSTEXPR
 	explicit vector4(U f, U w = math_traits<U>::one) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(static_cast<T>(f), static_cast<T>(f), static_cast<T>(f), w))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -328,8 +336,9 @@ struct vector4
 		w(static_cast<T>(w))
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	{}
+	POCKET_MATH_CONSTEXPR
 	vector4(const vector2<T>& v, T z, T w) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(v.x, v.y, z, w))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -341,8 +350,9 @@ struct vector4
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	{}
 	template <typename U>
+	POCKET_MATH_CONSTEXPR
 	vector4(const vector2<U>& v, U z, U w) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(static_cast<T>(v.x), static_cast<T>(v.y), static_cast<T>(z), static_cast<T>(w)))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -353,8 +363,9 @@ struct vector4
 		w(static_cast<T>(w))
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	{}
+	POCKET_MATH_CONSTEXPR
 	explicit vector4(const vector3<T>& v, T w) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(v.x, v.y, v.z, w))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -366,8 +377,9 @@ struct vector4
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	{}
 	template <typename U>
+	POCKET_MATH_CONSTEXPR
 	vector4(const vector3<U>& v, U w) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(static_cast<T>(v.x), static_cast<T>(v.y), static_cast<T>(v.z), static_cast<T>(w)))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -379,8 +391,9 @@ struct vector4
 #endif // POCKET_USE_SIMD_ANONYMOUS
 	{}
 	template <typename U>
+	POCKET_MATH_CONSTEXPR
 	vector4(const vector4<U>& v) :
-#ifdef POCKET_USE_SIMD_ANONYMOUS
+#if defined(POCKET_USE_SIMD_ANONYMOUS) && !defined(POCKET_USE_MATH_CONSTEXPR)
 		mm(simd::set(static_cast<T>(v.x), static_cast<T>(v.y), static_cast<T>(v.z), static_cast<T>(v.w)))
 #else
 #	ifdef POCKET_USE_ANONYMOUS_NORMAL_CONSTRUCT
@@ -1624,29 +1637,29 @@ struct vector4
 };
 
 template <typename T>
-const vector4<T> vector4<T>::zero(math_type::zero, math_type::zero, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::zero(math_type::zero, math_type::zero, math_type::zero, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::one(math_type::one, math_type::one, math_type::one, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::one(math_type::one, math_type::one, math_type::one, math_type::one);
 template <typename T>
-const vector4<T> vector4<T>::unit_x(math_type::one, math_type::zero, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::unit_x(math_type::one, math_type::zero, math_type::zero, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::unit_y(math_type::zero, math_type::one, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::unit_y(math_type::zero, math_type::one, math_type::zero, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::unit_z(math_type::zero, math_type::zero, math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::unit_z(math_type::zero, math_type::zero, math_type::one, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::unit_w(math_type::zero, math_type::zero, math_type::zero, math_type::one);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::unit_w(math_type::zero, math_type::zero, math_type::zero, math_type::one);
 template <typename T>
-const vector4<T> vector4<T>::up(math_type::zero, math_type::one, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::up(math_type::zero, math_type::one, math_type::zero, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::down(math_type::zero, -math_type::one, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::down(math_type::zero, -math_type::one, math_type::zero, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::right(math_type::one, math_type::zero, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::right(math_type::one, math_type::zero, math_type::zero, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::left(-math_type::one, math_type::zero, math_type::zero, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::left(-math_type::one, math_type::zero, math_type::zero, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::forward(math_type::zero, math_type::zero, math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::forward(math_type::zero, math_type::zero, math_type::one, math_type::zero);
 template <typename T>
-const vector4<T> vector4<T>::backward(math_type::zero, math_type::zero, -math_type::one, math_type::zero);
+POCKET_MATH_CONST_OR_CONSTEXPR vector4<T> vector4<T>::backward(math_type::zero, math_type::zero, -math_type::one, math_type::zero);
 
 // 左辺が数値の場合の演算子
 
@@ -7,7 +7,7 @@ layout (location=1) in vec4 vertex_color;
 // ouptut
 out vec4 color;
 
-uniform ublock
+layout (std140) uniform ublock
 {
 	mat4 world;
 	mat4 lookat;